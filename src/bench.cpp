@@ -0,0 +1,795 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <iterator>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <chrono>
+#include <random>
+#include <cmath>
+#include <cstdlib>
+#include <thread>
+#include <span>
+#include <numbers>
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include "parallel.hpp"
+#include "stream.hpp"
+#include "encoding_lossless.hpp"
+#include "encoding_lossy.hpp"
+#include "image.hpp"
+#include "dictionary.hpp"
+#include "pipeline.hpp"
+#include "dedup.hpp"
+
+// dc_bench : banc d'essai des codecs.
+// Chaque cas (suite, codec, paramètres, corpus, type, taille) est mesuré après échauffement
+// sur plusieurs répétitions : médiane et p99 des temps de codage / décodage, débits en Mo/s
+// (octets d'entrée / médiane) et taux (octets codés / octets d'entrée). Les corpus sont
+// synthétiques et déterministes (graines fixes) : deux builds codent les mêmes entrées et
+// leurs sorties CSV / JSON se comparent ligne à ligne.
+//
+// Usage : dc_bench [taille Mio] [nb max de threads] [fichier corpus] [options]
+//   --size=N      taille max des corpus en Mio (défaut 4) ; tailles : 64 Kio, 1 Mio, N Mio
+//   --threads=N   nb max de threads de la suite parallel (défaut : matériel)
+//   --corpus=F    fichier ajouté aux corpus d'octets
+//   --reps=N      répétitions mesurées (défaut 7), --warmup=N échauffements (défaut 1)
+//   --time=S      budget par mesure en secondes (défaut 2) : moins de répétitions au-delà
+//   --filter=T    ne garde que les cas dont « suite/codec » contient T
+//   --csv=F, --json=F   écrit les résultats (F = - : sortie standard)
+
+namespace {
+
+    using clock_type = std::chrono::steady_clock;
+
+    template<typename F>
+    double seconds(F&& f) {
+        const auto t0 = clock_type::now();
+        f();
+        return std::chrono::duration<double>(clock_type::now() - t0).count();
+    }
+
+    // ===== Options =====
+    struct options {
+        std::size_t max_mib     = 4;
+        std::size_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+        std::string corpus_file;
+        int         reps        = 7;
+        int         warmup      = 1;
+        double      budget      = 2.0;
+        std::string filter;
+        std::string csv, json;
+    };
+
+    options parse_options(int argc, char** argv) {
+        options opt;
+        int positional = 0;
+        for (int i = 1; i < argc; ++i) {
+            const std::string_view a = argv[i];
+            const auto value = [&](std::string_view key) -> const char* {
+                return a.starts_with(key) ? argv[i] + key.size() : nullptr;
+            };
+            if (auto v = value("--size="))         opt.max_mib = std::strtoull(v, nullptr, 10);
+            else if (auto v = value("--threads=")) opt.max_threads = std::strtoull(v, nullptr, 10);
+            else if (auto v = value("--corpus="))  opt.corpus_file = v;
+            else if (auto v = value("--reps="))    opt.reps = std::atoi(v);
+            else if (auto v = value("--warmup="))  opt.warmup = std::atoi(v);
+            else if (auto v = value("--time="))    opt.budget = std::atof(v);
+            else if (auto v = value("--filter="))  opt.filter = v;
+            else if (auto v = value("--csv="))     opt.csv = v;
+            else if (auto v = value("--json="))    opt.json = v;
+            else if (!a.starts_with("--")) {
+                // forme historique : dc_bench [taille] [threads] [corpus]
+                if (positional == 0)      opt.max_mib = std::strtoull(argv[i], nullptr, 10);
+                else if (positional == 1) opt.max_threads = std::strtoull(argv[i], nullptr, 10);
+                else                      opt.corpus_file = argv[i];
+                ++positional;
+            } else {
+                std::cerr << "option inconnue : " << a << "\n";
+            }
+        }
+        opt.max_mib     = std::max<std::size_t>(opt.max_mib, 1);
+        opt.max_threads = std::max<std::size_t>(opt.max_threads, 1);
+        opt.reps        = std::max(opt.reps, 1);
+        opt.warmup      = std::max(opt.warmup, 0);
+        return opt;
+    }
+
+    // ===== Corpus synthétiques (graines fixes) =====
+
+    // texte pseudo-aléatoire avec répétitions (LZ77, Huffman)
+    std::vector<unsigned char> make_text(std::size_t n) {
+        static const char* words[] = {"compression ", "bloc ", "symbole ", "fenetre ", "huffman ",
+                                      "lz77 ", "donnees ", "flux ", "table ", "code "};
+        std::mt19937 rng(42);
+        std::vector<unsigned char> v;
+        v.reserve(n);
+        while (v.size() < n) {
+            const char* w = words[rng() % 10];
+            while (*w && v.size() < n) v.push_back(static_cast<unsigned char>(*w++));
+        }
+        return v;
+    }
+
+    // octets uniformes (incompressibles)
+    template<typename D>
+    std::vector<D> make_random(std::size_t n) {
+        std::mt19937_64 rng(5);
+        std::vector<D> v(n);
+        for (auto& x : v) x = static_cast<D>(rng());
+        return v;
+    }
+
+    // sauvegardes successives : un quart de données uniques, puis des copies de régions
+    // lointaines (au-delà de la fenêtre LZ77) avec de rares octets modifiés et des insertions
+    std::vector<unsigned char> make_backup(std::size_t n) {
+        std::mt19937_64 rng(11);
+        std::vector<unsigned char> v(std::max<std::size_t>(n / 4, 1));
+        for (auto& x : v) x = static_cast<unsigned char>(rng());
+        const std::size_t base = v.size();
+        v.reserve(n);
+        while (v.size() < n) {
+            const std::size_t from = rng() % std::max<std::size_t>(base / 2, 1);
+            const std::size_t len = std::min<std::size_t>(n - v.size(), 65536 + rng() % 262144);
+            for (std::size_t i = 0; i < len; ++i)
+                v.push_back(rng() % 20000 == 0 ? static_cast<unsigned char>(rng()) : v[from + i]);
+            if (rng() % 3 == 0)
+                for (int i = 0; i < 512 && v.size() < n; ++i) v.push_back(static_cast<unsigned char>(rng()));
+        }
+        v.resize(n);
+        return v;
+    }
+
+    // valeurs majoritairement nulles (RLE)
+    std::vector<unsigned char> make_sparse(std::size_t n) {
+        std::mt19937 rng(7);
+        std::vector<unsigned char> v(n, 0);
+        for (auto& x : v) if (rng() % 16 == 0) x = static_cast<unsigned char>(rng());
+        return v;
+    }
+
+    // télémétrie 16 bits : paliers, plages de zéros et bruit de mesure
+    std::vector<std::int16_t> make_telemetry(std::size_t n) {
+        std::mt19937 rng(13);
+        std::vector<std::int16_t> v(n);
+        std::int16_t level = 0;
+        for (std::size_t i = 0; i < n; ) {
+            const std::size_t len = std::min<std::size_t>(n - i, 8 + rng() % 120);
+            const bool idle = rng() % 3 == 0;
+            if (!idle) level = static_cast<std::int16_t>(static_cast<int>(rng() % 2000) - 1000);
+            for (std::size_t k = 0; k < len; ++k, ++i)
+                v[i] = idle ? std::int16_t{0} : static_cast<std::int16_t>(level + static_cast<int>(rng() % 5) - 2);
+        }
+        return v;
+    }
+
+    // signal lisse (DCT, DFT, quantification)
+    template<typename T>
+    std::vector<T> make_signal(std::size_t n) {
+        std::vector<T> v(n);
+        for (std::size_t i = 0; i < n; ++i)
+            v[i] = static_cast<T>(100.0 * std::sin(0.01 * static_cast<double>(i)) + 20.0 * std::sin(0.13 * static_cast<double>(i)));
+        return v;
+    }
+
+    // image synthétique : dégradés, texture périodique et bruit
+    std::vector<std::uint8_t> make_image(std::size_t w, std::size_t h) {
+        std::mt19937 rng(11);
+        std::vector<std::uint8_t> px(w * h);
+        for (std::size_t y = 0; y < h; ++y)
+            for (std::size_t x = 0; x < w; ++x) {
+                const double v = 96.0 + 0.03 * static_cast<double>(x + y)
+                               + 40.0 * std::sin(0.05 * static_cast<double>(x)) * std::cos(0.03 * static_cast<double>(y))
+                               + static_cast<double>(rng() % 12);
+                px[y * w + x] = static_cast<std::uint8_t>(std::clamp(v, 0.0, 255.0));
+            }
+        return px;
+    }
+
+    // petits messages : enregistrements JSON de structure commune, tailles variées autour de size
+    std::vector<std::vector<unsigned char>> make_messages(std::size_t count, std::size_t size, unsigned seed) {
+        static const char* events[] = {"click", "scroll", "purchase", "login", "logout", "search"};
+        static const char* pages[]  = {"/articles/", "/produits/", "/panier/", "/compte/"};
+        std::mt19937 rng(seed);
+        std::vector<std::vector<unsigned char>> msgs(count);
+        for (auto& m : msgs) {
+            const std::size_t target = size / 2 + rng() % size;
+            std::string s = "[";
+            while (s.size() < target) {
+                s += "{\"user\": " + std::to_string(rng() % 100000) + ", \"event\": \"" + events[rng() % 6]
+                   + "\", \"page\": \"" + pages[rng() % 4] + std::to_string(rng() % 500)
+                   + "\", \"latency_ms\": " + std::to_string(rng() % 2000) + ", \"status\": \""
+                   + (rng() % 10 ? "ok" : "error") + "\"},";
+            }
+            s.back() = ']';
+            m.assign(s.begin(), s.end());
+        }
+        return msgs;
+    }
+
+    std::vector<unsigned char> read_file(const std::string& path) {
+        std::ifstream f(path, std::ios::binary);
+        return {std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>()};
+    }
+
+    template<typename D> constexpr const char* type_name() {
+        if constexpr (std::is_same_v<D, unsigned char>) return "u8";
+        else if constexpr (std::is_same_v<D, std::int16_t>) return "i16";
+        else if constexpr (std::is_same_v<D, float>) return "f32";
+        else return "f64";
+    }
+
+    std::string size_label(std::size_t bytes) {
+        if (bytes % (1u << 20) == 0) return std::to_string(bytes >> 20) + "M";
+        if (bytes % (1u << 10) == 0) return std::to_string(bytes >> 10) + "K";
+        return std::to_string(bytes);
+    }
+
+    // ===== Mesures =====
+    struct timing {
+        double median = 0.0;
+        double p99    = 0.0;
+        int    reps   = 0;
+    };
+
+    struct case_info {
+        std::string suite, codec, params, corpus, type;
+        std::size_t bytes = 0; // taille d'entrée
+    };
+
+    struct result {
+        case_info   info;
+        std::size_t packed  = 0;   // 0 : sans objet (transformées)
+        timing      enc, dec;
+        double      quality = std::numeric_limits<double>::quiet_NaN(); // PSNR / erreur max
+        bool        ok      = true;
+    };
+
+    class Harness {
+    private:
+        options             m_opt;
+        std::vector<result> m_results;
+
+        template<typename F>
+        timing measure(F&& f) const {
+            double spent = 0.0;
+            for (int w = 0; w < m_opt.warmup && spent < m_opt.budget / 4; ++w) spent += seconds(f);
+            std::vector<double> t;
+            spent = 0.0;
+            while (static_cast<int>(t.size()) < m_opt.reps && (t.empty() || spent < m_opt.budget)) {
+                t.push_back(seconds(f));
+                spent += t.back();
+            }
+            std::sort(t.begin(), t.end());
+            const std::size_t n = t.size();
+            timing r;
+            r.reps   = static_cast<int>(n);
+            r.median = n % 2 ? t[n / 2] : 0.5 * (t[n / 2 - 1] + t[n / 2]);
+            r.p99    = t[std::min(n - 1, static_cast<std::size_t>(std::ceil(0.99 * static_cast<double>(n))) - 1)];
+            return r;
+        }
+
+        static double mbps(std::size_t bytes, double s) { return s > 0.0 ? static_cast<double>(bytes) / 1e6 / s : 0.0; }
+
+        void print_row(const result& r) const {
+            const auto& i = r.info;
+            std::cout << std::left << std::setw(9) << i.suite << std::setw(14) << i.codec << std::setw(14) << i.params
+                      << std::setw(10) << i.corpus << std::setw(5) << i.type << std::right << std::setw(7) << size_label(i.bytes)
+                      << std::fixed << std::setprecision(1)
+                      << std::setw(10) << mbps(i.bytes, r.enc.median) << std::setw(10) << mbps(i.bytes, r.enc.p99)
+                      << std::setw(10) << mbps(i.bytes, r.dec.median) << std::setw(10) << mbps(i.bytes, r.dec.p99)
+                      << std::setprecision(3);
+            if (r.packed) std::cout << std::setw(8) << static_cast<double>(r.packed) / static_cast<double>(i.bytes);
+            else std::cout << std::setw(8) << "-";
+            std::cout << std::defaultfloat;
+            if (!std::isnan(r.quality)) std::cout << std::setw(10) << r.quality;
+            else std::cout << std::setw(10) << "-";
+            std::cout << (r.ok ? "" : "  ERREUR") << "\n";
+        }
+
+    public:
+        explicit Harness(options opt) : m_opt(std::move(opt)) {}
+
+        [[nodiscard]] const options& opt() const noexcept { return m_opt; }
+        [[nodiscard]] const std::vector<result>& results() const noexcept { return m_results; }
+
+        [[nodiscard]] bool selected(const case_info& c) const {
+            return m_opt.filter.empty() || (c.suite + "/" + c.codec).find(m_opt.filter) != std::string::npos;
+        }
+
+        static void print_header() {
+            std::cout << std::left << std::setw(9) << "suite" << std::setw(14) << "codec" << std::setw(14) << "params"
+                      << std::setw(10) << "corpus" << std::setw(5) << "type" << std::right << std::setw(7) << "size"
+                      << std::setw(10) << "enc MB/s" << std::setw(10) << "enc p99" << std::setw(10) << "dec MB/s"
+                      << std::setw(10) << "dec p99" << std::setw(8) << "ratio" << std::setw(10) << "quality" << "\n";
+        }
+
+        // enc() code et renvoie la taille codée en octets (0 si sans objet) ;
+        // dec() décode et renvoie false si le résultat est faux (nullptr : pas de décodage).
+        // quality() est appelée une fois après les mesures.
+        template<typename Enc, typename Dec = std::nullptr_t, typename Quality = std::nullptr_t>
+        void run(case_info info, Enc&& enc, Dec&& dec = nullptr, Quality&& quality = nullptr) {
+            if (!selected(info)) return;
+            result r;
+            r.info = std::move(info);
+            std::size_t packed = 0;
+            bool ok = true;
+            r.enc = measure([&]{ packed = enc(); });
+            if constexpr (!std::is_same_v<std::decay_t<Dec>, std::nullptr_t>) r.dec = measure([&]{ ok = dec(); });
+            r.packed = packed;
+            r.ok = ok;
+            if constexpr (!std::is_same_v<std::decay_t<Quality>, std::nullptr_t>) r.quality = quality();
+            print_row(r);
+            m_results.push_back(std::move(r));
+        }
+    };
+
+    // ===== Sorties CSV / JSON =====
+    std::string json_escape(const std::string& s) {
+        std::string r;
+        for (char c : s) {
+            if (c == '"' || c == '\\') r += '\\';
+            r += c;
+        }
+        return r;
+    }
+
+    void write_csv(std::ostream& os, const std::vector<result>& results) {
+        os << "suite,codec,params,corpus,type,bytes,packed,ratio,enc_median_s,enc_p99_s,dec_median_s,dec_p99_s,"
+              "enc_mbps,dec_mbps,reps,quality,ok\n";
+        os << std::setprecision(9);
+        for (auto& r : results) {
+            const auto& i = r.info;
+            const double b = static_cast<double>(i.bytes);
+            const auto mbps = [&](double t){ return t > 0.0 ? b / 1e6 / t : 0.0; };
+            os << i.suite << ',' << i.codec << ",\"" << i.params << "\"," << i.corpus << ',' << i.type << ','
+               << i.bytes << ',' << r.packed << ',' << (r.packed ? static_cast<double>(r.packed) / b : 0.0) << ','
+               << r.enc.median << ',' << r.enc.p99 << ',' << r.dec.median << ',' << r.dec.p99 << ','
+               << mbps(r.enc.median) << ',' << mbps(r.dec.median) << ',' << r.enc.reps << ',';
+            if (!std::isnan(r.quality)) os << r.quality;
+            os << ',' << (r.ok ? 1 : 0) << '\n';
+        }
+    }
+
+    void write_json(std::ostream& os, const std::vector<result>& results) {
+        os << "[\n" << std::setprecision(9);
+        for (std::size_t k = 0; k < results.size(); ++k) {
+            const auto& r = results[k];
+            const auto& i = r.info;
+            const double b = static_cast<double>(i.bytes);
+            const auto mbps = [&](double t){ return t > 0.0 ? b / 1e6 / t : 0.0; };
+            os << "  {\"suite\": \"" << json_escape(i.suite) << "\", \"codec\": \"" << json_escape(i.codec)
+               << "\", \"params\": \"" << json_escape(i.params) << "\", \"corpus\": \"" << json_escape(i.corpus)
+               << "\", \"type\": \"" << i.type << "\", \"bytes\": " << i.bytes << ", \"packed\": " << r.packed
+               << ", \"ratio\": " << (r.packed ? static_cast<double>(r.packed) / b : 0.0)
+               << ", \"enc\": {\"median_s\": " << r.enc.median << ", \"p99_s\": " << r.enc.p99
+               << ", \"mbps\": " << mbps(r.enc.median) << ", \"reps\": " << r.enc.reps << "}"
+               << ", \"dec\": {\"median_s\": " << r.dec.median << ", \"p99_s\": " << r.dec.p99
+               << ", \"mbps\": " << mbps(r.dec.median) << ", \"reps\": " << r.dec.reps << "}"
+               << ", \"quality\": ";
+            if (!std::isnan(r.quality)) os << r.quality; else os << "null";
+            os << ", \"ok\": " << (r.ok ? "true" : "false") << "}" << (k + 1 < results.size() ? "," : "") << "\n";
+        }
+        os << "]\n";
+    }
+
+    void write_to(const std::string& path, const std::vector<result>& results,
+                  void (*writer)(std::ostream&, const std::vector<result>&)) {
+        if (path.empty()) return;
+        if (path == "-") { writer(std::cout, results); return; }
+        std::ofstream f(path);
+        writer(f, results);
+        if (!f) std::cerr << "écriture impossible : " << path << "\n";
+    }
+
+    // ===== Suite lossless : Huffman, rANS, LZ77 (niveaux), RunLength, CompressRepeating =====
+    template<typename D>
+    void lossless_suite(Harness& h, const std::string& corpus, const std::vector<D>& src) {
+        using namespace encoding;
+        const std::size_t bytes = src.size() * sizeof(D);
+        const std::string type = type_name<D>();
+
+        {
+            using H = lossless::Huffman<D>;
+            typename H::encoded e;
+            h.run({"lossless", "huffman", "", corpus, type, bytes},
+                  [&]{
+                      e = H::encode(src, false);
+                      return e.bytes.size() + e.table.counts.size() + e.table.symbols.size() * sizeof(D);
+                  },
+                  [&]{ return H::decode(e.table, e.bytes, e.nb_symbols) == src; });
+        }
+        {
+            using R = lossless::Rans<D>;
+            std::optional<typename R::encoded> e;
+            h.run({"lossless", "rans", "", corpus, type, bytes},
+                  [&]{
+                      e = R::encode(src);
+                      return e ? e->bytes.size() + e->tab.freqs.size() * 2 + e->tab.symbols.size() * sizeof(D)
+                               : bytes;
+                  },
+                  // plus de 1 << max_scale_bits symboles : pas de flux (le container passe en stored)
+                  [&]{ return e ? R::decode(e->tab, e->bytes, e->nb_symbols) == src : true; });
+        }
+        for (int level : {1, 6, 9}) {
+            std::vector<std::uint8_t> packed;
+            h.run({"lossless", "lz77", "level=" + std::to_string(level), corpus, type, bytes},
+                  [&]{
+                      packed = container::encode<D>(src, container::codec::lz77, {32768, 258, 0, level});
+                      return packed.size();
+                  },
+                  [&]{ const auto back = container::decode<D>(packed); return back && *back == src; });
+        }
+        // LZ77 + entropie par lots (pipeline), niveau 6
+        {
+            pipeline::Deflate<D> deflate;
+            std::vector<std::uint8_t> packed;
+            std::vector<D> back(src.size());
+            h.run({"lossless", "deflate", "level=6", corpus, type, bytes},
+                  [&]{ packed.clear(); deflate.encode(std::span<const D>(src), packed); return packed.size(); },
+                  [&]{ return deflate.decode(packed, std::span<D>(back)) && back == src; });
+        }
+        {
+            pipeline::DeflateRans<D> deflate;
+            std::vector<std::uint8_t> packed;
+            std::vector<D> back(src.size());
+            h.run({"lossless", "deflate-rans", "level=6", corpus, type, bytes},
+                  [&]{ packed.clear(); deflate.encode(std::span<const D>(src), packed); return packed.size(); },
+                  [&]{ return deflate.decode(packed, std::span<D>(back)) && back == src; });
+        }
+        {
+            std::vector<std::uint8_t> packed;
+            h.run({"lossless", "runlength", "", corpus, type, bytes},
+                  [&]{ packed = lossless::RunLength<D>::encode(src); return packed.size(); },
+                  [&]{ const auto back = lossless::RunLength<D>::decode(packed, src.size()); return back && *back == src; });
+        }
+        {
+            using CR = lossless::CompressRepeating<D>;
+            std::pair<std::vector<std::pair<D, std::size_t>>, std::size_t> enc;
+            h.run({"lossless", "repeating", "value=0", corpus, type, bytes},
+                  [&]{
+                      enc = CR::encode(src, D{});
+                      // taille sérialisée : symbole + varint du nombre de répétitions
+                      std::size_t size = 10;
+                      for (auto& [d, count] : enc.first)
+                          size += sizeof(D) + static_cast<std::size_t>(std::bit_width(count | 1) + 6) / 7;
+                      return size;
+                  },
+                  [&]{ return CR::decode(enc.first, enc.second, D{}) == src; });
+        }
+    }
+
+    // ===== Suite lossy : DCT, DFT (FFT et somme directe), quantification, image =====
+
+    // ancienne DiscreteFourier::encode : somme directe en O(N * nb_coefs)
+    template<typename T>
+    std::pair<std::vector<T>, std::vector<T>> naive_dft(std::span<const T> x, std::size_t nb_coefs) {
+        std::vector<T> re(nb_coefs), im(nb_coefs);
+        const std::size_t N = x.size();
+        for (std::size_t k = 0; k < nb_coefs; ++k) {
+            double rr = 0.0, ii = 0.0;
+            for (std::size_t n = 0; n < N; ++n) {
+                const long double theta = 2.0L * std::numbers::pi_v<long double>
+                                        * static_cast<long double>(k) * static_cast<long double>(n)
+                                        / static_cast<long double>(N);
+                rr += static_cast<double>(x[n]) * static_cast<double>(std::cos(theta));
+                ii += static_cast<double>(x[n]) * static_cast<double>(std::sin(theta));
+            }
+            re[k] = static_cast<T>(rr); im[k] = static_cast<T>(ii);
+        }
+        return {re, im};
+    }
+
+    template<typename T>
+    double max_error(std::span<const T> a, std::span<const T> b) {
+        double err = 0.0;
+        for (std::size_t i = 0; i < a.size(); ++i) err = std::max(err, std::abs(static_cast<double>(a[i]) - static_cast<double>(b[i])));
+        return err;
+    }
+
+    template<typename T>
+    void transform_suite(Harness& h, std::size_t N) {
+        using namespace encoding::lossy;
+        const auto x = make_signal<T>(N);
+        const std::size_t bytes = N * sizeof(T);
+        const std::string type = type_name<T>();
+        const std::string params = "N=" + std::to_string(N);
+
+        // transformées seules (tous les coefficients) : ni taux ni qualité
+        std::vector<T> dct;
+        h.run({"lossy", "dct", params, "signal", type, bytes},
+              [&]{ dct = DiscreteCosinus::encode<T, T>(x, N); return std::size_t{0}; },
+              [&]{ return DiscreteCosinus::decode<T, T>(dct, N).size() == N; });
+
+        std::pair<std::vector<T>, std::vector<T>> dft;
+        h.run({"lossy", "dft", params, "signal", type, bytes},
+              [&]{ dft = DiscreteFourier::encode<T, T>(x, N); return std::size_t{0}; },
+              [&]{ return DiscreteFourier::decode<T, T>(dft, N).size() == N; });
+
+        // somme directe, petites tailles seulement ; qualité : écart maximal à la FFT
+        if (N <= 4096 && !dft.first.empty()) {
+            std::pair<std::vector<T>, std::vector<T>> direct;
+            h.run({"lossy", "dft-direct", params, "signal", type, bytes},
+                  [&]{ direct = naive_dft<T>(x, N); return std::size_t{0}; },
+                  nullptr,
+                  [&]{ return std::max(max_error<T>(direct.first, dft.first), max_error<T>(direct.second, dft.second)); });
+        }
+    }
+
+    // B trames de N échantillons : une trame à la fois (encode / decode) contre un lot
+    // (frame_view rows ou interleaved, plan et tampons partagés)
+    template<typename T>
+    void batch_suite(Harness& h, std::size_t N, std::size_t total) {
+        using namespace encoding::lossy;
+        const std::size_t B = std::max<std::size_t>(total / N, 1);
+        const auto x = make_signal<T>(B * N);
+        const std::size_t bytes = B * N * sizeof(T);
+        const std::string type = type_name<T>();
+        const std::string params = "N=" + std::to_string(N) + ",B=" + std::to_string(B);
+        std::vector<T> coefs(B * N), back(B * N);
+        std::vector<T> work(DiscreteCosinus::batch_work_size<T>(N));
+
+        h.run({"lossy", "dct-single", params, "signal", type, bytes},
+              [&]{
+                  for (std::size_t f = 0; f < B; ++f) {
+                      const auto c = DiscreteCosinus::encode<T, T>(std::span<const T>(x).subspan(f * N, N), N);
+                      std::copy(c.begin(), c.end(), coefs.begin() + static_cast<std::ptrdiff_t>(f * N));
+                  }
+                  return std::size_t{0};
+              },
+              [&]{
+                  for (std::size_t f = 0; f < B; ++f) {
+                      const auto d = DiscreteCosinus::decode<T, T>(std::span<const T>(coefs).subspan(f * N, N), N);
+                      std::copy(d.begin(), d.end(), back.begin() + static_cast<std::ptrdiff_t>(f * N));
+                  }
+                  return true;
+              });
+        for (bool inter : {false, true}) {
+            const auto src = inter ? frame_view<const T>::interleaved(x.data(), B, N) : frame_view<const T>::rows(x.data(), B, N);
+            const auto out = inter ? frame_view<T>::interleaved(coefs.data(), B, N) : frame_view<T>::rows(coefs.data(), B, N);
+            const auto dst = inter ? frame_view<T>::interleaved(back.data(), B, N) : frame_view<T>::rows(back.data(), B, N);
+            h.run({"lossy", inter ? "dct-interlv" : "dct-rows", params, "signal", type, bytes},
+                  [&]{ DiscreteCosinus::encode_batch_into<T, T>(src, out, work); return std::size_t{0}; },
+                  [&]{ DiscreteCosinus::decode_batch_into<T, T>(out, dst, work); return true; });
+        }
+        encoding::parallel::ThreadPool pool(h.opt().max_threads);
+        const auto src = frame_view<const T>::rows(x.data(), B, N);
+        const auto out = frame_view<T>::rows(coefs.data(), B, N);
+        h.run({"lossy", "dct-pool", params + ",threads=" + std::to_string(pool.size()), "signal", type, bytes},
+              [&]{ encoding::parallel::dct_encode_batch<T, T>(src, out, pool); return std::size_t{0}; },
+              [&]{ encoding::parallel::dct_decode_batch<T, T>(out, frame_view<T>::rows(back.data(), B, N), pool); return true; });
+        std::vector<T> re(B * N), im(B * N);
+        h.run({"lossy", "dft-rows", params, "signal", type, bytes},
+              [&]{
+                  DiscreteFourier::encode_batch<T, T>(frame_view<const T>::rows(x.data(), B, N),
+                                                      frame_view<T>::rows(re.data(), B, N), frame_view<T>::rows(im.data(), B, N));
+                  return std::size_t{0};
+              });
+    }
+
+    template<typename T>
+    void quantization_suite(Harness& h, std::size_t n) {
+        using namespace encoding::lossy;
+        const auto x = make_signal<T>(n);
+        const std::size_t bytes = n * sizeof(T);
+        const std::string type = type_name<T>();
+        std::vector<std::int16_t> q(n);
+        std::vector<T> back(n);
+        h.run({"lossy", "quantize", "q=0.5,i16", "signal", type, bytes},
+              [&]{ Quantization::encode_into<T, std::int16_t>(x, T(0.5), q); return q.size() * sizeof(std::int16_t); },
+              [&]{ Quantization::decode_into<std::int16_t, T>(q, T(0.5), back); return true; },
+              [&]{ return max_error<T>(x, back); });
+
+        // DCT par trames de 64 + quantification + varints (codec du pilote parallèle)
+        const encoding::parallel::dct_codec<T> codec{64, 16, 0.5};
+        std::vector<std::uint8_t> packed;
+        std::vector<T> frames(n);
+        h.run({"lossy", "dct-frames", "64/16,q=0.5", "signal", type, bytes},
+              [&]{ packed.clear(); codec.encode(x, packed); return packed.size(); },
+              [&]{ return codec.decode(packed, frames); },
+              [&]{ return max_error<T>(x, frames); });
+    }
+
+    // un octet par pixel : les MB/s des lignes image sont des mégapixels par seconde
+    void image_suite(Harness& h, std::size_t w, std::size_t hgt) {
+        using namespace encoding;
+        const auto px = make_image(w, hgt);
+        for (std::size_t b : {8, 16})
+            for (int quality : {50, 90})
+            for (auto entropy : {container::codec::huffman, container::codec::rans}) {
+                std::vector<std::uint8_t> enc;
+                std::optional<image::plane> dec;
+                h.run({"lossy", "image", "B=" + std::to_string(b) + ",q=" + std::to_string(quality)
+                                          + (entropy == container::codec::rans ? ",rans" : ""),
+                       std::to_string(w) + "x" + std::to_string(hgt), "u8", px.size()},
+                      [&]{
+                          enc = image::encode(px, w, hgt, {.block_size = b, .quality = quality, .matrix = {},
+                                                           .batch = 64, .entropy = entropy});
+                          return enc.size();
+                      },
+                      [&]{ dec = image::decode(enc); return dec && dec->pixels.size() == px.size(); },
+                      [&]{ // PSNR (dB)
+                          if (!dec) return 0.0;
+                          double se = 0.0;
+                          for (std::size_t i = 0; i < px.size(); ++i) {
+                              const double d = static_cast<double>(px[i]) - static_cast<double>(dec->pixels[i]);
+                              se += d * d;
+                          }
+                          const double mse = se / static_cast<double>(px.size());
+                          return 10.0 * std::log10(255.0 * 255.0 / std::max(mse, 1e-9));
+                      });
+            }
+    }
+
+    // ===== Suite messages : petits blocs indépendants, sans puis avec dictionnaire entraîné =====
+    // Le dictionnaire est entraîné sur des échantillons distincts des messages mesurés ; son
+    // entraînement n'entre pas dans les mesures. Un workspace sert à tous les messages.
+    void message_suite(Harness& h, std::size_t msg_size) {
+        using namespace encoding;
+        using container::codec;
+        const auto samples = make_messages(256, msg_size, 101);
+        const auto msgs    = make_messages(1000, msg_size, 202);
+        const auto dict    = dictionary::Dictionary<unsigned char>::train(samples);
+        std::size_t bytes = 0, max_msg = 0;
+        for (auto& m : msgs) { bytes += m.size(); max_msg = std::max(max_msg, m.size()); }
+
+        for (auto id : {codec::lz77, codec::huffman, codec::rans, codec::dict_lz77, codec::dict_huffman, codec::dict_rans}) {
+            static constexpr const char* names[] = {"", "huffman", "lz77", "", "rans", "dict-lz77", "dict-huffman", "dict-rans"};
+            container::workspace<unsigned char> ws;
+            std::vector<std::uint8_t> packed(msgs.size() * container::max_compressed_size<unsigned char>(max_msg));
+            std::vector<std::size_t> ends(msgs.size());
+            std::vector<unsigned char> out(max_msg);
+            h.run({"messages", names[static_cast<std::size_t>(id)], "msg=" + std::to_string(msg_size), "records", "u8", bytes},
+                  [&]{
+                      std::size_t pos = 0;
+                      for (std::size_t i = 0; i < msgs.size(); ++i) {
+                          const auto n = container::encode_block_into<unsigned char>(
+                              std::span(packed).subspan(pos), std::span<const unsigned char>(msgs[i]), id, {}, ws, &dict);
+                          pos += n.value_or(0);
+                          ends[i] = pos;
+                      }
+                      return pos;
+                  },
+                  [&]{
+                      std::size_t pos = 0;
+                      for (std::size_t i = 0; i < msgs.size(); ++i) {
+                          const auto used = container::decode_block<unsigned char>(
+                              std::span<const std::uint8_t>(packed).subspan(pos, ends[i] - pos), std::span(out), 0, ws, &dict);
+                          if (!used || !std::equal(msgs[i].begin(), msgs[i].end(), out.begin())) return false;
+                          pos = ends[i];
+                      }
+                      return true;
+                  });
+        }
+    }
+
+    // ===== Suite parallel : mise à l'échelle du pilote par blocs =====
+    template<typename D, typename Codec>
+    void scaling(Harness& h, const std::string& name, const std::string& corpus, const std::vector<D>& src,
+                 const Codec& codec, std::size_t block_size) {
+        std::vector<std::size_t> counts;
+        for (std::size_t t = 1; t < h.opt().max_threads; t *= 2) counts.push_back(t);
+        counts.push_back(h.opt().max_threads);
+        for (std::size_t t : counts) {
+            encoding::parallel::ThreadPool pool(t);
+            std::vector<std::uint8_t> packed;
+            h.run({"parallel", name, "threads=" + std::to_string(t), corpus, type_name<D>(), src.size() * sizeof(D)},
+                  [&]{ packed = encoding::parallel::compress<D>(src, codec, block_size, pool); return packed.size(); },
+                  [&]{
+                      const auto back = encoding::parallel::decompress<D>(packed, codec, pool);
+                      return back && back->size() == src.size();
+                  });
+        }
+    }
+
+    // ===== Suite dedup : déduplication à longue distance devant LZ77, contre LZ77 seul (fenêtre de 32 Kio) =====
+    void dedup_suite(Harness& h, const std::string& corpus, const std::vector<unsigned char>& src) {
+        using namespace encoding;
+        std::vector<std::uint8_t> packed;
+        h.run({"dedup", "lz77", "level=6", corpus, "u8", src.size()},
+              [&]{ packed = container::encode<unsigned char>(src, container::codec::lz77); return packed.size(); },
+              [&]{ const auto back = container::decode<unsigned char>(packed); return back && *back == src; });
+        dedup::Deduplicator<unsigned char> dd;
+        h.run({"dedup", "dedup+lz77", "chunk=8K", corpus, "u8", src.size()},
+              [&]{ packed.clear(); dedup::encode<unsigned char>(src, packed, dd); return packed.size(); },
+              [&]{ const auto back = dedup::decompress<unsigned char>(packed); return back && *back == src; });
+    }
+
+    // ===== Suite stream : flux à fenêtre LZ77 continue, écrit par morceaux de 64 Kio =====
+    void stream_suite(Harness& h, const std::string& corpus, const std::vector<unsigned char>& src) {
+        using namespace encoding;
+        const stream::lz77_codec<unsigned char> codec{};
+        std::vector<std::uint8_t> packed;
+        h.run({"stream", "lz77", "block=256K", corpus, "u8", src.size()},
+              [&]{
+                  packed.clear();
+                  stream::Encoder<unsigned char, stream::lz77_codec<unsigned char>> enc(
+                      codec, [&](std::span<const std::uint8_t> b){ packed.insert(packed.end(), b.begin(), b.end()); },
+                      std::size_t{256} << 10);
+                  for (std::size_t i = 0; i < src.size(); i += 65536)
+                      enc.write(std::span(src).subspan(i, std::min<std::size_t>(65536, src.size() - i)));
+                  enc.finish();
+                  return packed.size();
+              },
+              [&]{ const auto back = stream::decompress<unsigned char>(packed, codec); return back && *back == src; });
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    using namespace encoding;
+    Harness h(parse_options(argc, argv));
+    const std::size_t max_bytes = h.opt().max_mib << 20;
+
+    std::vector<std::size_t> sizes{std::size_t{64} << 10, std::size_t{1} << 20, max_bytes};
+    std::sort(sizes.begin(), sizes.end());
+    sizes.erase(std::unique(sizes.begin(), sizes.end()), sizes.end());
+    sizes.erase(std::remove_if(sizes.begin(), sizes.end(), [&](std::size_t s){ return s > max_bytes; }), sizes.end());
+
+#if !defined(__OPTIMIZE__)
+    std::cerr << "attention : dc_bench compilé sans optimisation (-DCMAKE_BUILD_TYPE=Release)\n";
+#endif
+    Harness::print_header();
+
+    // --- sans perte : octets puis entiers 16 bits ---
+    const auto text   = make_text(max_bytes);
+    const auto random = make_random<unsigned char>(max_bytes);
+    const auto sparse = make_sparse(max_bytes);
+    const auto telem  = make_telemetry(max_bytes / sizeof(std::int16_t));
+    const auto rand16 = make_random<std::int16_t>(max_bytes / sizeof(std::int16_t));
+    for (std::size_t s : sizes) {
+        const auto prefix = [&](const auto& v) {
+            using V = std::decay_t<decltype(v)>;
+            return V(v.begin(), v.begin() + static_cast<std::ptrdiff_t>(std::min(v.size(), s / sizeof(typename V::value_type))));
+        };
+        lossless_suite(h, "text",   prefix(text));
+        lossless_suite(h, "random", prefix(random));
+        lossless_suite(h, "runs",   prefix(sparse));
+        lossless_suite(h, "telem",  prefix(telem));
+        lossless_suite(h, "random", prefix(rand16));
+    }
+    if (!h.opt().corpus_file.empty()) {
+        auto file = read_file(h.opt().corpus_file);
+        file.resize(std::min(file.size(), max_bytes));
+        if (!file.empty()) lossless_suite(h, "file", file);
+    }
+
+    // --- répétitions lointaines (sauvegardes) ---
+    dedup_suite(h, "backup", make_backup(max_bytes));
+
+    // --- petits messages (200 o - 4 Kio) ---
+    for (std::size_t m : {std::size_t{256}, std::size_t{1024}, std::size_t{4096}}) message_suite(h, m);
+
+    // --- avec perte ---
+    for (std::size_t N : {std::size_t{64}, std::size_t{1000}, std::size_t{1024}, std::size_t{2053}, std::size_t{16381}, std::size_t{65536}}) {
+        transform_suite<float>(h, N);
+        transform_suite<double>(h, N);
+    }
+    for (std::size_t N : {std::size_t{64}, std::size_t{251}, std::size_t{256}, std::size_t{1024}}) {
+        batch_suite<float>(h, N, std::size_t{1} << 18);
+        batch_suite<double>(h, N, std::size_t{1} << 17);
+    }
+    for (std::size_t s : sizes) {
+        quantization_suite<float>(h, s / sizeof(float));
+        quantization_suite<double>(h, s / sizeof(double));
+    }
+    image_suite(h, 512, 512);
+    image_suite(h, 2048, 2048);
+
+    // --- parallèle et flux, corpus de taille maximale ---
+    constexpr std::size_t block = 1 << 20;
+    scaling(h, "huffman", "text", text, parallel::container_codec<unsigned char>{container::codec::huffman, {}}, block);
+    scaling(h, "lz77",    "text", text, parallel::container_codec<unsigned char>{container::codec::lz77, {}}, block);
+    scaling(h, "deflate", "text", text, pipeline::pipeline_codec<pipeline::Deflate<unsigned char>>{}, block);
+    scaling(h, "rle",     "runs", sparse, parallel::container_codec<unsigned char>{container::codec::rle, {}}, block);
+    const auto signal = make_signal<double>(max_bytes / sizeof(double));
+    scaling(h, "dct",   "signal", signal, parallel::dct_codec<double>{64, 16, 0.5}, block / sizeof(double));
+    stream_suite(h, "text", text);
+
+    write_to(h.opt().csv,  h.results(), write_csv);
+    write_to(h.opt().json, h.results(), write_json);
+    const bool ok = std::all_of(h.results().begin(), h.results().end(), [](const result& r){ return r.ok; });
+    return ok ? 0 : 1;
+}
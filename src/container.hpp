@@ -0,0 +1,743 @@
+#pragma once
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <optional>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <bit>
+#include <type_traits>
+#include <limits>
+#include <memory_resource>
+#include "dictionary.hpp"
+#include "encoding_lossless.hpp"
+#include "stats.hpp"
+#include "utils.hpp"
+
+namespace encoding::container {
+
+    // ===== Format de bloc compressé, auto-descriptif =====
+    // En-tête : 'D' 'C' | codec (u8) | sizeof(D) (u8) | nb_symbols | payload_size | crc32 (u32 LE)
+    // puis le payload. Les entiers sont des varints LEB128, les symboles sont stockés en
+    // little-endian. Payloads :
+    //   stored  : symboles bruts
+    //   huffman : L (u8) | counts[1..L] | symboles dans l'ordre canonique | flux de bits
+    //   lz77    : buffer_size | nb_sequences | nb_literals | lengths_size | offsets_size
+    //             | littéraux | longueurs | offsets
+    //     une séquence = (nb de littéraux, longueur de correspondance, offset si longueur > 0) ;
+    //     seule la dernière peut avoir une longueur nulle.
+    //   rle     : plages lossless::RunLength (en-tête varint littéral / répétition, puis symbole(s))
+    //   rans    : scale_bits (u8) | nb de symboles k | symboles | k fréquences normalisées
+    //             | flux lossless::Rans
+    //   dict_*  : id du dictionary::Dictionary (u32 LE) puis, avec les données du dictionnaire :
+    //     dict_lz77    : payload lz77 dont les offsets peuvent remonter dans le contenu du
+    //                    dictionnaire, qui précède immédiatement le premier symbole
+    //     dict_huffman : flux de bits codé avec la table fixe du dictionnaire
+    //     dict_rans    : flux lossless::Rans codé avec la table fixe du dictionnaire
+    // Le décodage lit directement le tampon (mmap possible) et écrit dans un span fourni.
+    // Un codec dont le payload dépasserait les symboles bruts cède la place à stored : un bloc
+    // ne dépasse jamais max_compressed_size.
+
+    enum class codec : std::uint8_t {
+        stored = 0, huffman = 1, lz77 = 2, rle = 3, rans = 4, dict_lz77 = 5, dict_huffman = 6, dict_rans = 7,
+    };
+
+    // level : niveau lossless::LZ77<D>::level (1 rapide ... 9 analyse optimale) ;
+    // max_chain != 0 remplace la profondeur de chaîne du niveau
+    struct lz77_params {
+        std::size_t buffer_size = 32768;
+        std::size_t chunk_size  = 258;
+        std::size_t max_chain   = 0;
+        int         level       = 6;
+    };
+
+    struct block_header {
+        codec         id           = codec::stored;
+        std::size_t   symbol_size  = 0;
+        std::size_t   nb_symbols   = 0;
+        std::size_t   payload_size = 0;
+        std::uint32_t checksum     = 0;
+        std::size_t   header_size  = 0;
+    };
+
+    namespace detail {
+
+        template<typename D>
+        void put_symbol(std::uint8_t* p, const D& d) noexcept {
+            std::memcpy(p, &d, sizeof(D));
+            if constexpr (std::endian::native != std::endian::little) std::reverse(p, p + sizeof(D));
+        }
+
+        template<typename D>
+        [[nodiscard]] D get_symbol(const std::uint8_t* p) noexcept {
+            D d;
+            if constexpr (std::endian::native == std::endian::little) std::memcpy(&d, p, sizeof(D));
+            else {
+                std::uint8_t tmp[sizeof(D)];
+                std::reverse_copy(p, p + sizeof(D), tmp);
+                std::memcpy(&d, tmp, sizeof(D));
+            }
+            return d;
+        }
+
+        template<typename D, typename Alloc>
+        void put_symbols(std::vector<std::uint8_t, Alloc>& out, std::span<const D> src) {
+            const std::size_t o = out.size();
+            out.resize(o + src.size_bytes());
+            if constexpr (std::endian::native == std::endian::little || sizeof(D) == 1) {
+                if (!src.empty()) std::memcpy(out.data() + o, src.data(), src.size_bytes());
+            } else {
+                for (std::size_t i = 0; i < src.size(); ++i) put_symbol(out.data() + o + i * sizeof(D), src[i]);
+            }
+        }
+
+        template<typename D>
+        void get_symbols(const std::uint8_t* p, std::span<D> out) noexcept {
+            if constexpr (std::endian::native == std::endian::little || sizeof(D) == 1) {
+                if (!out.empty()) std::memcpy(out.data(), p, out.size_bytes());
+            } else {
+                for (std::size_t i = 0; i < out.size(); ++i) out[i] = get_symbol<D>(p + i * sizeof(D));
+            }
+        }
+
+        // crc32 de la représentation little-endian des symboles
+        template<typename D>
+        [[nodiscard]] std::uint32_t checksum(std::span<const D> data) noexcept {
+            if constexpr (std::endian::native == std::endian::little || sizeof(D) == 1) {
+                return utils::crc32({reinterpret_cast<const std::uint8_t*>(data.data()), data.size_bytes()});
+            } else {
+                std::uint32_t crc = 0;
+                std::uint8_t tmp[sizeof(D)];
+                for (auto& d : data) { put_symbol(tmp, d); crc = utils::crc32(tmp, crc); }
+                return crc;
+            }
+        }
+
+        inline std::uint8_t* put_u32(std::uint8_t* p, std::uint32_t v) noexcept {
+            for (int i = 0; i < 4; ++i) *p++ = static_cast<std::uint8_t>(v >> (8 * i));
+            return p;
+        }
+
+        [[nodiscard]] inline std::uint32_t get_u32(const std::uint8_t* p) noexcept {
+            return std::uint32_t{p[0]} | std::uint32_t{p[1]} << 8 | std::uint32_t{p[2]} << 16 | std::uint32_t{p[3]} << 24;
+        }
+
+        // reçoit l'analyse LZ77 et la range en flux littéraux / longueurs / offsets
+        template<typename D>
+        struct sequence_writer {
+            std::pmr::vector<std::uint8_t> literals, lengths, offsets;
+            std::size_t nb_sequences = 0, nb_literals = 0, run = 0;
+
+            explicit sequence_writer(std::pmr::memory_resource* mr = std::pmr::get_default_resource())
+                : literals(mr), lengths(mr), offsets(mr) {}
+
+            void reset() noexcept {
+                literals.clear(); lengths.clear(); offsets.clear();
+                nb_sequences = nb_literals = run = 0;
+            }
+
+            void literal(const D& d) {
+                const std::size_t o = literals.size();
+                literals.resize(o + sizeof(D));
+                put_symbol(literals.data() + o, d);
+                ++run; ++nb_literals;
+            }
+            void match(std::size_t off, std::size_t len) {
+                utils::put_varint(lengths, run);
+                utils::put_varint(lengths, len);
+                utils::put_varint(offsets, off);
+                run = 0; ++nb_sequences;
+            }
+            void finish() {
+                if (run == 0) return;
+                utils::put_varint(lengths, run);
+                utils::put_varint(lengths, 0);
+                run = 0; ++nb_sequences;
+            }
+        };
+
+    } // namespace detail
+
+    // ===== Taille maximale d'un bloc =====
+    // en-tête : 'D' 'C' codec taille | deux varints | crc32
+    inline constexpr std::size_t max_header_size = 4 + 2 * utils::max_varint_size + 4;
+
+    // borne de la taille d'un bloc de nb_symbols symboles, quel que soit le codec
+    template<typename D>
+    [[nodiscard]] constexpr std::size_t max_compressed_size(std::size_t nb_symbols) noexcept {
+        return max_header_size + nb_symbols * sizeof(D);
+    }
+
+    // plafond par défaut de decode (octets décodés) : un bloc qui annonce davantage est refusé
+    // avant toute allocation. Les codecs sans borne tirée du payload (rANS d'un seul symbole)
+    // ne sont limités que par lui.
+    inline constexpr std::size_t default_max_bytes = std::size_t{1} << 30;
+
+    // ===== État réutilisable d'un bloc à l'autre =====
+    // Payload, flux de séquences LZ77, index de hachage, tables Huffman et rANS gardent leur mémoire
+    // (prise dans mr, par ex. un std::pmr::monotonic_buffer_resource) : après un premier bloc,
+    // encode_block_into / decode_block n'allouent plus (Huffman : symboles d'un octet).
+    // Un workspace sert à un seul thread à la fois.
+    template<typename D, typename Stats = stats::none>
+    struct workspace {
+        std::pmr::vector<std::uint8_t>                   payload;
+        detail::sequence_writer<D>                       sequences;
+        typename lossless::LZ77<D, Stats>::workspace     lz77;
+        typename lossless::Huffman<D, Stats>::workspace  huffman;
+        typename lossless::Rans<D, Stats>::workspace     rans;
+
+        explicit workspace(std::pmr::memory_resource* mr = std::pmr::get_default_resource())
+            : payload(mr), sequences(mr), lz77(mr), huffman(mr), rans(mr) {}
+    };
+
+    namespace detail {
+
+        template<typename D, typename Stats, typename Alloc>
+        void huffman_payload(std::vector<std::uint8_t, Alloc>& out, std::span<const D> src,
+                             typename lossless::Huffman<D, Stats>::workspace& ws) {
+            using H = lossless::Huffman<D, Stats>;
+            H::count_into(src, ws.freqs);
+            H::build_table_into(ws.freqs, false, ws);
+            const auto& table = ws.table;
+            const auto& freqs = ws.freqs;
+            const std::size_t L = table.counts.empty() ? 0 : table.counts.size() - 1;
+            out.push_back(static_cast<std::uint8_t>(L));
+            for (std::size_t l = 1; l <= L; ++l) utils::put_varint(out, table.counts[l]);
+            put_symbols<D>(out, std::span<const D>(table.symbols));
+
+            H::make_codes_into(table, ws.codes);
+            const auto& codes = ws.codes;
+            const std::size_t nb_bytes = (H::encoded_bits(freqs, codes) + 7) / 8;
+            H::record_stats(freqs, codes);
+            const std::size_t o = out.size();
+            out.resize(o + nb_bytes + 8); // marge : chemin rapide du BitWriter
+            [[maybe_unused]] const auto written = H::encode_into(src, codes, std::span(out).subspan(o));
+            assert(written);
+            out.resize(o + nb_bytes);
+        }
+
+        // src[0, start) : historique seulement ; base : index du dictionnaire qui précède src[0]
+        template<typename D, typename Stats, typename Alloc>
+        void lz77_payload(std::vector<std::uint8_t, Alloc>& out, std::span<const D> src, std::size_t start,
+                          const lz77_params& lz, workspace<D, Stats>& ws,
+                          const utils::MatchFinder<D>* base = nullptr) {
+            sequence_writer<D>& w = ws.sequences;
+            w.reset();
+            auto lv = lossless::LZ77<D, Stats>::level(lz.level);
+            if (lz.max_chain) lv.max_chain = lz.max_chain;
+            lossless::LZ77<D, Stats>::parse(src, start, lz.buffer_size, lz.chunk_size, lv, w, ws.lz77, base);
+            w.finish();
+            utils::put_varint(out, lz.buffer_size);
+            utils::put_varint(out, w.nb_sequences);
+            utils::put_varint(out, w.nb_literals);
+            utils::put_varint(out, w.lengths.size());
+            utils::put_varint(out, w.offsets.size());
+            out.insert(out.end(), w.literals.begin(), w.literals.end());
+            out.insert(out.end(), w.lengths.begin(), w.lengths.end());
+            out.insert(out.end(), w.offsets.begin(), w.offsets.end());
+        }
+
+        // false si l'alphabet est trop grand pour rANS (le bloc passe alors en stored)
+        template<typename D, typename Stats, typename Alloc>
+        [[nodiscard]] bool rans_payload(std::vector<std::uint8_t, Alloc>& out, std::span<const D> src,
+                                        typename lossless::Rans<D, Stats>::workspace& ws) {
+            using R = lossless::Rans<D, Stats>;
+            R::count_into(src, ws.freqs);
+            if (!R::build_table_into(ws.freqs, ws)) return false;
+            const auto& table = ws.tab;
+            out.push_back(static_cast<std::uint8_t>(table.scale_bits));
+            utils::put_varint(out, table.symbols.size());
+            put_symbols<D>(out, std::span<const D>(table.symbols));
+            for (auto f : table.freqs) utils::put_varint(out, f);
+
+            R::make_encoder_into(table, ws.enc);
+            ws.stream.resize(R::max_stream_size(src.size()));
+            const auto stream = R::encode_into(src, table, ws.enc, ws.stream);
+            assert(stream);
+            R::record_stats(ws.freqs, stream->size());
+            out.insert(out.end(), stream->begin(), stream->end());
+            return true;
+        }
+
+        // tables fixes du dictionnaire : false si un symbole n'y a pas de code (le bloc passe
+        // alors en stored)
+        template<typename D, typename Alloc>
+        [[nodiscard]] bool dict_huffman_payload(std::vector<std::uint8_t, Alloc>& out, std::span<const D> src,
+                                                const dictionary::Dictionary<D>& dict) {
+            // au-delà de la taille brute, le bloc passerait en stored : inutile de coder plus loin
+            const std::size_t o = out.size();
+            out.resize(o + src.size_bytes() + 8);
+            const auto bits = lossless::Huffman<D>::encode_into(src, dict.huffman_codes(), std::span(out).subspan(o));
+            if (!bits) return false;
+            out.resize(o + (*bits + 7) / 8);
+            return true;
+        }
+
+        template<typename D, typename Stats, typename Alloc>
+        [[nodiscard]] bool dict_rans_payload(std::vector<std::uint8_t, Alloc>& out, std::span<const D> src,
+                                             const dictionary::Dictionary<D>& dict,
+                                             typename lossless::Rans<D, Stats>::workspace& ws) {
+            using R = lossless::Rans<D>;
+            ws.stream.resize(R::max_stream_size(src.size()));
+            const auto stream = R::encode_into(src, dict.rans_table(), dict.rans_encoder(), ws.stream);
+            if (!stream) return false;
+            out.insert(out.end(), stream->begin(), stream->end());
+            return true;
+        }
+
+        template<typename D, typename Alloc>
+        void rle_payload(std::vector<std::uint8_t, Alloc>& out, std::span<const D> src) {
+            lossless::RunLength<D>::encode(src, out);
+        }
+
+        template<typename D, typename Stats>
+        [[nodiscard]] bool huffman_decode(std::span<const std::uint8_t> in, std::span<D> out,
+                                          typename lossless::Huffman<D, Stats>::workspace& ws) {
+            using H = lossless::Huffman<D, Stats>;
+            const std::uint8_t* p = in.data();
+            const std::uint8_t* const end = p + in.size();
+            if (p == end) return false;
+            const std::size_t L = *p++;
+            if (L > 32) return false;
+            auto& table = ws.table;
+            table.counts.clear();
+            table.symbols.clear();
+            if (L != 0) {
+                table.counts.assign(L + 1, 0);
+                std::uint64_t total = 0;
+                for (std::size_t l = 1; l <= L; ++l) {
+                    const auto c = utils::get_varint(p, end);
+                    if (!c || *c > (std::uint64_t{1} << l)) return false;
+                    table.counts[l] = static_cast<std::uint32_t>(*c);
+                    total += *c;
+                }
+                if (total > static_cast<std::size_t>(end - p) / sizeof(D)) return false;
+                table.symbols.resize(total);
+                get_symbols<D>(p, table.symbols);
+                p += total * sizeof(D);
+            }
+            if (!H::make_decoder_into(table, ws.dec)) return false;
+            return H::decode_into(ws.dec, {p, end}, out).has_value();
+        }
+
+        template<typename D, typename Stats>
+        [[nodiscard]] bool rans_decode(std::span<const std::uint8_t> in, std::span<D> out,
+                                       typename lossless::Rans<D, Stats>::workspace& ws) {
+            using R = lossless::Rans<D, Stats>;
+            const std::uint8_t* p = in.data();
+            const std::uint8_t* const end = p + in.size();
+            if (p == end) return false;
+            auto& table = ws.tab;
+            table.scale_bits = *p++;
+            const auto k = utils::get_varint(p, end);
+            if (!k || *k > static_cast<std::size_t>(end - p) / sizeof(D)) return false;
+            table.symbols.resize(static_cast<std::size_t>(*k));
+            get_symbols<D>(p, table.symbols);
+            p += *k * sizeof(D);
+            table.freqs.clear();
+            for (std::uint64_t i = 0; i < *k; ++i) {
+                const auto f = utils::get_varint(p, end);
+                if (!f || *f > (std::uint64_t{1} << R::max_scale_bits)) return false;
+                table.freqs.push_back(static_cast<std::uint32_t>(*f));
+            }
+            if (!R::make_decoder_into(table, ws.dec)) return false;
+            return R::decode_into(ws.dec, {p, end}, out).has_value();
+        }
+
+        // out[0, start) contient déjà l'historique ; le bloc est écrit à partir de out[start].
+        // dict : contenu d'un dictionnaire qui précède out[0] (codec dict_lz77)
+        template<typename D, typename Stats>
+        [[nodiscard]] bool lz77_decode(std::span<const std::uint8_t> in, std::span<D> out, std::size_t start,
+                                       std::span<const D> dict = {}) {
+            [[maybe_unused]] typename Stats::timer t(stats::stage::lz77_decode);
+            const std::uint8_t* p = in.data();
+            const std::uint8_t* const end = p + in.size();
+            std::uint64_t fields[5];
+            for (auto& f : fields) {
+                const auto v = utils::get_varint(p, end);
+                if (!v) return false;
+                f = *v;
+            }
+            const auto [buffer_size, nb_sequences, nb_literals, lengths_size, offsets_size] = fields;
+            const std::size_t avail = static_cast<std::size_t>(end - p);
+            if (nb_literals > avail / sizeof(D)) return false;
+            const std::size_t literals_size = nb_literals * sizeof(D);
+            if (lengths_size > avail - literals_size || offsets_size != avail - literals_size - lengths_size)
+                return false;
+
+            const std::uint8_t* lit = p;
+            const std::uint8_t* lenp = lit + literals_size;
+            const std::uint8_t* const len_end = lenp + lengths_size;
+            const std::uint8_t* offp = len_end;
+            const std::uint8_t* const lit_end = lenp;
+
+            std::size_t pos = start;
+            const std::size_t n = out.size();
+            for (std::uint64_t s = 0; s < nb_sequences; ++s) {
+                const auto run = utils::get_varint(lenp, len_end);
+                const auto len = utils::get_varint(lenp, len_end);
+                if (!run || !len) return false;
+                if (*run > n - pos || *run > static_cast<std::size_t>(lit_end - lit) / sizeof(D)) return false;
+                get_symbols<D>(lit, out.subspan(pos, *run));
+                lit += *run * sizeof(D);
+                pos += *run;
+                if (*len == 0) continue;
+                const auto off = utils::get_varint(offp, end);
+                if (!off || *off == 0 || *off > pos + dict.size() || *off > buffer_size || *len > n - pos) return false;
+                std::size_t rest = static_cast<std::size_t>(*len);
+                if (*off > pos) {
+                    // début de la correspondance dans le contenu du dictionnaire
+                    const std::size_t back = static_cast<std::size_t>(*off) - pos;
+                    const std::size_t k = std::min(back, rest);
+                    std::copy_n(dict.end() - static_cast<std::ptrdiff_t>(back), k, out.begin() + static_cast<std::ptrdiff_t>(pos));
+                    pos += k;
+                    rest -= k;
+                }
+                if (rest) utils::copy_match(out.data() + pos, static_cast<std::size_t>(*off), rest);
+                pos += rest;
+            }
+            return pos == n && lit == lit_end && lenp == len_end && offp == end;
+        }
+
+        template<typename D>
+        [[nodiscard]] bool rle_decode(std::span<const std::uint8_t> in, std::span<D> out) {
+            const auto n = lossless::RunLength<D>::decode_into(in, out);
+            return n && *n == out.size();
+        }
+
+        // nombre de symboles décrit par un payload lz77 (somme des séquences), sans décoder ;
+        // nullopt si le payload est invalide
+        template<typename D>
+        [[nodiscard]] std::optional<std::uint64_t> lz77_size(std::span<const std::uint8_t> in) noexcept {
+            const std::uint8_t* p = in.data();
+            const std::uint8_t* const end = p + in.size();
+            std::uint64_t fields[5];
+            for (auto& f : fields) {
+                const auto v = utils::get_varint(p, end);
+                if (!v) return std::nullopt;
+                f = *v;
+            }
+            [[maybe_unused]] const auto [buffer_size, nb_sequences, nb_literals, lengths_size, offsets_size] = fields;
+            const std::size_t avail = static_cast<std::size_t>(end - p);
+            if (nb_literals > avail / sizeof(D)) return std::nullopt;
+            const std::size_t literals_size = nb_literals * sizeof(D);
+            if (lengths_size > avail - literals_size || offsets_size != avail - literals_size - lengths_size)
+                return std::nullopt;
+            const std::uint8_t* lenp = p + literals_size;
+            const std::uint8_t* const len_end = lenp + lengths_size;
+            std::uint64_t total = 0;
+            for (std::uint64_t s = 0; s < nb_sequences; ++s) {
+                const auto run = utils::get_varint(lenp, len_end);
+                const auto len = utils::get_varint(lenp, len_end);
+                if (!run || !len || *run > nb_literals) return std::nullopt;
+                const std::uint64_t k = *run + *len;
+                if (k < *len || total + k < total) return std::nullopt;
+                total += k;
+            }
+            return total;
+        }
+
+        // payload d'un codec dict_* : false sans dictionnaire ou si son id ne correspond pas
+        template<typename D>
+        [[nodiscard]] bool dict_header(std::span<const std::uint8_t>& payload, const dictionary::Dictionary<D>* dict) {
+            if (!dict || payload.size() < 4 || get_u32(payload.data()) != dict->id()) return false;
+            payload = payload.subspan(4);
+            return true;
+        }
+
+        // code src[start, ...) dans ws.payload et écrit l'en-tête du bloc dans head (au moins
+        // max_header_size octets) ; renvoie la taille de l'en-tête. Les codecs dict_* demandent dict.
+        template<typename D, typename Stats>
+        std::size_t prepare_block(std::uint8_t* head, std::span<const D> src, std::size_t start, codec id,
+                                  const lz77_params& lz, workspace<D, Stats>& ws,
+                                  const dictionary::Dictionary<D>* dict = nullptr) {
+            assert(start <= src.size());
+            const auto block = src.subspan(start);
+            auto& payload = ws.payload;
+            payload.clear();
+            bool coded = true;
+            switch (id) {
+                case codec::stored:  put_symbols<D>(payload, block);  break;
+                case codec::huffman: huffman_payload<D, Stats>(payload, block, ws.huffman); break;
+                case codec::lz77:    lz77_payload<D, Stats>(payload, src, start, lz, ws); break;
+                case codec::rle:     rle_payload<D>(payload, block);  break;
+                case codec::rans:    coded = rans_payload<D, Stats>(payload, block, ws.rans); break;
+                case codec::dict_lz77:
+                case codec::dict_huffman:
+                case codec::dict_rans: {
+                    assert(dict);
+                    if (!dict) { coded = false; break; }
+                    std::uint8_t tag[4];
+                    put_u32(tag, dict->id());
+                    payload.insert(payload.end(), tag, tag + 4);
+                    if (id == codec::dict_lz77) lz77_payload<D, Stats>(payload, src, start, lz, ws, &dict->index());
+                    else if (id == codec::dict_huffman) coded = dict_huffman_payload<D>(payload, block, *dict);
+                    else coded = dict_rans_payload<D, Stats>(payload, block, *dict, ws.rans);
+                    break;
+                }
+            }
+            if (id != codec::stored && (!coded || payload.size() > block.size_bytes())) {
+                payload.clear();
+                put_symbols<D>(payload, block);
+                id = codec::stored;
+            }
+            std::uint8_t* p = head;
+            *p++ = 'D';
+            *p++ = 'C';
+            *p++ = static_cast<std::uint8_t>(id);
+            *p++ = static_cast<std::uint8_t>(sizeof(D));
+            p = utils::put_varint(p, block.size());
+            p = utils::put_varint(p, payload.size());
+            p = put_u32(p, checksum(block));
+            return static_cast<std::size_t>(p - head);
+        }
+
+    } // namespace detail
+
+    // ajoute à out un bloc contenant src[start, ...) codé avec le codec id. src[0, start) est
+    // un historique (bloc précédent d'un flux) que les correspondances LZ77 peuvent
+    // référencer ; les autres codecs l'ignorent. Le décodage doit fournir le même historique.
+    // Stats : politique d'instrumentation (stats.hpp), transmise à LZ77, Huffman et Rans
+    // (les tables fixes d'un dictionnaire ne sont pas instrumentées).
+    // dict : dictionnaire des codecs dict_* (dictionary.hpp), partagé en lecture seule.
+    template<typename D, typename Stats>
+    requires std::is_trivially_copyable_v<D>
+    void encode_block(std::vector<std::uint8_t>& out, std::span<const D> src, std::size_t start, codec id,
+                      const lz77_params& lz, workspace<D, Stats>& ws,
+                      const dictionary::Dictionary<D>* dict = nullptr) {
+        [[maybe_unused]] typename Stats::timer t(stats::stage::block_encode);
+        std::uint8_t head[max_header_size];
+        const std::size_t hs = detail::prepare_block<D, Stats>(head, src, start, id, lz, ws, dict);
+        out.insert(out.end(), head, head + hs);
+        out.insert(out.end(), ws.payload.begin(), ws.payload.end());
+        if constexpr (Stats::enabled) {
+            auto& c = Stats::local();
+            c.bytes_in += (src.size() - start) * sizeof(D);
+            c.bytes_out += hs + ws.payload.size();
+        }
+    }
+
+    template<typename D, typename Stats = stats::none>
+    requires std::is_trivially_copyable_v<D>
+    void encode_block(std::vector<std::uint8_t>& out, std::span<const D> src, std::size_t start, codec id,
+                      const lz77_params& lz = {}) {
+        workspace<D, Stats> ws;
+        encode_block<D, Stats>(out, src, start, id, lz, ws);
+    }
+
+    // ajoute à out un bloc contenant src codé avec le codec id
+    template<typename D, typename Stats = stats::none>
+    requires std::is_trivially_copyable_v<D>
+    void encode_block(std::vector<std::uint8_t>& out, std::span<const D> src, codec id,
+                      const lz77_params& lz = {}) {
+        encode_block<D, Stats>(out, src, 0, id, lz);
+    }
+
+    // ajoute à out un bloc contenant src codé avec le codec dict_* id et le dictionnaire dict
+    template<typename D, typename Stats = stats::none>
+    requires std::is_trivially_copyable_v<D>
+    void encode_block(std::vector<std::uint8_t>& out, std::span<const D> src, codec id,
+                      const dictionary::Dictionary<D>& dict, const lz77_params& lz = {}) {
+        workspace<D, Stats> ws;
+        encode_block<D, Stats>(out, src, 0, id, lz, ws, &dict);
+    }
+
+    // écrit le bloc dans out sans allouer (une fois ws à sa taille) ; renvoie sa taille,
+    // nullopt si out est trop petit (max_compressed_size suffit toujours)
+    template<typename D, typename Stats>
+    requires std::is_trivially_copyable_v<D>
+    [[nodiscard]]
+    std::optional<std::size_t> encode_block_into(std::span<std::uint8_t> out, std::span<const D> src, std::size_t start,
+                                                 codec id, const lz77_params& lz, workspace<D, Stats>& ws,
+                                                 const dictionary::Dictionary<D>* dict = nullptr) {
+        [[maybe_unused]] typename Stats::timer t(stats::stage::block_encode);
+        std::uint8_t head[max_header_size];
+        const std::size_t hs = detail::prepare_block<D, Stats>(head, src, start, id, lz, ws, dict);
+        const std::size_t total = hs + ws.payload.size();
+        if (total > out.size()) return std::nullopt;
+        std::memcpy(out.data(), head, hs);
+        if (!ws.payload.empty()) std::memcpy(out.data() + hs, ws.payload.data(), ws.payload.size());
+        if constexpr (Stats::enabled) {
+            auto& c = Stats::local();
+            c.bytes_in += (src.size() - start) * sizeof(D);
+            c.bytes_out += total;
+        }
+        return total;
+    }
+
+    template<typename D, typename Stats>
+    requires std::is_trivially_copyable_v<D>
+    [[nodiscard]]
+    std::optional<std::size_t> encode_block_into(std::span<std::uint8_t> out, std::span<const D> src, codec id,
+                                                 const lz77_params& lz, workspace<D, Stats>& ws,
+                                                 const dictionary::Dictionary<D>* dict = nullptr) {
+        return encode_block_into<D, Stats>(out, src, 0, id, lz, ws, dict);
+    }
+
+    template<typename D>
+    requires std::is_trivially_copyable_v<D>
+    [[nodiscard]]
+    std::vector<std::uint8_t> encode(std::span<const D> src, codec id, const lz77_params& lz = {}) {
+        std::vector<std::uint8_t> out;
+        encode_block<D>(out, src, id, lz);
+        return out;
+    }
+
+    template<typename D>
+    requires std::is_trivially_copyable_v<D>
+    [[nodiscard]]
+    std::vector<std::uint8_t> encode(std::span<const D> src, codec id, const dictionary::Dictionary<D>& dict,
+                                     const lz77_params& lz = {}) {
+        std::vector<std::uint8_t> out;
+        encode_block<D>(out, src, id, dict, lz);
+        return out;
+    }
+
+    // nullopt si l'en-tête est tronqué ou invalide
+    [[nodiscard]]
+    inline std::optional<block_header> read_header(std::span<const std::uint8_t> in) noexcept {
+        if (in.size() < 4 || in[0] != 'D' || in[1] != 'C' || in[2] > static_cast<std::uint8_t>(codec::dict_rans))
+            return std::nullopt;
+        block_header h;
+        h.id = static_cast<codec>(in[2]);
+        h.symbol_size = in[3];
+        const std::uint8_t* p = in.data() + 4;
+        const std::uint8_t* const end = in.data() + in.size();
+        const auto nb = utils::get_varint(p, end);
+        const auto size = utils::get_varint(p, end);
+        if (!nb || !size || end - p < 4) return std::nullopt;
+        h.nb_symbols = static_cast<std::size_t>(*nb);
+        h.payload_size = static_cast<std::size_t>(*size);
+        h.checksum = detail::get_u32(p);
+        p += 4;
+        h.header_size = static_cast<std::size_t>(p - in.data());
+        if (h.payload_size > in.size() - h.header_size) return std::nullopt;
+        return h;
+    }
+
+    // décode le bloc en tête de in dans out[start, start + nb_symbols), out[0, start) tenant
+    // l'historique donné au codage ; renvoie le nombre d'octets du bloc, nullopt si le bloc
+    // est invalide ou corrompu. Un bloc dict_* demande le dictionnaire de son codage.
+    template<typename D, typename Stats>
+    requires std::is_trivially_copyable_v<D>
+    [[nodiscard]]
+    std::optional<std::size_t> decode_block(std::span<const std::uint8_t> in, std::span<D> out, std::size_t start,
+                                            workspace<D, Stats>& ws, const dictionary::Dictionary<D>* dict = nullptr) {
+        [[maybe_unused]] typename Stats::timer t(stats::stage::block_decode);
+        const auto h = read_header(in);
+        if (!h || h->symbol_size != sizeof(D) || start > out.size() || h->nb_symbols > out.size() - start)
+            return std::nullopt;
+        auto payload = in.subspan(h->header_size, h->payload_size);
+        const auto dst = out.subspan(start, h->nb_symbols);
+        bool ok = false;
+        switch (h->id) {
+            case codec::stored:
+                ok = payload.size() == dst.size_bytes();
+                if (ok) detail::get_symbols<D>(payload.data(), dst);
+                break;
+            case codec::huffman: ok = detail::huffman_decode<D, Stats>(payload, dst, ws.huffman); break;
+            case codec::lz77:    ok = detail::lz77_decode<D, Stats>(payload, out.first(start + h->nb_symbols), start); break;
+            case codec::rle:     ok = detail::rle_decode<D>(payload, dst);     break;
+            case codec::rans:    ok = detail::rans_decode<D, Stats>(payload, dst, ws.rans); break;
+            case codec::dict_lz77:
+                ok = detail::dict_header<D>(payload, dict)
+                  && detail::lz77_decode<D, Stats>(payload, out.first(start + h->nb_symbols), start, dict->content());
+                break;
+            case codec::dict_huffman:
+                ok = detail::dict_header<D>(payload, dict)
+                  && lossless::Huffman<D>::decode_into(dict->huffman_decoder(), payload, dst).has_value();
+                break;
+            case codec::dict_rans:
+                ok = detail::dict_header<D>(payload, dict)
+                  && lossless::Rans<D>::decode_into(dict->rans_decoder(), payload, dst).has_value();
+                break;
+        }
+        if (!ok || detail::checksum<D>(dst) != h->checksum) return std::nullopt;
+        return h->header_size + h->payload_size;
+    }
+
+    template<typename D, typename Stats = stats::none>
+    requires std::is_trivially_copyable_v<D>
+    [[nodiscard]]
+    std::optional<std::size_t> decode_block(std::span<const std::uint8_t> in, std::span<D> out, std::size_t start) {
+        workspace<D, Stats> ws;
+        return decode_block<D, Stats>(in, out, start, ws);
+    }
+
+    // décode le bloc en tête de in dans out (au moins nb_symbols places) ;
+    // renvoie le nombre d'octets du bloc, nullopt si le bloc est invalide ou corrompu
+    template<typename D, typename Stats = stats::none>
+    requires std::is_trivially_copyable_v<D>
+    [[nodiscard]]
+    std::optional<std::size_t> decode_block(std::span<const std::uint8_t> in, std::span<D> out) {
+        return decode_block<D, Stats>(in, out, 0);
+    }
+
+    // décode dans out un bloc codé avec le dictionnaire dict (ou sans dictionnaire)
+    template<typename D, typename Stats = stats::none>
+    requires std::is_trivially_copyable_v<D>
+    [[nodiscard]]
+    std::optional<std::size_t> decode_block(std::span<const std::uint8_t> in, std::span<D> out,
+                                            const dictionary::Dictionary<D>& dict) {
+        workspace<D, Stats> ws;
+        return decode_block<D, Stats>(in, out, 0, ws, &dict);
+    }
+
+    namespace detail {
+
+        // nombre maximal de symboles que le payload du bloc h peut produire : exact pour stored,
+        // rle et lz77 (lecture des longueurs), au moins un bit par symbole pour Huffman, au
+        // moins 2^-scale_bits bit par symbole pour rANS (sans borne pour un seul symbole)
+        template<typename D>
+        [[nodiscard]] std::uint64_t max_block_symbols(const block_header& h, std::span<const std::uint8_t> payload) noexcept {
+            constexpr auto unbounded = std::numeric_limits<std::uint64_t>::max();
+            const std::uint64_t bits = std::uint64_t{8} * payload.size();
+            switch (h.id) {
+                case codec::stored:       return payload.size() / sizeof(D);
+                case codec::huffman:
+                case codec::dict_huffman: return bits;
+                case codec::rle:          return lossless::RunLength<D>::decoded_size(payload).value_or(0);
+                case codec::lz77:         return lz77_size<D>(payload).value_or(0);
+                case codec::dict_lz77:    return payload.size() < 4 ? 0 : lz77_size<D>(payload.subspan(4)).value_or(0);
+                case codec::rans:
+                    if (payload.empty() || payload[0] > lossless::Rans<D>::max_scale_bits) return 0;
+                    return payload[0] == 0 ? unbounded : bits << payload[0];
+                case codec::dict_rans:    return bits << lossless::Rans<D>::max_scale_bits;
+            }
+            return 0;
+        }
+
+    } // namespace detail
+
+    // max_symbols : plafond de l'appelant ; au-delà, ou au-delà de ce que le payload peut
+    // produire, nullopt sans allouer
+    template<typename D>
+    requires std::is_trivially_copyable_v<D>
+    [[nodiscard]]
+    std::optional<std::vector<D>> decode(std::span<const std::uint8_t> in,
+                                         const dictionary::Dictionary<D>* dict = nullptr,
+                                         std::size_t max_symbols = default_max_bytes / sizeof(D)) {
+        const auto h = read_header(in);
+        if (!h || h->symbol_size != sizeof(D) || h->nb_symbols > max_symbols) return std::nullopt;
+        // un bloc ne peut pas annoncer plus de symboles que son codec ne sait en produire
+        if (h->nb_symbols > detail::max_block_symbols<D>(*h, in.subspan(h->header_size, h->payload_size)))
+            return std::nullopt;
+        std::vector<D> out(h->nb_symbols);
+        workspace<D> ws;
+        if (!decode_block<D>(in, std::span<D>(out), 0, ws, dict)) return std::nullopt;
+        return out;
+    }
+
+    template<typename D>
+    requires std::is_trivially_copyable_v<D>
+    [[nodiscard]]
+    std::optional<std::vector<D>> decode(std::span<const std::uint8_t> in, const dictionary::Dictionary<D>& dict,
+                                         std::size_t max_symbols = default_max_bytes / sizeof(D)) {
+        return decode<D>(in, &dict, max_symbols);
+    }
+
+} // namespace encoding::container
@@ -0,0 +1,242 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <string_view>
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#include <optional>
+#include <span>
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <system_error>
+#include "io.hpp"
+#include "stream.hpp"
+#include "pipeline.hpp"
+
+// dc : compression de fichiers.
+// L'entrée est projetée en mémoire (pread si --no-mmap ou si la projection échoue) et passée
+// par morceaux à stream::Encoder / Decoder ; la sortie part par io::AsyncWriter, en double
+// tampon. Mémoire bornée par le bloc, l'historique du codec et les tampons d'écriture, quelle
+// que soit la taille du fichier.
+//
+// Format : 'D' 'F' | codec (u8) | niveau (u8) | flux stream ('D' 'S' ...)
+//
+// Usage : dc c|d [options] entrée [sortie]
+//   -c CODEC    stored, huffman, rle, rans, lz77 (défaut), deflate, deflate-rans
+//   -l N        niveau LZ77 1..9 (défaut 6)
+//   -b N        taille de bloc en Kio, 1..65536 (défaut 1024)
+//   --no-mmap   lecture par pread
+//   -f          remplace une sortie existante
+//   -q          sans rapport
+// Sortie par défaut : entrée + ".dc" en compression, entrée sans ".dc" (ou + ".out") en
+// décompression. Le rapport (débit, pic de mémoire résidente) va sur la sortie d'erreur.
+
+namespace {
+
+    using namespace encoding;
+    using clock_type = std::chrono::steady_clock;
+
+    enum class codec_id : std::uint8_t { stored, huffman, rle, rans, lz77, deflate, deflate_rans };
+
+    constexpr std::array<std::string_view, 7> codec_names{"stored", "huffman", "rle", "rans", "lz77", "deflate", "deflate-rans"};
+
+    // plus grand bloc écrit par -b et accepté à la décompression (celui de stream::Decoder)
+    constexpr std::size_t max_block_size = std::size_t{1} << 26;
+
+    struct options {
+        bool        compress   = true;
+        codec_id    codec      = codec_id::lz77;
+        int         level      = 6;
+        std::size_t block_size = std::size_t{1} << 20;
+        bool        use_map    = true;
+        bool        quiet      = false;
+        bool        force      = false;
+        std::string input, output;
+    };
+
+    [[noreturn]] void usage() {
+        std::cerr << "usage : dc c|d [-c stored|huffman|rle|rans|lz77|deflate|deflate-rans] [-l 1..9] [-b 1..65536 Kio]\n"
+                     "              [--no-mmap] [-f] [-q] entrée [sortie]\n";
+        std::exit(2);
+    }
+
+    [[nodiscard]] std::optional<codec_id> find_codec(std::string_view name) {
+        for (std::size_t i = 0; i < codec_names.size(); ++i)
+            if (codec_names[i] == name) return static_cast<codec_id>(i);
+        return std::nullopt;
+    }
+
+    // taille de bloc de -b (Kio) en octets ; nullopt si ce n'est pas un entier de 1 à
+    // max_block_size / 1024
+    [[nodiscard]] std::optional<std::size_t> parse_block_size(std::string_view arg) {
+        std::size_t kib = 0;
+        const auto [end, ec] = std::from_chars(arg.data(), arg.data() + arg.size(), kib);
+        if (ec != std::errc{} || end != arg.data() + arg.size() || kib == 0 || kib > (max_block_size >> 10))
+            return std::nullopt;
+        return kib << 10;
+    }
+
+    // niveau de -l ; nullopt si ce n'est pas un entier de 1 à 9
+    [[nodiscard]] std::optional<int> parse_level(std::string_view arg) {
+        int level = 0;
+        const auto [end, ec] = std::from_chars(arg.data(), arg.data() + arg.size(), level);
+        if (ec != std::errc{} || end != arg.data() + arg.size() || level < 1 || level > 9) return std::nullopt;
+        return level;
+    }
+
+    options parse_options(int argc, char** argv) {
+        if (argc < 3) usage();
+        options opt;
+        const std::string_view mode = argv[1];
+        if (mode == "c") opt.compress = true;
+        else if (mode == "d") opt.compress = false;
+        else usage();
+        int positional = 0;
+        for (int i = 2; i < argc; ++i) {
+            const std::string_view a = argv[i];
+            const auto next = [&]() -> const char* {
+                if (i + 1 >= argc) usage();
+                return argv[++i];
+            };
+            if (a == "-c") {
+                const auto c = find_codec(next());
+                if (!c) usage();
+                opt.codec = *c;
+            }
+            else if (a == "-l") {
+                const auto l = parse_level(next());
+                if (!l) usage();
+                opt.level = *l;
+            }
+            else if (a == "-b") {
+                const auto b = parse_block_size(next());
+                if (!b) usage();
+                opt.block_size = *b;
+            }
+            else if (a == "--no-mmap") opt.use_map = false;
+            else if (a == "-q") opt.quiet = true;
+            else if (a == "-f") opt.force = true;
+            else if (a.starts_with("-")) usage();
+            else if (positional == 0) { opt.input = a; ++positional; }
+            else if (positional == 1) { opt.output = a; ++positional; }
+            else usage();
+        }
+        if (opt.input.empty()) usage();
+        if (opt.output.empty()) {
+            if (opt.compress) opt.output = opt.input + ".dc";
+            else if (opt.input.ends_with(".dc")) opt.output = opt.input.substr(0, opt.input.size() - 3);
+            else opt.output = opt.input + ".out";
+        }
+        return opt;
+    }
+
+    // appelle f avec le codec de flux correspondant à id
+    template<typename F>
+    decltype(auto) with_codec(codec_id id, int level, F&& f) {
+        container::lz77_params lz;
+        lz.level = level;
+        switch (id) {
+            case codec_id::stored:  return f(parallel::container_codec<std::uint8_t>{container::codec::stored, lz});
+            case codec_id::huffman: return f(parallel::container_codec<std::uint8_t>{container::codec::huffman, lz});
+            case codec_id::rle:     return f(parallel::container_codec<std::uint8_t>{container::codec::rle, lz});
+            case codec_id::rans:    return f(parallel::container_codec<std::uint8_t>{container::codec::rans, lz});
+            case codec_id::lz77:    return f(stream::lz77_codec<std::uint8_t>{lz});
+            case codec_id::deflate: return f(pipeline::pipeline_codec<pipeline::Deflate<std::uint8_t>>{lz});
+            case codec_id::deflate_rans:
+            default:                return f(pipeline::pipeline_codec<pipeline::DeflateRans<std::uint8_t>>{lz});
+        }
+    }
+
+    // morceaux lus à la fois : plusieurs blocs, pour que les codecs à blocs indépendants
+    // codent directement dans la projection
+    [[nodiscard]] std::size_t read_size(std::size_t block_size) {
+        return block_size * std::max<std::size_t>(1, (std::size_t{8} << 20) / block_size);
+    }
+
+    [[nodiscard]] bool compress(const options& opt, io::InputFile& in, io::AsyncWriter& out) {
+        const std::uint8_t head[] = {'D', 'F', static_cast<std::uint8_t>(opt.codec), static_cast<std::uint8_t>(opt.level)};
+        out.write(head);
+        return with_codec(opt.codec, opt.level, [&](auto codec) {
+            stream::Encoder<std::uint8_t, decltype(codec)> enc(std::move(codec),
+                [&](std::span<const std::uint8_t> b){ out.write(b); }, opt.block_size);
+            const std::size_t chunk = read_size(opt.block_size);
+            for (std::uint64_t pos = 0; pos < in.size();) {
+                const auto s = in.read(pos, chunk);
+                if (!s || s->empty()) return false;
+                enc.write(*s);
+                pos += s->size();
+                in.release(pos);
+            }
+            enc.finish();
+            return true;
+        });
+    }
+
+    [[nodiscard]] bool decompress(io::InputFile& in, io::AsyncWriter& out) {
+        const auto head = in.read(0, 4);
+        if (!head || head->size() != 4 || (*head)[0] != 'D' || (*head)[1] != 'F'
+            || (*head)[2] >= codec_names.size() || (*head)[3] < 1 || (*head)[3] > 9) return false;
+        const auto id = static_cast<codec_id>((*head)[2]);
+        std::uint64_t pos = 4;
+        bool read_error = false;
+        return with_codec(id, (*head)[3], [&](auto codec) {
+            stream::Decoder<std::uint8_t, decltype(codec)> dec(std::move(codec), [&](std::span<std::uint8_t> buf) -> std::size_t {
+                const auto s = in.read(pos, buf.size());
+                if (!s) { read_error = true; return 0; }
+                std::copy(s->begin(), s->end(), buf.begin());
+                pos += s->size();
+                in.release(pos);
+                return s->size();
+            }, max_block_size);
+            // le décodeur écrit directement dans le tampon de sortie
+            while (!dec.finished()) {
+                const auto n = dec.read(out.buffer());
+                if (!n) return false;
+                out.commit(*n);
+            }
+            return !read_error && pos == in.size();
+        });
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const options opt = parse_options(argc, argv);
+
+    auto in = io::InputFile::open(opt.input.c_str(), opt.use_map);
+    if (!in) { std::cerr << "dc : impossible de lire " << opt.input << "\n"; return 1; }
+    if (!opt.force && ::access(opt.output.c_str(), F_OK) == 0) {
+        std::cerr << "dc : " << opt.output << " existe déjà (-f pour le remplacer)\n";
+        return 1;
+    }
+    auto out = io::AsyncWriter::create(opt.output.c_str());
+    if (!out) { std::cerr << "dc : impossible de créer " << opt.output << "\n"; return 1; }
+
+    const auto t0 = clock_type::now();
+    bool ok = opt.compress ? compress(opt, *in, *out) : decompress(*in, *out);
+    const std::uint64_t written = out->bytes();
+    ok = out->finish() && ok;
+    const double secs = std::chrono::duration<double>(clock_type::now() - t0).count();
+    if (!ok) {
+        std::cerr << "dc : " << (opt.compress ? "échec de la compression de " : "flux invalide ou tronqué : ")
+                  << opt.input << "\n";
+        std::remove(opt.output.c_str());
+        return 1;
+    }
+
+    if (!opt.quiet) {
+        // débit rapporté aux octets non compressés
+        const std::uint64_t raw = opt.compress ? in->size() : written;
+        const std::uint64_t packed = opt.compress ? written : in->size();
+        std::cerr << std::fixed << std::setprecision(3)
+                  << opt.input << " -> " << opt.output << " : " << in->size() << " -> " << written << " octets"
+                  << ", taux " << (raw ? static_cast<double>(packed) / static_cast<double>(raw) : 0.0)
+                  << std::setprecision(1)
+                  << ", " << (secs > 0 ? static_cast<double>(raw) / secs / 1e6 : 0.0) << " Mo/s"
+                  << ", pic RSS " << static_cast<double>(io::peak_rss()) / (1 << 20) << " Mio"
+                  << (in->mapped() ? " (mmap)" : " (pread)") << "\n";
+    }
+    return 0;
+}
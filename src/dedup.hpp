@@ -0,0 +1,296 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <utility>
+#include <algorithm>
+#include <optional>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <bit>
+#include <type_traits>
+#include "container.hpp"
+#include "stream.hpp"
+#include "utils.hpp"
+
+namespace encoding::dedup {
+
+    // ===== Déduplication à longue distance avant LZ77 =====
+    // Des répétitions à des distances bien plus grandes que la fenêtre LZ77 (sauvegardes,
+    // images disque) échappent à l'analyse. Le Deduplicator découpe l'entrée en morceaux
+    // définis par le contenu (hachage roulant Gear : une coupure dépend des 64 derniers
+    // symboles, elle se retrouve après une insertion ou une suppression) et garde dans un
+    // index de taille fixe l'empreinte de chaque morceau. Un morceau déjà vu devient une
+    // référence longue, vérifiée symbole à symbole puis prolongée dans les deux sens ; le reste
+    // (les littéraux) passe par un codec de flux, stream::lz77_codec par défaut.
+    // Format : 'D' 'L' | sizeof(D) (u8) | nb_symbols | taille du flux de littéraux (varints)
+    //          | crc32 (u32 LE) | flux de littéraux ('D' 'S' ...) | nb_refs | nb_refs fois
+    //          (littéraux avant, distance, longueur) (varints).
+
+    struct params {
+        std::size_t min_chunk   = 2048;                  // symboles ; pas de coupure avant
+        std::size_t avg_chunk   = 8192;                  // probabilité de coupure 1 / avg_chunk au-delà
+        std::size_t max_chunk   = 65536;                 // coupure forcée
+        std::size_t min_match   = 1024;                  // longueur minimale d'une référence
+        std::size_t index_bytes = std::size_t{64} << 20; // mémoire de l'index d'empreintes
+    };
+
+    // référence longue : literals symboles littéraux, puis length symboles copiés distance plus tôt
+    struct ref {
+        std::uint64_t literals = 0;
+        std::uint64_t distance = 0;
+        std::uint64_t length   = 0;
+    };
+
+    namespace detail {
+
+        // table Gear : 256 constantes pseudo-aléatoires (splitmix64)
+        inline constexpr auto gear_table = [] {
+            std::array<std::uint64_t, 256> t{};
+            std::uint64_t x = 0x2545F4914F6CDD1Dull;
+            for (auto& v : t) {
+                x += 0x9E3779B97F4A7C15ull;
+                std::uint64_t z = x;
+                z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+                z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+                v = z ^ (z >> 31);
+            }
+            return t;
+        }();
+
+        template<typename D>
+        [[nodiscard]] inline std::uint64_t gear(const D& d) noexcept {
+            const std::uint64_t k = utils::symbol_key(d);
+            if constexpr (sizeof(D) == 1) return gear_table[k & 0xFF];
+            else return gear_table[(k * 0x9E3779B97F4A7C15ull) >> 56];
+        }
+
+        // empreinte 64 bits d'un morceau ; les symboles d'un octet sont lus par mots de 8
+        template<typename D>
+        [[nodiscard]] std::uint64_t fingerprint(const D* p, std::size_t n) noexcept {
+            std::uint64_t h = 0xCBF29CE484222325ull ^ n;
+            std::size_t i = 0;
+            if constexpr (sizeof(D) == 1 && std::is_trivially_copyable_v<D>) {
+                for (; i + 8 <= n; i += 8) {
+                    std::uint64_t w;
+                    std::memcpy(&w, p + i, 8);
+                    h = std::rotl((h ^ w) * 0x9E3779B97F4A7C15ull, 29);
+                }
+            }
+            for (; i < n; ++i) h = std::rotl((h ^ utils::symbol_key(p[i])) * 0x9E3779B97F4A7C15ull, 29);
+            return h ^ (h >> 32);
+        }
+
+    } // namespace detail
+
+    // ===== Deduplicator : découpage et index d'empreintes =====
+    // L'index est une table de 2^k entrées (empreinte, position) : assez pour un morceau sur
+    // deux cases, sans dépasser index_bytes. Une nouvelle entrée remplace l'ancienne de même
+    // case, si bien que la mémoire reste bornée quelle que soit la longueur de l'historique.
+    // La mémoire de la table est réutilisée d'un appel à l'autre.
+    template<typename D>
+    requires std::is_trivially_copyable_v<D>
+    class Deduplicator {
+    private:
+        struct entry {
+            std::uint64_t fp  = 0;
+            std::size_t   pos = nil;
+        };
+        static constexpr std::size_t nil = static_cast<std::size_t>(-1);
+        static constexpr std::size_t max_skip = 16; // symboles modifiés sautés pour reprendre une copie
+
+        params             m_params;
+        std::vector<entry> m_index;
+        unsigned           m_max_bits;
+        unsigned           m_bits = 0;
+        unsigned           m_cut_bits;
+
+        // fin du morceau qui commence en pos
+        [[nodiscard]] std::size_t cut(std::span<const D> src, std::size_t pos) const noexcept {
+            const std::size_t n = src.size();
+            const std::size_t lo = std::min(n, pos + m_params.min_chunk);
+            const std::size_t hi = std::min(n, pos + m_params.max_chunk);
+            if (lo >= hi) return hi;
+            // le hachage ne dépend que des 64 derniers symboles : inutile de rouler avant
+            std::uint64_t h = 0;
+            for (std::size_t i = lo - std::min<std::size_t>(lo - pos, 64); i < lo; ++i) h = (h << 1) + detail::gear(src[i]);
+            for (std::size_t i = lo; i < hi; ++i) {
+                h = (h << 1) + detail::gear(src[i]);
+                if ((h >> (64 - m_cut_bits)) == 0) return i + 1;
+            }
+            return hi;
+        }
+
+    public:
+        explicit Deduplicator(const params& p = {}) : m_params(p) {
+            m_params.min_chunk = std::max<std::size_t>(m_params.min_chunk, 1);
+            m_params.max_chunk = std::max(m_params.max_chunk, m_params.min_chunk);
+            m_params.min_match = std::max<std::size_t>(m_params.min_match, 1);
+            const std::size_t slots = std::bit_floor(std::max<std::size_t>(m_params.index_bytes / sizeof(entry), 1));
+            m_max_bits = static_cast<unsigned>(std::countr_zero(slots));
+            m_cut_bits = static_cast<unsigned>(std::clamp<int>(std::bit_width(std::max<std::size_t>(m_params.avg_chunk, 2)) - 1, 1, 63));
+        }
+
+        [[nodiscard]] const params& parameters() const noexcept { return m_params; }
+        [[nodiscard]] std::size_t index_bytes() const noexcept { return m_index.size() * sizeof(entry); }
+
+        // découpe src : literal(span) pour chaque suite de littéraux, match(distance, length) pour
+        // chaque référence. L'index repart de zéro à chaque appel (positions relatives à src).
+        template<typename Literal, typename Match>
+        void parse(std::span<const D> src, Literal&& literal, Match&& match) {
+            const std::size_t chunks = src.size() / m_params.min_chunk + 1;
+            m_bits = std::min(m_max_bits, static_cast<unsigned>(std::bit_width(2 * chunks - 1)));
+            m_index.assign(std::size_t{1} << m_bits, entry{});
+            const std::size_t n = src.size();
+            const D* const s = src.data();
+            std::size_t lit_start = 0;
+            std::size_t pos = 0;
+            while (pos < n) {
+                const std::size_t end = cut(src, pos);
+                const std::size_t len = end - pos;
+                const std::uint64_t fp = detail::fingerprint(s + pos, len);
+                entry& e = m_index[m_bits ? static_cast<std::size_t>(fp >> (64 - m_bits)) : 0];
+                std::size_t next = end;
+                if (e.pos != nil && e.fp == fp && std::equal(s + pos, s + end, s + e.pos)) {
+                    // prolonge vers l'arrière (littéraux en attente) puis vers l'avant
+                    std::size_t b = pos, c = e.pos;
+                    while (b > lit_start && c > 0 && s[b - 1] == s[c - 1]) { --b; --c; }
+                    const std::size_t dist = b - c;
+                    const auto extend = [&](std::size_t f) {
+                        while (f < n && s[f] == s[f - dist]) ++f;
+                        return f;
+                    };
+                    std::size_t f = extend(end);
+                    if (f - b >= m_params.min_match) {
+                        if (b > lit_start) literal(src.subspan(lit_start, b - lit_start));
+                        match(static_cast<std::uint64_t>(dist), static_cast<std::uint64_t>(f - b));
+                        lit_start = f;
+                        // quelques symboles modifiés dans une copie : la suite reprend souvent à la
+                        // même distance, sans attendre que le découpage se recale
+                        for (std::size_t q = f + 1; q < n && q <= f + max_skip;) {
+                            const std::size_t g = extend(q);
+                            if (g - q < m_params.min_match) { ++q; continue; }
+                            literal(src.subspan(lit_start, q - lit_start));
+                            match(static_cast<std::uint64_t>(dist), static_cast<std::uint64_t>(g - q));
+                            lit_start = f = g;
+                            q = g + 1;
+                        }
+                        next = f;
+                    }
+                }
+                e = entry{fp, pos};
+                pos = next;
+            }
+            if (lit_start < n) literal(src.subspan(lit_start));
+        }
+    };
+
+    // ===== Codage complet : références longues + flux de littéraux =====
+    template<typename D, typename Codec = stream::lz77_codec<D>>
+    requires stream::stream_codec<Codec, D>
+    void encode(std::span<const D> src, std::vector<std::uint8_t>& out, Deduplicator<D>& dd,
+                const Codec& codec = {}, std::size_t block_size = std::size_t{1} << 20) {
+        std::vector<std::uint8_t> lits;
+        std::vector<ref> refs;
+        std::uint64_t pending = 0;
+        {
+            stream::Encoder<D, Codec> enc(codec, [&](std::span<const std::uint8_t> b){ lits.insert(lits.end(), b.begin(), b.end()); },
+                                          block_size);
+            dd.parse(src,
+                     [&](std::span<const D> l) { enc.write(l); pending += l.size(); },
+                     [&](std::uint64_t dist, std::uint64_t len) { refs.push_back({pending, dist, len}); pending = 0; });
+            enc.finish();
+        }
+
+        out.insert(out.end(), {'D', 'L', static_cast<std::uint8_t>(sizeof(D))});
+        utils::put_varint(out, src.size());
+        utils::put_varint(out, lits.size());
+        std::uint8_t crc[4];
+        container::detail::put_u32(crc, container::detail::checksum<D>(src));
+        out.insert(out.end(), crc, crc + 4);
+        out.insert(out.end(), lits.begin(), lits.end());
+        utils::put_varint(out, refs.size());
+        for (auto& r : refs) {
+            utils::put_varint(out, r.literals);
+            utils::put_varint(out, r.distance);
+            utils::put_varint(out, r.length);
+        }
+    }
+
+    template<typename D, typename Codec = stream::lz77_codec<D>>
+    requires stream::stream_codec<Codec, D>
+    [[nodiscard]]
+    std::vector<std::uint8_t> compress(std::span<const D> src, const params& p = {}, const Codec& codec = {},
+                                       std::size_t block_size = std::size_t{1} << 20) {
+        std::vector<std::uint8_t> out;
+        Deduplicator<D> dd(p);
+        encode<D, Codec>(src, out, dd, codec, block_size);
+        return out;
+    }
+
+    // nullopt si le flux est tronqué, incohérent ou corrompu (crc), ou s'il annonce plus de
+    // max_symbols symboles (refusé avant toute allocation)
+    template<typename D, typename Codec = stream::lz77_codec<D>>
+    requires stream::stream_codec<Codec, D>
+    [[nodiscard]]
+    std::optional<std::vector<D>> decompress(std::span<const std::uint8_t> in, const Codec& codec = {},
+                                             std::size_t max_symbols = container::default_max_bytes / sizeof(D)) {
+        if (in.size() < 3 || in[0] != 'D' || in[1] != 'L' || in[2] != sizeof(D)) return std::nullopt;
+        const std::uint8_t* p = in.data() + 3;
+        const std::uint8_t* const end = in.data() + in.size();
+        const auto nb = utils::get_varint(p, end);
+        const auto lits_size = utils::get_varint(p, end);
+        if (!nb || !lits_size || *nb > max_symbols || end - p < 4) return std::nullopt;
+        const std::uint32_t checksum = container::detail::get_u32(p);
+        p += 4;
+        if (*lits_size > static_cast<std::uint64_t>(end - p)) return std::nullopt;
+        auto lits = std::span<const std::uint8_t>(p, static_cast<std::size_t>(*lits_size));
+        p += lits.size();
+
+        // références d'abord : leurs longueurs bornent la sortie avant toute allocation
+        const auto nb_refs = utils::get_varint(p, end);
+        if (!nb_refs || *nb_refs > static_cast<std::uint64_t>(end - p) / 3) return std::nullopt;
+        std::vector<ref> refs(static_cast<std::size_t>(*nb_refs));
+        std::uint64_t total = 0;
+        for (auto& r : refs) {
+            const auto l = utils::get_varint(p, end), d = utils::get_varint(p, end), n = utils::get_varint(p, end);
+            if (!l || !d || !n || *d == 0 || *l > *nb || *n > *nb) return std::nullopt;
+            r = {*l, *d, *n};
+            total += *l + *n;
+            if (total > *nb) return std::nullopt;
+        }
+        if (p != end) return std::nullopt;
+
+        std::vector<D> out(static_cast<std::size_t>(*nb));
+        stream::Decoder<D, Codec> dec(codec, [&](std::span<std::uint8_t> buf) {
+            const std::size_t k = std::min(buf.size(), lits.size());
+            std::copy_n(lits.begin(), k, buf.begin());
+            lits = lits.subspan(k);
+            return k;
+        });
+        std::size_t pos = 0;
+        const auto read_literals = [&](std::size_t k) {
+            const auto got = dec.read(std::span<D>(out).subspan(pos, k));
+            if (!got || *got != k) return false;
+            pos += k;
+            return true;
+        };
+        for (auto& r : refs) {
+            if (!read_literals(static_cast<std::size_t>(r.literals)) || r.distance > pos) return std::nullopt;
+            // recouvrement possible (distance < longueur) : même copie que les décodeurs LZ77
+            const std::size_t len = static_cast<std::size_t>(r.length);
+            utils::copy_match(out.data() + pos, static_cast<std::size_t>(r.distance), len);
+            pos += len;
+        }
+        if (!read_literals(out.size() - pos)) return std::nullopt;
+        D extra[1];
+        const auto tail = dec.read(extra);
+        if (!tail || *tail != 0 || !dec.finished()) return std::nullopt;
+        if (container::detail::checksum<D>(out) != checksum) return std::nullopt;
+        return out;
+    }
+
+} // namespace encoding::dedup
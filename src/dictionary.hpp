@@ -0,0 +1,254 @@
+#pragma once
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <unordered_map>
+#include <queue>
+#include <optional>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <bit>
+#include <type_traits>
+#include "encoding_lossless.hpp"
+#include "utils.hpp"
+
+namespace encoding::dictionary {
+
+    // ===== Dictionnaire partagé pour petits messages =====
+    // Sur un message de quelques centaines d'octets, LZ77 part d'une fenêtre vide et Huffman
+    // doit construire et transmettre sa table : la mise en route coûte plus que le codage.
+    // Un Dictionary prépare une fois pour toutes :
+    //   - un contenu (fenêtre LZ77 préremplie) et son index de hachage, que l'analyse parcourt
+    //     après celui du message (utils::MatchFinder::set_base) ;
+    //   - des tables Huffman et rANS fixes, tirées des fréquences des échantillons.
+    // Il est immuable une fois construit : un même Dictionary se partage en lecture seule entre
+    // threads, et coder un message ne construit plus ni index du contenu ni table.
+    // Forme sérialisée : 'D' 'D' | sizeof(D) (u8) | taille du contenu | contenu | k | k symboles
+    //                    | k fréquences (varints). id() est le crc32 de cette forme ; les blocs
+    //                    container::codec::dict_* le rappellent pour refuser un autre dictionnaire.
+
+    struct train_params {
+        std::size_t max_size     = 16384; // symboles de contenu au plus
+        std::size_t segment_size = 32;    // taille des morceaux d'échantillons retenus
+        std::size_t kmer         = 6;     // longueur des motifs comptés
+    };
+
+    template<typename D>
+    requires std::is_trivially_copyable_v<D>
+    class Dictionary {
+    public:
+        using huffman_t = lossless::Huffman<D>;
+        using rans_t    = lossless::Rans<D>;
+        using finder_t  = utils::MatchFinder<D>;
+        using freq_t    = std::pair<D, std::size_t>;
+
+    private:
+        using symbols_t = lossless::RunLength<D>; // symboles en petit-boutiste
+
+        std::vector<D>                   m_content;
+        std::vector<freq_t>              m_freqs;
+        finder_t                         m_index;
+        typename huffman_t::code_table   m_codes;
+        typename huffman_t::decoder      m_huffman_dec;
+        typename rans_t::table           m_rans;
+        typename rans_t::enc_table       m_rans_enc;
+        typename rans_t::decoder         m_rans_dec;
+        std::uint32_t                    m_id = 0;
+
+        // hachage d'un motif de k symboles (même mélange que MatchFinder)
+        [[nodiscard]] static std::uint64_t kmer_hash(const D* p, std::size_t k) {
+            std::uint64_t h = 0;
+            for (std::size_t i = 0; i < k; ++i) h = (h ^ utils::symbol_key(p[i])) * 0x9E3779B97F4A7C15ull;
+            return h;
+        }
+
+        // contenu : morceaux d'échantillons qui couvrent les motifs présents dans le plus grand
+        // nombre d'échantillons. Choix glouton (score recalculé à la sortie de la file) : les
+        // motifs d'un morceau retenu ne comptent plus, le plus utile finit au plus près des
+        // messages (offsets courts).
+        [[nodiscard]] static std::vector<D> select_content(std::span<const std::vector<D>> samples,
+                                                           const train_params& p) {
+            const std::size_t k = std::max(p.kmer, finder_t::min_match);
+            const std::size_t seg = std::max(p.segment_size, k);
+
+            std::unordered_map<std::uint64_t, std::uint32_t> doc_freq;
+            std::vector<std::uint64_t> hashes;
+            for (auto& s : samples) {
+                hashes.clear();
+                for (std::size_t i = 0; i + k <= s.size(); ++i) hashes.push_back(kmer_hash(s.data() + i, k));
+                std::sort(hashes.begin(), hashes.end());
+                hashes.erase(std::unique(hashes.begin(), hashes.end()), hashes.end());
+                for (auto h : hashes) ++doc_freq[h];
+            }
+
+            struct candidate {
+                std::uint64_t score;
+                std::uint32_t sample;
+                std::uint32_t pos;
+                std::uint32_t len;
+                bool operator<(const candidate& o) const noexcept { return score < o.score; }
+            };
+            // un motif vu dans un seul échantillon n'aide pas les autres messages
+            const auto score = [&](const candidate& c) {
+                std::uint64_t sc = 0;
+                const D* base = samples[c.sample].data() + c.pos;
+                for (std::size_t i = 0; i + k <= c.len; ++i) {
+                    const auto it = doc_freq.find(kmer_hash(base + i, k));
+                    if (it != doc_freq.end() && it->second > 1) sc += it->second;
+                }
+                return sc;
+            };
+            std::priority_queue<candidate> queue;
+            for (std::size_t s = 0; s < samples.size(); ++s) {
+                const std::size_t n = samples[s].size();
+                if (n < k) continue;
+                for (std::size_t pos = 0; pos + k <= n; pos += seg / 2) {
+                    candidate c{0, static_cast<std::uint32_t>(s), static_cast<std::uint32_t>(pos),
+                                static_cast<std::uint32_t>(std::min(seg, n - pos))};
+                    c.score = score(c);
+                    if (c.score != 0) queue.push(c);
+                    if (pos + seg >= n) break;
+                }
+            }
+
+            std::vector<candidate> chosen;
+            std::size_t size = 0;
+            while (!queue.empty() && size < p.max_size) {
+                candidate c = queue.top();
+                queue.pop();
+                c.score = score(c);
+                if (c.score == 0) continue;
+                if (!queue.empty() && c.score < queue.top().score) { queue.push(c); continue; }
+                c.len = static_cast<std::uint32_t>(std::min<std::size_t>(c.len, p.max_size - size));
+                const D* base = samples[c.sample].data() + c.pos;
+                for (std::size_t i = 0; i + k <= c.len; ++i) {
+                    const auto it = doc_freq.find(kmer_hash(base + i, k));
+                    if (it != doc_freq.end()) it->second = 0;
+                }
+                chosen.push_back(c);
+                size += c.len;
+            }
+
+            std::vector<D> content;
+            content.reserve(size);
+            for (auto it = chosen.rbegin(); it != chosen.rend(); ++it) {
+                const D* base = samples[it->sample].data() + it->pos;
+                content.insert(content.end(), base, base + it->len);
+            }
+            return content;
+        }
+
+    public:
+        // content : fenêtre préremplie ; freqs : (symbole, fréquence > 0) des tables fixes.
+        // Les symboles absents des tables ne sont pas codables par dict_huffman / dict_rans
+        // (le bloc passe alors en stored). rANS n'a pas de table au-delà de 1 << 15 symboles.
+        Dictionary(std::vector<D> content, std::vector<freq_t> freqs)
+            : m_content(std::move(content)), m_freqs(std::move(freqs)),
+              m_index(std::max<std::size_t>(m_content.size(), 1), 1) {
+            m_index.reset(m_content);
+            m_index.insert_until(m_content.size());
+
+            typename huffman_t::workspace hw;
+            huffman_t::build_table_into(m_freqs, false, hw);
+            huffman_t::make_codes_into(hw.table, m_codes);
+            [[maybe_unused]] const bool ok = huffman_t::make_decoder_into(hw.table, m_huffman_dec);
+            assert(ok);
+
+            typename rans_t::workspace rw;
+            if (rans_t::build_table_into(m_freqs, rw)) {
+                m_rans = std::move(rw.tab);
+                rans_t::make_encoder_into(m_rans, m_rans_enc);
+                [[maybe_unused]] const bool rok = rans_t::make_decoder_into(m_rans, m_rans_dec);
+                assert(rok);
+            }
+
+            const auto bytes = serialize();
+            m_id = utils::crc32(bytes);
+        }
+
+        // l'index pointe dans m_content : pas de copie, mais un déplacement garde le tampon
+        Dictionary(const Dictionary&) = delete;
+        Dictionary& operator=(const Dictionary&) = delete;
+        Dictionary(Dictionary&&) noexcept = default;
+        Dictionary& operator=(Dictionary&&) noexcept = default;
+
+        // entraîne un dictionnaire sur des échantillons représentatifs des messages.
+        // Symboles d'un octet : les 256 valeurs reçoivent une fréquence d'au moins 1, pour que
+        // tout message reste codable avec les tables fixes.
+        [[nodiscard]]
+        static Dictionary train(std::span<const std::vector<D>> samples, const train_params& p = {}) {
+            std::vector<D> content = select_content(samples, p);
+
+            std::vector<freq_t> counts;
+            std::unordered_map<D, std::size_t> total;
+            for (auto& s : samples) {
+                lossless::detail::count_symbols<D, stats::none>(std::span<const D>(s), counts);
+                for (auto& [d,f] : counts) total[d] += f;
+            }
+            if constexpr (std::is_integral_v<D> && sizeof(D) == 1)
+                for (unsigned b = 0; b < 256; ++b) ++total[static_cast<D>(b)];
+            std::vector<freq_t> freqs(total.begin(), total.end());
+            std::sort(freqs.begin(), freqs.end(), [](const freq_t& a, const freq_t& b) {
+                return utils::symbol_key(a.first) < utils::symbol_key(b.first);
+            });
+            return Dictionary(std::move(content), std::move(freqs));
+        }
+
+        [[nodiscard]] std::vector<std::uint8_t> serialize() const {
+            std::vector<std::uint8_t> out{'D', 'D', static_cast<std::uint8_t>(sizeof(D))};
+            utils::put_varint(out, m_content.size());
+            std::size_t o = out.size();
+            out.resize(o + m_content.size() * sizeof(D));
+            if (!m_content.empty()) symbols_t::put_symbols(out.data() + o, m_content.data(), m_content.size());
+            utils::put_varint(out, m_freqs.size());
+            o = out.size();
+            out.resize(o + m_freqs.size() * sizeof(D));
+            for (auto& [d,f] : m_freqs) {
+                symbols_t::put_symbols(out.data() + o, &d, 1);
+                o += sizeof(D);
+            }
+            for (auto& [d,f] : m_freqs) utils::put_varint(out, f);
+            return out;
+        }
+
+        // nullopt si la forme sérialisée est tronquée ou invalide
+        [[nodiscard]] static std::optional<Dictionary> load(std::span<const std::uint8_t> in) {
+            if (in.size() < 3 || in[0] != 'D' || in[1] != 'D' || in[2] != sizeof(D)) return std::nullopt;
+            const std::uint8_t* p = in.data() + 3;
+            const std::uint8_t* const end = in.data() + in.size();
+            const auto size = utils::get_varint(p, end);
+            if (!size || *size > static_cast<std::size_t>(end - p) / sizeof(D)) return std::nullopt;
+            std::vector<D> content(static_cast<std::size_t>(*size));
+            if (!content.empty()) symbols_t::get_symbols(p, content.data(), content.size());
+            p += content.size() * sizeof(D);
+            const auto k = utils::get_varint(p, end);
+            if (!k || *k > static_cast<std::size_t>(end - p) / sizeof(D)) return std::nullopt;
+            std::vector<freq_t> freqs(static_cast<std::size_t>(*k));
+            for (auto& [d,f] : freqs) {
+                symbols_t::get_symbols(p, &d, 1);
+                p += sizeof(D);
+            }
+            for (auto& [d,f] : freqs) {
+                const auto v = utils::get_varint(p, end);
+                if (!v || *v == 0) return std::nullopt;
+                f = static_cast<std::size_t>(*v);
+            }
+            if (p != end) return std::nullopt;
+            return Dictionary(std::move(content), std::move(freqs));
+        }
+
+        [[nodiscard]] std::uint32_t id() const noexcept { return m_id; }
+        [[nodiscard]] std::span<const D> content() const noexcept { return m_content; }
+        [[nodiscard]] std::span<const freq_t> freqs() const noexcept { return m_freqs; }
+        [[nodiscard]] const finder_t& index() const noexcept { return m_index; }
+        [[nodiscard]] const typename huffman_t::code_table& huffman_codes() const noexcept { return m_codes; }
+        [[nodiscard]] const typename huffman_t::decoder& huffman_decoder() const noexcept { return m_huffman_dec; }
+        [[nodiscard]] const typename rans_t::table& rans_table() const noexcept { return m_rans; }
+        [[nodiscard]] const typename rans_t::enc_table& rans_encoder() const noexcept { return m_rans_enc; }
+        [[nodiscard]] const typename rans_t::decoder& rans_decoder() const noexcept { return m_rans_dec; }
+    };
+
+} // namespace encoding::dictionary
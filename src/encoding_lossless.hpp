@@ -9,6 +9,16 @@
 #include <optional>
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
+#include <span>
+#include <bit>
+#include <tuple>
+#include <cstring>
+#include <array>
+#include <limits>
+#include <cmath>
+#include <memory_resource>
+#include "stats.hpp"
 #include "utils.hpp"
 
 namespace encoding::lossless {
@@ -18,7 +28,7 @@ namespace encoding::lossless {
     struct CompressRepeating {
         [[nodiscard]]
         static std::pair<std::vector<std::pair<D, std::size_t>>, std::size_t>
-        encode(const std::vector<D>& source, const D& repeating) {
+        encode(std::span<const D> source, const D& repeating) {
             std::vector<std::pair<D, std::size_t>> encoded;
             encoded.reserve(source.size());
             std::size_t cnt = 0;
@@ -44,117 +54,1261 @@ namespace encoding::lossless {
         }
     };
 
-    // ===== Huffman (s’appuie sur utils::WeightedBinaryTree) =====
+    // ===== RunLength : RLE général, en-têtes varint dans un flux d'octets =====
+    // Suite de commandes « littéraux puis plage » : varint h = run << 1 | ext, puis
+    //   [varint x = nb_lit << 1 | change si ext] | nb_lit symboles littéraux (1 si !ext)
+    //   | [nouveau symbole de plage si change] ; le symbole de plage est ensuite répété run fois.
+    // Le symbole de plage vaut initialement D{} (zéro) : un littéral isolé entre deux plages
+    // de zéros coûte un octet d'en-tête plus le symbole.
+    // Symboles en petit-boutiste, comparés par représentation binaire (bit à bit sans perte).
+    // Les plages sont trouvées par utils::find_equal / find_triple / equal_run (SIMD).
     template<typename D>
+    requires std::is_trivially_copyable_v<D>
+    struct RunLength {
+        static constexpr std::size_t min_repeat = 3;
+
+        static std::uint8_t* put_symbols(std::uint8_t* out, const D* p, std::size_t n) noexcept {
+            if constexpr (std::endian::native == std::endian::little || sizeof(D) == 1)
+                std::memcpy(out, p, n * sizeof(D));
+            else
+                for (std::size_t i = 0; i < n; ++i) {
+                    const auto* b = reinterpret_cast<const std::uint8_t*>(p + i);
+                    std::reverse_copy(b, b + sizeof(D), out + i * sizeof(D));
+                }
+            return out + n * sizeof(D);
+        }
+
+        // remplissage par blocs de 16 octets (motif de symboles), le dernier bloc chevauchant le précédent
+        static void fill(D* dst, std::size_t n, const D& v) noexcept {
+            if constexpr (16 % sizeof(D) == 0) {
+                if (n * sizeof(D) >= 16) {
+                    std::uint8_t pat[16];
+                    for (std::size_t k = 0; k < 16; k += sizeof(D)) std::memcpy(pat + k, &v, sizeof(D));
+                    auto* d = reinterpret_cast<std::uint8_t*>(dst);
+                    const std::size_t bytes = n * sizeof(D);
+                    for (std::size_t i = 0; i + 16 <= bytes; i += 16) std::memcpy(d + i, pat, 16);
+                    std::memcpy(d + bytes - 16, pat, 16);
+                    return;
+                }
+            }
+            std::fill_n(dst, n, v);
+        }
+
+        static void get_symbols(const std::uint8_t* in, D* p, std::size_t n) noexcept {
+            if constexpr (std::endian::native == std::endian::little || sizeof(D) == 1)
+                std::memcpy(p, in, n * sizeof(D));
+            else
+                for (std::size_t i = 0; i < n; ++i)
+                    std::reverse_copy(in + i * sizeof(D), in + (i + 1) * sizeof(D), reinterpret_cast<std::uint8_t*>(p + i));
+        }
+
+        // ajoute le codage de src à out
+        template<typename Alloc>
+        static void encode(std::span<const D> src, std::vector<std::uint8_t, Alloc>& out) {
+            const D* p = src.data();
+            const std::size_t n = src.size();
+            std::size_t o = out.size();
+            // écriture directe dans out, agrandi par doublement puis ramené à la taille utile
+            auto room = [&](std::size_t need) -> std::uint8_t* {
+                if (out.size() - o < need) out.resize(std::max(out.size() * 2, o + need + n * sizeof(D) / 8));
+                return out.data() + o;
+            };
+            // littéraux p[lit, end) puis r répétitions de *run (changement de symbole si besoin)
+            D cur{};
+            auto command = [&](std::size_t lit, std::size_t end, const D* run, std::size_t r) {
+                const std::size_t nb_lit = end - lit;
+                const bool change = run && !utils::detail::same_bits(*run, cur);
+                const bool ext = change || nb_lit != 1;
+                std::uint8_t* w = room(2 * utils::max_varint_size + (nb_lit + 1) * sizeof(D));
+                w = utils::put_varint(w, static_cast<std::uint64_t>(r) << 1 | static_cast<std::uint64_t>(ext));
+                if (ext) w = utils::put_varint(w, static_cast<std::uint64_t>(nb_lit) << 1 | static_cast<std::uint64_t>(change));
+                w = put_symbols(w, p + lit, nb_lit);
+                if (change) { w = put_symbols(w, run, 1); cur = *run; }
+                o = static_cast<std::size_t>(w - out.data());
+            };
+            // une plage du symbole courant vaut dès une répétition, une autre à partir de min_repeat
+            std::size_t i = 0;
+            while (i < n) {
+                const std::size_t e = i + utils::find_equal(p + i, n - i, cur);
+                const std::size_t t = i + utils::find_triple(p + i, std::min(n, e + 2) - i);
+                const std::size_t j = std::min(e, t);
+                if (j >= n) { command(i, n, nullptr, 0); break; }
+                const std::size_t r = utils::equal_run(p + j, n - j);
+                command(i, j, p + j, r);
+                i = j + r;
+            }
+            out.resize(o);
+        }
+
+        [[nodiscard]]
+        static std::vector<std::uint8_t> encode(std::span<const D> src) {
+            std::vector<std::uint8_t> out;
+            encode(src, out);
+            return out;
+        }
+
+        // décode tout in dans out ; nombre de symboles écrits, nullopt si le flux est invalide
+        // ou ne tient pas dans out
+        [[nodiscard]]
+        static std::optional<std::size_t> decode_into(std::span<const std::uint8_t> in, std::span<D> out) noexcept {
+            const std::uint8_t* p = in.data();
+            const std::uint8_t* const end = p + in.size();
+            std::size_t pos = 0;
+            D cur{};
+            while (p != end) {
+                std::optional<std::uint64_t> h;
+                if (*p < 0x80) h = *p++; // en-tête d'un octet : cas courant
+                else if (h = utils::get_varint(p, end); !h) return std::nullopt;
+                std::uint64_t nb_lit = 1;
+                bool change = false;
+                if (*h & 1) {
+                    const auto x = utils::get_varint(p, end);
+                    if (!x) return std::nullopt;
+                    nb_lit = *x >> 1;
+                    change = (*x & 1) != 0;
+                }
+                if (nb_lit > out.size() - pos || static_cast<std::uint64_t>(end - p) / sizeof(D) < nb_lit)
+                    return std::nullopt;
+                if (nb_lit != 0) {
+                    const std::size_t cnt = static_cast<std::size_t>(nb_lit);
+                    // littéraux courts : une copie de 16 octets de taille fixe quand la place le permet
+                    if (std::endian::native == std::endian::little && cnt * sizeof(D) <= 16
+                        && (out.size() - pos) * sizeof(D) >= 16 && end - p >= 16)
+                        std::memcpy(out.data() + pos, p, 16);
+                    else get_symbols(p, out.data() + pos, cnt);
+                    p += cnt * sizeof(D);
+                    pos += cnt;
+                }
+                if (change) {
+                    if (end - p < static_cast<std::ptrdiff_t>(sizeof(D))) return std::nullopt;
+                    get_symbols(p, &cur, 1);
+                    p += sizeof(D);
+                }
+                const std::uint64_t run = *h >> 1;
+                const std::size_t room = out.size() - pos;
+                if (run > room) return std::nullopt;
+                const std::size_t cnt = static_cast<std::size_t>(run);
+                if constexpr (sizeof(D) == 1) {
+                    // plage courte : une écriture de 16 octets de taille fixe (déborde dans la place restante)
+                    if (cnt <= 16 && room >= 16) std::memset(out.data() + pos, std::bit_cast<std::uint8_t>(cur), 16);
+                    else std::memset(out.data() + pos, std::bit_cast<std::uint8_t>(cur), cnt);
+                } else fill(out.data() + pos, cnt, cur);
+                pos += cnt;
+            }
+            return pos;
+        }
+
+        // nombre de symboles que décoderait in, sans les écrire ; nullopt si le flux est invalide
+        // (borne la sortie avant de l'allouer)
+        [[nodiscard]]
+        static std::optional<std::uint64_t> decoded_size(std::span<const std::uint8_t> in) noexcept {
+            const std::uint8_t* p = in.data();
+            const std::uint8_t* const end = p + in.size();
+            std::uint64_t total = 0;
+            while (p != end) {
+                const auto h = utils::get_varint(p, end);
+                if (!h) return std::nullopt;
+                std::uint64_t nb_lit = 1;
+                bool change = false;
+                if (*h & 1) {
+                    const auto x = utils::get_varint(p, end);
+                    if (!x) return std::nullopt;
+                    nb_lit = *x >> 1;
+                    change = (*x & 1) != 0;
+                }
+                const std::uint64_t bytes = static_cast<std::uint64_t>(end - p);
+                if (bytes / sizeof(D) < nb_lit + change) return std::nullopt;
+                p += (nb_lit + change) * sizeof(D);
+                const std::uint64_t run = *h >> 1;
+                if (run + nb_lit < run || total + run + nb_lit < total) return std::nullopt;
+                total += run + nb_lit;
+            }
+            return total;
+        }
+
+        // nb_symbols : taille attendue (connue du conteneur)
+        [[nodiscard]]
+        static std::optional<std::vector<D>> decode(std::span<const std::uint8_t> in, std::size_t nb_symbols) {
+            std::vector<D> out(nb_symbols);
+            const auto n = decode_into(in, out);
+            if (!n || *n != nb_symbols) return std::nullopt;
+            return out;
+        }
+    };
+
+    namespace detail {
+
+        // fréquences (symbole, nombre d'occurrences) des symboles présents, dans res :
+        // frontal commun aux codeurs entropiques (Huffman, Rans)
+        template<typename D, typename Stats, typename Vec>
+        void count_symbols(std::span<const D> src, Vec& res) {
+            [[maybe_unused]] typename Stats::timer t(stats::stage::count);
+            res.clear();
+            if constexpr (sizeof(D) == 1 && std::is_trivially_copyable_v<D>) {
+                // symboles d'un octet : quatre histogrammes entrelacés, pour que deux octets
+                // égaux consécutifs n'incrémentent pas le même compteur coup sur coup
+                std::array<std::array<std::uint32_t, 256>, 4> hist{};
+                const auto* p = reinterpret_cast<const std::uint8_t*>(src.data());
+                const std::size_t n = src.size();
+                std::array<std::size_t, 256> total{};
+                constexpr std::size_t block = std::size_t{1} << 30;
+                for (std::size_t base = 0; base < n; base += block) {
+                    // les compteurs 32 bits sont vidés avant de pouvoir déborder
+                    const std::size_t end = std::min(n, base + block);
+                    std::size_t i = base;
+                    for (; i + 4 <= end; i += 4) {
+                        ++hist[0][p[i]];
+                        ++hist[1][p[i + 1]];
+                        ++hist[2][p[i + 2]];
+                        ++hist[3][p[i + 3]];
+                    }
+                    for (; i < end; ++i) ++hist[0][p[i]];
+                    for (std::size_t b = 0; b < 256; ++b) {
+                        total[b] += std::size_t{hist[0][b]} + hist[1][b] + hist[2][b] + hist[3][b];
+                        hist[0][b] = hist[1][b] = hist[2][b] = hist[3][b] = 0;
+                    }
+                }
+                for (std::size_t b = 0; b < 256; ++b)
+                    if (total[b]) res.emplace_back(std::bit_cast<D>(static_cast<std::uint8_t>(b)), total[b]);
+            } else {
+                std::unordered_map<D, std::size_t> freq;
+                for (auto& d : src) freq[d]++;
+                res.assign(freq.begin(), freq.end());
+            }
+        }
+
+    } // namespace detail
+
+    // ===== Huffman canonique (longueurs issues d'un utils::FlatWeightedTree) =====
+    // Seules les longueurs de code sont transmises (table canonique) ; le décodage se fait
+    // par tables : un coup d'œil de table_bits bits résout la plupart des symboles, les codes
+    // plus longs passent par une sous-table. Stats : politique d'instrumentation (stats.hpp).
+    template<typename D, typename Stats = stats::none>
     struct Huffman {
-        using WBT = utils::WeightedBinaryTree<std::size_t, D>;
+        using Tree = utils::FlatWeightedTree<std::size_t, D>;
+
+        static constexpr unsigned max_code_length = 15;
+        static constexpr unsigned table_bits      = 11;
+
+        // counts[l] = nombre de codes de longueur l ; symbols dans l'ordre canonique
+        struct canonical_table {
+            std::pmr::vector<std::uint32_t> counts;
+            std::pmr::vector<D>             symbols;
+        };
 
-        static void generate_codes(const std::shared_ptr<WBT>& t,
-                                   std::vector<bool>& path,
-                                   std::unordered_map<D, std::vector<bool>>& map) {
-            if (t->is_leaf()) { map[t->get_data()] = path; return; }
-            if (auto l = t->get_left()) { path.push_back(false); generate_codes(l, path, map); path.pop_back(); }
-            if (auto r = t->get_right()){ path.push_back(true ); generate_codes(r, path, map); path.pop_back(); }
+        // code : bits dans l'ordre d'émission (premier bit en poids faible)
+        struct code_t {
+            std::uint32_t bits = 0;
+            std::uint8_t  len  = 0;
+        };
+        using code_table = utils::SymbolMap<D, code_t>;
+
+        // entrée de table : symbole (ou début de sous-table si sub_bits != 0), longueur à consommer
+        struct decode_entry {
+            std::uint32_t value    = 0;
+            std::uint8_t  len      = 0;
+            std::uint8_t  sub_bits = 0;
+        };
+
+        struct decoder {
+            std::pmr::vector<decode_entry> table;
+            std::pmr::vector<D>            symbols;
+            unsigned                       root_bits = 0;
+            unsigned                       max_len   = 0;
+        };
+
+        struct encoded {
+            canonical_table           table;
+            std::vector<std::uint8_t> bytes;
+            std::size_t               nb_symbols = 0;
+        };
+
+        // (symbole, profondeur, poids) de chaque feuille
+        using leaf_depth = std::tuple<D, unsigned, std::size_t>;
+
+        // état réutilisable d'un appel à l'autre (fréquences, arbre, tables) : une fois les
+        // tableaux à leur taille, coder ou décoder n'alloue plus pour des symboles d'un octet
+        // (au-delà, le comptage et la table des codes passent par des tables de hachage)
+        struct workspace {
+            std::pmr::vector<std::pair<D, std::size_t>> freqs;
+            Tree                                        tree;
+            std::pmr::vector<leaf_depth>                depths;
+            canonical_table                             table;
+            code_table                                  codes;
+            decoder                                     dec;
+
+            explicit workspace(std::pmr::memory_resource* mr = std::pmr::get_default_resource())
+                : freqs(mr), tree(mr), depths(mr),
+                  table{std::pmr::vector<std::uint32_t>(mr), std::pmr::vector<D>(mr)}, codes(mr),
+                  dec{std::pmr::vector<decode_entry>(mr), std::pmr::vector<D>(mr)} {}
+        };
+
+        // ramène toutes les longueurs sous limit en respectant Kraft ; reserve garde libre
+        // le code « tout à un » (rôle du nœud factice)
+        static void limit_lengths(std::pmr::vector<std::uint32_t>& counts, unsigned limit, bool reserve) {
+            for (std::size_t l = limit + 1; l < counts.size(); ++l) counts[limit] += counts[l];
+            counts.resize(limit + 1, 0);
+            std::uint64_t kraft = 0;
+            for (std::size_t l = 1; l < counts.size(); ++l) kraft += std::uint64_t{counts[l]} << (limit - l);
+            const std::uint64_t budget = (std::uint64_t{1} << limit) - (reserve ? 1 : 0);
+            while (kraft > budget) {
+                // rallonge d'un bit un code parmi les plus longs encore sous la limite
+                std::size_t l = limit - 1;
+                while (counts[l] == 0) --l;
+                --counts[l]; ++counts[l + 1];
+                kraft -= std::uint64_t{1} << (limit - l - 1);
+            }
+            while (counts.size() > 1 && counts.back() == 0) counts.pop_back();
+        }
+
+        // table canonique à partir des fréquences (symbol, fréquence > 0), dans ws.table
+        static void build_table_into(std::span<const std::pair<D, std::size_t>> freqs, bool add_dummy, workspace& ws) {
+            [[maybe_unused]] typename Stats::timer t(stats::stage::huffman_build);
+            canonical_table& res = ws.table;
+            res.counts.clear();
+            res.symbols.clear();
+            if (freqs.empty()) return;
+            if (freqs.size() == 1) { // alphabet d'un seul symbole : code de longueur 1
+                res.counts.assign({0, 1});
+                res.symbols.push_back(freqs.front().first);
+                return;
+            }
+
+            Tree& tree = ws.tree;
+            tree.assign(freqs);
+            if (add_dummy) tree.add_dummy();
+
+            // à profondeur égale, les symboles les moins fréquents en dernier : ce sont eux
+            // que limit_lengths rallonge
+            auto& depths = ws.depths;
+            depths.clear();
+            depths.reserve(freqs.size());
+            tree.for_each_leaf([&](const D& d, unsigned depth, std::size_t w){ depths.emplace_back(d, depth, w); });
+            std::sort(depths.begin(), depths.end(), [](auto& a, auto& b){
+                return std::get<1>(a) != std::get<1>(b) ? std::get<1>(a) < std::get<1>(b)
+                                                        : std::get<2>(a) > std::get<2>(b);
+            });
+
+            const unsigned limit = std::max(max_code_length,
+                                            static_cast<unsigned>(std::bit_width(freqs.size())));
+            res.counts.assign(std::get<1>(depths.back()) + 1, 0);
+            for (auto& [d,l,w] : depths) ++res.counts[l];
+            limit_lengths(res.counts, limit, add_dummy);
+
+            res.symbols.reserve(depths.size());
+            for (auto& [d,l,w] : depths) res.symbols.push_back(d);
+        }
+
+        [[nodiscard]]
+        static canonical_table build_table(std::span<const std::pair<D, std::size_t>> freqs, bool add_dummy) {
+            workspace ws;
+            build_table_into(freqs, add_dummy, ws);
+            return std::move(ws.table);
+        }
+
+        // appelle f(symbol, code MSB en premier, longueur) dans l'ordre canonique
+        template<typename F>
+        static void for_each_code(const canonical_table& t, F&& f) {
+            std::uint32_t code = 0;
+            std::size_t k = 0;
+            for (std::size_t l = 1; l < t.counts.size(); ++l) {
+                for (std::uint32_t i = 0; i < t.counts[l] && k < t.symbols.size(); ++i, ++k)
+                    f(k, code++, static_cast<unsigned>(l));
+                code <<= 1;
+            }
+        }
+
+        static void make_codes_into(const canonical_table& t, code_table& codes) {
+            codes.clear();
+            for_each_code(t, [&](std::size_t k, std::uint32_t code, unsigned len) {
+                codes[t.symbols[k]] = code_t{utils::reverse_bits(code, len), static_cast<std::uint8_t>(len)};
+            });
         }
 
         [[nodiscard]]
-        static std::pair<std::shared_ptr<WBT>, std::vector<std::vector<bool>>>
-        encode(const std::vector<D>& src, bool add_dummy) {
-            std::unordered_map<D, std::size_t> freq;
-            freq.reserve(src.size());
-            for (auto& d : src) freq[d]++;
+        static code_table make_codes(const canonical_table& t) {
+            code_table codes;
+            make_codes_into(t, codes);
+            return codes;
+        }
+
+        // remplit dec (sa mémoire est réutilisée) ; false si la table est incohérente
+        // (comptes, inégalité de Kraft)
+        [[nodiscard]]
+        static bool make_decoder_into(const canonical_table& t, decoder& dec) {
+            dec.symbols.assign(t.symbols.begin(), t.symbols.end());
+            dec.table.clear();
+            dec.root_bits = dec.max_len = 0;
+            if (t.symbols.empty()) return true;
+            if (t.counts.empty() || t.counts[0] != 0 || t.counts.size() > 33) return false;
+
+            dec.max_len = static_cast<unsigned>(t.counts.size() - 1);
+            std::uint64_t total = 0, kraft = 0;
+            for (std::size_t l = 1; l < t.counts.size(); ++l) {
+                total += t.counts[l];
+                kraft += std::uint64_t{t.counts[l]} << (dec.max_len - l);
+            }
+            if (total != t.symbols.size() || kraft > (std::uint64_t{1} << dec.max_len)) return false;
 
-            std::vector<std::shared_ptr<WBT>> trees;
-            trees.reserve(freq.size());
-            for (auto& [d,f] : freq) trees.push_back(WBT::leaf(f, d));
-            if (trees.empty()) return {nullptr, {}};
+            const unsigned root = std::min(table_bits, dec.max_len);
+            dec.root_bits = root;
+            dec.table.assign(std::size_t{1} << root, decode_entry{});
 
-            while (trees.size() > 1) {
-                std::sort(trees.begin(), trees.end(),
-                          [](auto& a, auto& b){ return a->get_weight() > b->get_weight(); });
-                auto L = trees.back(); trees.pop_back();
-                auto R = trees.back(); trees.pop_back();
-                trees.push_back(WBT::complex(L, R));
+            // 1er passage : codes courts, et taille des sous-tables par préfixe
+            for_each_code(t, [&](std::size_t k, std::uint32_t code, unsigned len) {
+                const std::uint32_t rev = utils::reverse_bits(code, len);
+                if (len <= root) {
+                    for (std::uint32_t i = rev; i < dec.table.size(); i += 1u << len)
+                        dec.table[i] = decode_entry{static_cast<std::uint32_t>(k), static_cast<std::uint8_t>(len), 0};
+                } else {
+                    auto& e = dec.table[rev & ((1u << root) - 1)];
+                    e.sub_bits = std::max<std::uint8_t>(e.sub_bits, static_cast<std::uint8_t>(len - root));
+                }
+            });
+            for (std::size_t i = 0; i < (std::size_t{1} << root); ++i) {
+                auto& e = dec.table[i];
+                if (e.sub_bits == 0) continue;
+                e.value = static_cast<std::uint32_t>(dec.table.size());
+                dec.table.resize(dec.table.size() + (std::size_t{1} << e.sub_bits));
             }
-            auto tree = trees.front();
-            if (add_dummy) tree->add_dummy();
+            // 2e passage : remplissage des sous-tables
+            for_each_code(t, [&](std::size_t k, std::uint32_t code, unsigned len) {
+                if (len <= root) return;
+                const std::uint32_t rev = utils::reverse_bits(code, len);
+                const auto& head = dec.table[rev & ((1u << root) - 1)];
+                const std::size_t base = head.value, size = std::size_t{1} << head.sub_bits;
+                for (std::size_t i = rev >> root; i < size; i += std::size_t{1} << (len - root))
+                    dec.table[base + i] = decode_entry{static_cast<std::uint32_t>(k), static_cast<std::uint8_t>(len - root), 0};
+            });
+            return true;
+        }
 
-            std::unordered_map<D, std::vector<bool>> encmap;
-            encmap.reserve(freq.size());
-            std::vector<bool> path;
-            generate_codes(tree, path, encmap);
+        // nullopt si la table est incohérente
+        [[nodiscard]]
+        static std::optional<decoder> make_decoder(const canonical_table& t) {
+            decoder dec;
+            if (!make_decoder_into(t, dec)) return std::nullopt;
+            return dec;
+        }
 
-            std::vector<std::vector<bool>> out;
-            out.reserve(src.size());
-            for (auto& d : src) out.push_back(encmap[d]);
-            return {tree, std::move(out)};
+        // fréquences (symbole, nombre d'occurrences) des symboles présents, dans res
+        template<typename Vec>
+        static void count_into(std::span<const D> src, Vec& res) {
+            detail::count_symbols<D, Stats>(src, res);
         }
 
         [[nodiscard]]
-        static std::vector<D> decode(const std::shared_ptr<WBT>& tree,
-                                     const std::vector<bool>& bits) {
-            std::vector<D> out;
-            if (!tree) return out;
-            auto n = tree;
-            for (bool b : bits) {
-                n = b ? n->get_right() : n->get_left();
-                if (n->is_leaf()) { out.push_back(n->get_data()); n = tree; }
+        static std::vector<std::pair<D, std::size_t>> count(std::span<const D> src) {
+            std::vector<std::pair<D, std::size_t>> res;
+            count_into(src, res);
+            return res;
+        }
+
+        // taille exacte en bits du flux produit par encode_into
+        [[nodiscard]]
+        static std::size_t encoded_bits(std::span<const std::pair<D, std::size_t>> freqs, const code_table& codes) {
+            std::size_t nb_bits = 0;
+            for (auto& [d,f] : freqs) nb_bits += f * codes.find(d)->len;
+            return nb_bits;
+        }
+
+        // Stats : longueurs de code, entropie d'ordre 0 et bits réellement émis
+        static void record_stats(std::span<const std::pair<D, std::size_t>> freqs, const code_table& codes) {
+            if constexpr (Stats::enabled) {
+                auto& c = Stats::local().huffman;
+                std::size_t n = 0;
+                for (auto& [d,f] : freqs) n += f;
+                for (auto& [d,f] : freqs) {
+                    const unsigned len = codes.find(d)->len;
+                    ++c.code_lengths[std::min<std::size_t>(len, c.code_lengths.size() - 1)];
+                    c.coded_symbols[std::min<std::size_t>(len, c.coded_symbols.size() - 1)] += f;
+                    c.bits += f * len;
+                    c.entropy_bits += static_cast<double>(f) * std::log2(static_cast<double>(n) / static_cast<double>(f));
+                }
+                c.symbols += n;
+            } else {
+                (void)freqs; (void)codes;
+            }
+        }
+
+        // écrit les codes de src dans out ; renvoie le nombre de bits, nullopt si out est trop
+        // petit ou si un symbole n'a pas de code
+        [[nodiscard]]
+        static std::optional<std::size_t>
+        encode_into(std::span<const D> src, const code_table& codes, std::span<std::uint8_t> out) {
+            [[maybe_unused]] typename Stats::timer t(stats::stage::huffman_encode);
+            utils::BitWriter w(out);
+            for (auto& d : src) {
+                const code_t* c = codes.find(d);
+                if (!c || c->len == 0) return std::nullopt;
+                w.put(c->bits, c->len);
+            }
+            const std::size_t nb_bits = w.bit_count();
+            w.finish();
+            if (w.overflow()) return std::nullopt;
+            return nb_bits;
+        }
+
+        [[nodiscard]]
+        static encoded encode(std::span<const D> src, bool add_dummy) {
+            const auto freqs = count(src);
+
+            encoded res;
+            res.table = build_table(freqs, add_dummy);
+            res.nb_symbols = src.size();
+            const code_table codes = make_codes(res.table);
+            const std::size_t nb_bits = encoded_bits(freqs, codes);
+            record_stats(freqs, codes);
+
+            // 8 octets de marge : le BitWriter reste sur son chemin rapide jusqu'au bout
+            res.bytes.resize((nb_bits + 7) / 8 + 8);
+            [[maybe_unused]] const auto written = encode_into(src, codes, res.bytes);
+            assert(written && *written == nb_bits);
+            res.bytes.resize((nb_bits + 7) / 8);
+            return res;
+        }
+
+        // décode out.size() symboles ; nullopt si le flux est invalide ou tronqué
+        [[nodiscard]]
+        static std::optional<std::size_t>
+        decode_into(const decoder& dec, std::span<const std::uint8_t> bytes, std::span<D> out) {
+            [[maybe_unused]] typename Stats::timer t(stats::stage::huffman_decode);
+            if (out.empty()) return 0;
+            if (dec.table.empty()) return std::nullopt;
+            const decode_entry* tab = dec.table.data();
+            const unsigned root = dec.root_bits;
+            utils::BitReader r(bytes);
+            for (auto& o : out) {
+                if (r.bits_available() < dec.max_len) r.refill();
+                decode_entry e = tab[r.peek(root)];
+                if (e.sub_bits != 0) { r.consume(root); e = tab[e.value + r.peek(e.sub_bits)]; }
+                if (e.len == 0) return std::nullopt;
+                r.consume(e.len);
+                o = dec.symbols[e.value];
+            }
+            if (r.overrun()) return std::nullopt;
+            return out.size();
+        }
+
+        // vide si la table ou le flux sont invalides
+        [[nodiscard]]
+        static std::vector<D> decode(const canonical_table& table,
+                                     std::span<const std::uint8_t> bytes,
+                                     std::size_t nb_symbols) {
+            decoder dec;
+            if (!make_decoder_into(table, dec)) return {};
+            std::vector<D> out(nb_symbols);
+            if (!decode_into(dec, bytes, out)) return {};
+            return out;
+        }
+    };
+
+    // ===== rANS entrelacé : alternative à Huffman au plus près de l'entropie =====
+    // Même frontal de comptage que Huffman (detail::count_symbols) ; les fréquences sont
+    // ramenées à une somme 1 << scale_bits et le décodage d'un symbole est une lecture de
+    // table indexée par les scale_bits bits bas de l'état. Quatre états 31 bits entrelacés
+    // (symbole i sur l'état i % 4) rendent les décodages successifs indépendants. Flux :
+    // états 0..3 (u32 LE) puis mots de 16 bits LE dans l'ordre de lecture du décodeur
+    // (l'encodeur parcourt les symboles à l'envers). Stats : politique d'instrumentation.
+    template<typename D, typename Stats = stats::none>
+    struct Rans {
+        static constexpr std::size_t   nb_states      = 4;
+        static constexpr unsigned      min_scale_bits = 12;
+        static constexpr unsigned      max_scale_bits = 15;
+        // un état renormalisé reste dans [lower_bound, lower_bound << 16) : sous 2^31, la
+        // division de l'encodeur est une multiplication par un inverse exact
+        static constexpr std::uint32_t lower_bound    = std::uint32_t{1} << 15;
+
+        // fréquences normalisées dans l'ordre des symboles ; scale_bits = 0 pour un alphabet
+        // d'un seul symbole (pas de flux)
+        struct table {
+            unsigned                        scale_bits = 0;
+            std::pmr::vector<D>             symbols;
+            std::pmr::vector<std::uint32_t> freqs;
+        };
+
+        // x -> (x / freq) << scale_bits + x % freq + cum, calculé comme
+        // x + bias + q * cmpl_freq avec q = x / freq = (x * rcp_freq) >> (32 + rcp_shift) ;
+        // x_max == 0 : symbole absent de la table
+        struct enc_entry {
+            std::uint32_t x_max     = 0; // au-delà, l'état émet un mot avant de coder
+            std::uint32_t rcp_freq  = 0;
+            std::uint32_t bias      = 0;
+            std::uint16_t cmpl_freq = 0;
+            std::uint16_t rcp_shift = 0;
+        };
+        using enc_table = utils::SymbolMap<D, enc_entry>;
+
+        // une entrée par créneau de [0, 1 << scale_bits) ; bias = créneau - cumul du symbole
+        struct dec_entry {
+            std::uint16_t freq   = 0;
+            std::uint16_t bias   = 0;
+            std::uint32_t symbol = 0;
+        };
+
+        struct decoder {
+            std::pmr::vector<dec_entry> slots;
+            std::pmr::vector<D>         symbols;
+            unsigned                    scale_bits = 0;
+        };
+
+        struct encoded {
+            table                     tab;
+            std::vector<std::uint8_t> bytes;
+            std::size_t               nb_symbols = 0;
+        };
+
+        // état réutilisable d'un appel à l'autre (cf. Huffman::workspace)
+        struct workspace {
+            std::pmr::vector<std::pair<D, std::size_t>> freqs;
+            std::pmr::vector<std::uint32_t>             heap;
+            table                                       tab;
+            enc_table                                   enc;
+            decoder                                     dec;
+            std::pmr::vector<std::uint8_t>              stream;
+
+            explicit workspace(std::pmr::memory_resource* mr = std::pmr::get_default_resource())
+                : freqs(mr), heap(mr), tab{0, std::pmr::vector<D>(mr), std::pmr::vector<std::uint32_t>(mr)},
+                  enc(mr), dec{std::pmr::vector<dec_entry>(mr), std::pmr::vector<D>(mr), 0}, stream(mr) {}
+        };
+
+        // un symbole émet au plus un mot : états plus 2 octets par symbole
+        [[nodiscard]] static constexpr std::size_t max_stream_size(std::size_t nb_symbols) noexcept {
+            return nb_states * 4 + 2 * nb_symbols;
+        }
+
+        template<typename Vec>
+        static void count_into(std::span<const D> src, Vec& res) {
+            detail::count_symbols<D, Stats>(src, res);
+        }
+
+        // normalise les fréquences (symbol, fréquence > 0) dans ws.tab ; false si l'alphabet
+        // dépasse 1 << max_scale_bits symboles
+        [[nodiscard]]
+        static bool build_table_into(std::span<const std::pair<D, std::size_t>> freqs, workspace& ws) {
+            [[maybe_unused]] typename Stats::timer t(stats::stage::rans_build);
+            table& res = ws.tab;
+            res.scale_bits = 0;
+            res.symbols.clear();
+            res.freqs.clear();
+            const std::size_t k = freqs.size();
+            if (k == 0) return true;
+            if (k > (std::size_t{1} << max_scale_bits)) return false;
+            for (auto& [d,f] : freqs) res.symbols.push_back(d);
+            if (k == 1) { res.freqs.push_back(1); return true; }
+
+            // au moins deux créneaux par symbole tant que max_scale_bits le permet
+            const unsigned scale = std::clamp(static_cast<unsigned>(std::bit_width(k)) + 1, min_scale_bits, max_scale_bits);
+            const std::uint32_t total = std::uint32_t{1} << scale;
+            double n = 0;
+            for (auto& [d,f] : freqs) n += static_cast<double>(f);
+            std::int64_t delta = total;
+            std::size_t largest = 0;
+            for (std::size_t i = 0; i < k; ++i) {
+                const auto nf = std::max<std::uint32_t>(1, static_cast<std::uint32_t>(
+                    std::llround(static_cast<double>(freqs[i].second) * total / n)));
+                res.freqs.push_back(nf);
+                delta -= nf;
+                if (nf > res.freqs[largest]) largest = i;
+            }
+            if (delta > 0) {
+                res.freqs[largest] += static_cast<std::uint32_t>(delta);
+            } else if (delta < 0) {
+                // l'arrondi (et le minimum de 1) a trop donné : on reprend aux plus grandes
+                // fréquences, au plus 1/8 à la fois pour que le coût relatif reste faible
+                auto& heap = ws.heap;
+                heap.clear();
+                for (std::uint32_t i = 0; i < k; ++i) if (res.freqs[i] > 1) heap.push_back(i);
+                const auto less = [&](std::uint32_t a, std::uint32_t b){ return res.freqs[a] < res.freqs[b]; };
+                std::make_heap(heap.begin(), heap.end(), less);
+                while (delta < 0) {
+                    assert(!heap.empty());
+                    std::pop_heap(heap.begin(), heap.end(), less);
+                    std::uint32_t& f = res.freqs[heap.back()];
+                    const auto take = std::min<std::int64_t>(-delta, std::max<std::uint32_t>(1, f / 8));
+                    f -= static_cast<std::uint32_t>(take);
+                    delta += take;
+                    if (f > 1) std::push_heap(heap.begin(), heap.end(), less);
+                    else heap.pop_back();
+                }
+            }
+            res.scale_bits = scale;
+            return true;
+        }
+
+        [[nodiscard]]
+        static std::optional<table> build_table(std::span<const std::pair<D, std::size_t>> freqs) {
+            workspace ws;
+            if (!build_table_into(freqs, ws)) return std::nullopt;
+            return std::move(ws.tab);
+        }
+
+        static void make_encoder_into(const table& t, enc_table& enc) {
+            enc.clear();
+            const unsigned scale = t.scale_bits;
+            const std::uint32_t total = std::uint32_t{1} << scale;
+            std::uint32_t cum = 0;
+            for (std::size_t i = 0; i < t.symbols.size(); ++i) {
+                const std::uint32_t f = t.freqs[i];
+                enc_entry e;
+                e.x_max = ((lower_bound >> scale) << 16) * f;
+                e.cmpl_freq = static_cast<std::uint16_t>(total - f);
+                if (f < 2) {
+                    // q = x - 1 ; le biais rattrape l'écart
+                    e.rcp_freq = ~std::uint32_t{0};
+                    e.bias = cum + total - 1;
+                } else {
+                    const unsigned shift = static_cast<unsigned>(std::bit_width(f - 1)); // 2^shift >= f
+                    e.rcp_freq = static_cast<std::uint32_t>(((std::uint64_t{1} << (shift + 31)) + f - 1) / f);
+                    e.rcp_shift = static_cast<std::uint16_t>(shift - 1);
+                    e.bias = cum;
+                }
+                enc[t.symbols[i]] = e;
+                cum += f;
+            }
+        }
+
+        // remplit dec (sa mémoire est réutilisée) ; false si la table est incohérente
+        [[nodiscard]]
+        static bool make_decoder_into(const table& t, decoder& dec) {
+            dec.symbols.assign(t.symbols.begin(), t.symbols.end());
+            dec.slots.clear();
+            dec.scale_bits = t.scale_bits;
+            const std::size_t k = t.symbols.size();
+            if (t.freqs.size() != k) return false;
+            if (t.scale_bits == 0) return k == 0 || (k == 1 && t.freqs[0] == 1);
+            if (t.scale_bits > max_scale_bits || k < 2) return false;
+            const std::uint32_t total = std::uint32_t{1} << t.scale_bits;
+            std::uint64_t sum = 0;
+            for (auto f : t.freqs) {
+                if (f == 0) return false;
+                sum += f;
+            }
+            if (sum != total) return false;
+
+            // k >= 2 : toute fréquence est < 1 << max_scale_bits
+            dec.slots.resize(total);
+            std::uint32_t cum = 0;
+            for (std::size_t i = 0; i < k; ++i) {
+                for (std::uint32_t j = 0; j < t.freqs[i]; ++j)
+                    dec.slots[cum + j] = dec_entry{static_cast<std::uint16_t>(t.freqs[i]),
+                                                   static_cast<std::uint16_t>(j), static_cast<std::uint32_t>(i)};
+                cum += t.freqs[i];
+            }
+            return true;
+        }
+
+        // Stats : entropie d'ordre 0 et taille réelle du flux
+        static void record_stats(std::span<const std::pair<D, std::size_t>> freqs, std::size_t stream_size) {
+            if constexpr (Stats::enabled) {
+                auto& c = Stats::local().rans;
+                std::size_t n = 0;
+                for (auto& [d,f] : freqs) n += f;
+                for (auto& [d,f] : freqs)
+                    c.entropy_bits += static_cast<double>(f) * std::log2(static_cast<double>(n) / static_cast<double>(f));
+                c.symbols += n;
+                c.bits += 8 * stream_size;
+            } else {
+                (void)freqs; (void)stream_size;
+            }
+        }
+
+        // code src à la fin de out (max_stream_size(src.size()) octets) et renvoie le flux ;
+        // nullopt si out est trop petit ou si un symbole n'est pas dans la table
+        [[nodiscard]]
+        static std::optional<std::span<const std::uint8_t>>
+        encode_into(std::span<const D> src, const table& t, const enc_table& enc, std::span<std::uint8_t> out) {
+            [[maybe_unused]] typename Stats::timer timer(stats::stage::rans_encode);
+            if (out.size() < max_stream_size(src.size())) return std::nullopt;
+            const unsigned scale = t.scale_bits;
+            std::uint8_t* const end = out.data() + out.size();
+            std::uint8_t* p = end;
+            if (scale == 0) {
+                for (auto& d : src) { const enc_entry* e = enc.find(d); if (!e || e->x_max == 0) return std::nullopt; }
+                return std::span<const std::uint8_t>(p, end);
+            }
+
+            // quatre états nommés (et non un tableau indexé) : ils restent en registres
+            std::uint32_t x0 = lower_bound, x1 = lower_bound, x2 = lower_bound, x3 = lower_bound;
+            const auto put = [&](std::uint32_t& s, const D& d) {
+                const enc_entry* ep = enc.find(d);
+                if (!ep) return false;
+                // copie locale : les écritures d'octets dans le flux peuvent aliaser la table
+                const enc_entry e = *ep;
+                if (e.x_max == 0) return false;
+                // un seul mot suffit à repasser sous x_max ; sans branche (émission imprévisible) :
+                // le mot est toujours écrit sous p, p ne recule que s'il est émis
+                const std::uint32_t emit = s >= e.x_max;
+                p[-2] = static_cast<std::uint8_t>(s);
+                p[-1] = static_cast<std::uint8_t>(s >> 8);
+                p -= 2 * emit;
+                s >>= 16 * emit;
+                const auto q = static_cast<std::uint32_t>((std::uint64_t{s} * e.rcp_freq) >> 32) >> e.rcp_shift;
+                s += e.bias + q * e.cmpl_freq;
+                return true;
+            };
+            // symbole i sur l'état i % 4, de la fin vers le début : d'abord le groupe incomplet
+            const std::size_t n = src.size(), body = n - n % nb_states;
+            const D* g = src.data() + body;
+            switch (n % nb_states) {
+                case 3: if (!put(x2, g[2])) return std::nullopt; [[fallthrough]];
+                case 2: if (!put(x1, g[1])) return std::nullopt; [[fallthrough]];
+                case 1: if (!put(x0, g[0])) return std::nullopt; break;
+                default: break;
+            }
+            for (std::size_t i = body; i > 0; i -= nb_states) {
+                g = src.data() + i - nb_states;
+                if (!put(x3, g[3]) || !put(x2, g[2]) || !put(x1, g[1]) || !put(x0, g[0])) return std::nullopt;
+            }
+            for (const std::uint32_t s : {x3, x2, x1, x0}) {
+                p -= 4;
+                for (int b = 0; b < 4; ++b) p[b] = static_cast<std::uint8_t>(s >> (8 * b));
+            }
+            return std::span<const std::uint8_t>(p, end);
+        }
+
+        // nullopt si l'alphabet est trop grand (plus de 1 << max_scale_bits symboles)
+        [[nodiscard]]
+        static std::optional<encoded> encode(std::span<const D> src) {
+            workspace ws;
+            count_into(src, ws.freqs);
+            if (!build_table_into(ws.freqs, ws)) return std::nullopt;
+            make_encoder_into(ws.tab, ws.enc);
+            ws.stream.resize(max_stream_size(src.size()));
+            const auto s = encode_into(src, ws.tab, ws.enc, ws.stream);
+            assert(s);
+            record_stats(ws.freqs, s->size());
+
+            encoded res;
+            res.tab = std::move(ws.tab);
+            res.bytes.assign(s->begin(), s->end());
+            res.nb_symbols = src.size();
+            return res;
+        }
+
+        // décode out.size() symboles ; nullopt si le flux est invalide ou tronqué
+        [[nodiscard]]
+        static std::optional<std::size_t>
+        decode_into(const decoder& dec, std::span<const std::uint8_t> bytes, std::span<D> out) {
+            [[maybe_unused]] typename Stats::timer timer(stats::stage::rans_decode);
+            const std::size_t n = out.size();
+            if (dec.scale_bits == 0) {
+                if (!bytes.empty() || (n != 0 && dec.symbols.size() != 1)) return std::nullopt;
+                std::fill(out.begin(), out.end(), n ? dec.symbols.front() : D{});
+                return n;
+            }
+            if (bytes.size() < nb_states * 4 || dec.slots.size() != (std::size_t{1} << dec.scale_bits))
+                return std::nullopt;
+            const std::uint8_t* p = bytes.data();
+            const std::uint8_t* const end = p + bytes.size();
+            const auto get_u32 = [&] {
+                const std::uint32_t v = std::uint32_t{p[0]} | std::uint32_t{p[1]} << 8
+                                      | std::uint32_t{p[2]} << 16 | std::uint32_t{p[3]} << 24;
+                p += 4;
+                return v;
+            };
+            std::uint32_t x0 = get_u32(), x1 = get_u32(), x2 = get_u32(), x3 = get_u32();
+
+            const dec_entry* tab = dec.slots.data();
+            const D* symbols = dec.symbols.data();
+            const unsigned scale = dec.scale_bits;
+            const std::uint32_t mask = (std::uint32_t{1} << scale) - 1;
+            D* o = out.data();
+            const auto step = [&](std::uint32_t& s) {
+                const dec_entry e = tab[s & mask];
+                s = e.freq * (s >> scale) + e.bias;
+                return symbols[e.symbol];
+            };
+            // le mot suivant est toujours lu et n'est consommé que si l'état est sous lower_bound
+            const auto fast = [&](std::uint32_t& s) {
+                const D d = step(s);
+                const std::uint32_t refill = s < lower_bound;
+                const std::uint32_t w = (std::uint32_t{p[0]} | std::uint32_t{p[1]} << 8) & (0u - refill);
+                s = s << (16 * refill) | w;
+                p += 2 * refill;
+                return d;
+            };
+            const auto checked = [&](std::uint32_t& s, D& d) {
+                d = step(s);
+                if (s >= lower_bound) return true;
+                if (end - p < 2) return false;
+                s = s << 16 | std::uint32_t{p[0]} | std::uint32_t{p[1]} << 8;
+                p += 2;
+                return true;
+            };
+            std::size_t i = 0;
+            // chemin rapide : les quatre états avancent ensemble, 8 octets suffisent à un tour
+            for (; i + nb_states <= n && static_cast<std::size_t>(end - p) >= 2 * nb_states; i += nb_states) {
+                const D d0 = fast(x0), d1 = fast(x1), d2 = fast(x2), d3 = fast(x3);
+                o[i] = d0; o[i + 1] = d1; o[i + 2] = d2; o[i + 3] = d3;
             }
+            for (; i < n; i += nb_states) {
+                const std::size_t k = std::min(nb_states, n - i);
+                if (!checked(x0, o[i]) || (k > 1 && !checked(x1, o[i + 1]))
+                    || (k > 2 && !checked(x2, o[i + 2])) || (k > 3 && !checked(x3, o[i + 3])))
+                    return std::nullopt;
+            }
+            // l'encodeur est parti de lower_bound sur chaque état
+            if (p != end || x0 != lower_bound || x1 != lower_bound || x2 != lower_bound || x3 != lower_bound)
+                return std::nullopt;
+            return n;
+        }
+
+        // vide si la table ou le flux sont invalides
+        [[nodiscard]]
+        static std::vector<D> decode(const table& tab, std::span<const std::uint8_t> bytes, std::size_t nb_symbols) {
+            decoder dec;
+            if (!make_decoder_into(tab, dec)) return {};
+            std::vector<D> out(nb_symbols);
+            if (!decode_into(dec, bytes, out)) return {};
             return out;
         }
     };
 
     // ===== LZ77 (token = littéral D ou (offset,length)) =====
-    template<typename D>
+    // Stats : politique d'instrumentation (stats.hpp), sans effet par défaut
+    template<typename D, typename Stats = stats::none>
     struct LZ77 {
-        using token = std::variant<D, std::pair<std::size_t, std::size_t>>;
+        using token    = std::variant<D, std::pair<std::size_t, std::size_t>>;
+        using finder_t = utils::MatchFinder<D, Stats>;
 
         static std::optional<std::pair<std::size_t, std::size_t>>
         find_match(const std::vector<D>& search, const std::vector<D>& look) {
-            if (search.empty() || look.empty()) return std::nullopt;
-            std::size_t best_len=0, best_off=0;
-            for (std::size_t i=0;i<search.size();++i){
-                std::size_t len=0;
-                while (i+len<search.size() && len<look.size() && search[i+len]==look[len]) ++len;
-                if (len>best_len){ best_len=len; best_off = search.size()-i; }
+            return utils::find_match<D>(search, look);
+        }
+
+        // ----- niveaux de compression -----
+        // fast    : une seule sonde de hachage, pas accéléré sur les zones sans correspondance
+        //           et positions internes des longues correspondances non indexées ;
+        // greedy  : plus longue correspondance sur max_chain candidats ;
+        // lazy    : avant d'émettre une correspondance, sonde les lazy_steps positions
+        //           suivantes et diffère si l'une d'elles fait mieux ;
+        // optimal : programmation dynamique sur le coût en octets du format séquences
+        //           (littéral, varints longueur / offset / nb de littéraux), par fenêtres.
+        enum class strategy : std::uint8_t { fast, greedy, lazy, optimal };
+
+        struct level_params {
+            strategy    strat      = strategy::greedy;
+            std::size_t max_chain  = 64;
+            std::size_t nice_len   = 258; // longueur jugée suffisante : fin de recherche
+            unsigned    lazy_steps = 0;
+        };
+
+        static constexpr int min_level     = 1;
+        static constexpr int max_level     = 9;
+        static constexpr int default_level = 6;
+
+        // paramètres du niveau l (borné à [min_level, max_level])
+        [[nodiscard]] static constexpr level_params level(int l) noexcept {
+            constexpr level_params table[] = {
+                {strategy::fast,    1,   16,  0}, // 1
+                {strategy::greedy,  4,   32,  0}, // 2
+                {strategy::greedy,  8,   64,  0}, // 3
+                {strategy::lazy,    16,  32,  1}, // 4
+                {strategy::lazy,    32,  64,  1}, // 5
+                {strategy::lazy,    64,  128, 1}, // 6
+                {strategy::lazy,    128, 258, 2}, // 7
+                {strategy::optimal, 128, 64,  0}, // 8
+                {strategy::optimal, 256, 128, 0}, // 9
+            };
+            return table[std::clamp(l, min_level, max_level) - min_level];
+        }
+
+        // coûts en octets du format à séquences (container) : un littéral, ou une séquence
+        // (varint nb de littéraux, en général un octet, + varints longueur et offset)
+        static constexpr std::uint32_t literal_price = sizeof(D);
+        [[nodiscard]] static constexpr std::uint32_t varint_size(std::size_t v) noexcept {
+            return static_cast<std::uint32_t>((std::bit_width(v | 1) + 6) / 7);
+        }
+        [[nodiscard]] static constexpr std::uint32_t match_price(std::size_t off, std::size_t len) noexcept {
+            return 1 + varint_size(len) + varint_size(off);
+        }
+
+        // pas de l'analyse optimale : meilleur prix pour atteindre une position
+        struct opt_step {
+            std::uint32_t price = std::numeric_limits<std::uint32_t>::max();
+            std::uint32_t len   = 0; // 1 : littéral
+            std::size_t   off   = 0;
+        };
+
+        // état réutilisable d'une analyse à l'autre : index de hachage et tableaux de
+        // l'analyse optimale gardent leur mémoire, une analyse de même fenêtre n'alloue plus
+        struct workspace {
+            finder_t                       finder;
+            std::pmr::vector<opt_step>     steps;
+            std::pmr::vector<std::size_t>  path;
+
+            explicit workspace(std::pmr::memory_resource* mr = std::pmr::get_default_resource())
+                : finder(mr), steps(mr), path(mr) {}
+        };
+
+        // Analyse de src[begin, ...) selon lv, transmise au fil de l'eau à sink.literal(d) /
+        // sink.match(offset, length). src[0, begin) n'est pas émis mais sert d'historique aux
+        // correspondances. Celles-ci font au plus chunk_size symboles et remontent d'au plus
+        // buffer_size ; elles peuvent chevaucher la position courante.
+        template<typename Sink>
+        static void parse(std::span<const D> src, std::size_t begin, std::size_t buffer_size,
+                          std::size_t chunk_size, const level_params& lv, Sink& sink) {
+            workspace ws;
+            parse(src, begin, buffer_size, chunk_size, lv, sink, ws);
+        }
+
+        // même analyse, sur l'état réutilisable ws ; base (optionnel) : index figé d'un
+        // dictionnaire qui précède src[0], référençable lui aussi dans la limite de buffer_size
+        template<typename Sink>
+        static void parse(std::span<const D> src, std::size_t begin, std::size_t buffer_size,
+                          std::size_t chunk_size, const level_params& lv, Sink& sink, workspace& ws,
+                          const utils::MatchFinder<D>* base = nullptr) {
+            assert(begin <= src.size());
+            if constexpr (Stats::enabled) {
+                // compte littéraux et correspondances au passage vers le vrai sink
+                struct counting_sink {
+                    Sink&                  sink;
+                    stats::lz77_counters&  c;
+                    void literal(const D& d) { ++c.literals; sink.literal(d); }
+                    void match(std::size_t off, std::size_t len) {
+                        ++c.matches; c.matched += len; c.lengths.add(len); c.offsets.add(off);
+                        sink.match(off, len);
+                    }
+                };
+                typename Stats::timer t(stats::stage::lz77_parse);
+                auto& c = Stats::local().lz77;
+                c.symbols += src.size() - begin;
+                counting_sink counted{sink, c};
+                run_parse(src, begin, buffer_size, chunk_size, lv, counted, ws, base);
+            } else {
+                run_parse(src, begin, buffer_size, chunk_size, lv, sink, ws, base);
+            }
+        }
+
+        template<typename Sink>
+        static void run_parse(std::span<const D> src, std::size_t begin, std::size_t buffer_size,
+                              std::size_t chunk_size, const level_params& lv, Sink& sink, workspace& ws,
+                              const utils::MatchFinder<D>* base) {
+            finder_t& finder = ws.finder;
+            // table de têtes à la mesure des données : un petit message ne vide pas une table
+            // dimensionnée pour toute la fenêtre
+            const auto hash_bits = std::clamp(
+                static_cast<unsigned>(std::bit_width(std::min(buffer_size, src.size()))), 8u, 20u);
+            finder.configure(buffer_size, lv.max_chain, hash_bits);
+            finder.reset(src);
+            finder.set_base(base);
+            finder.skip_until(begin > buffer_size ? begin - buffer_size : 0);
+            finder.insert_until(begin);
+            switch (lv.strat) {
+                case strategy::fast:    parse_fast(src, begin, finder, chunk_size, lv, sink);    break;
+                case strategy::greedy:  parse_lazy(src, begin, finder, chunk_size, lv, 0, sink); break;
+                case strategy::lazy:    parse_lazy(src, begin, finder, chunk_size, lv, lv.lazy_steps, sink); break;
+                case strategy::optimal: parse_optimal(src, begin, ws, chunk_size, lv, sink); break;
+            }
+        }
+
+        template<typename Sink>
+        static void parse(std::span<const D> src, std::size_t buffer_size, std::size_t chunk_size,
+                          const level_params& lv, Sink& sink) {
+            parse(src, 0, buffer_size, chunk_size, lv, sink);
+        }
+
+        // analyse gloutonne sur max_chain candidats par position
+        template<typename Sink>
+        static void parse(std::span<const D> src, std::size_t buffer_size, std::size_t chunk_size,
+                          std::size_t max_chain, Sink& sink) {
+            parse(src, buffer_size, chunk_size, level_params{strategy::greedy, max_chain, chunk_size, 0}, sink);
+        }
+
+        template<typename Sink>
+        static void parse_fast(std::span<const D> src, std::size_t begin, finder_t& finder,
+                               std::size_t chunk_size, const level_params& lv, Sink& sink) {
+            // après 2^skip_shift échecs consécutifs, le pas augmente d'un symbole
+            constexpr unsigned skip_shift = 5;
+            const std::size_t n = src.size();
+            std::size_t cur = begin, misses = 0;
+            while (cur < n) {
+                auto m = finder.find(cur, chunk_size, lv.nice_len);
+                if (!m) {
+                    const std::size_t step = std::min(n - cur, 1 + (misses++ >> skip_shift));
+                    finder.insert_until(cur + 1);
+                    for (std::size_t i = 0; i < step; ++i) sink.literal(src[cur + i]);
+                    cur += step;
+                    finder.skip_until(cur);
+                    continue;
+                }
+                misses = 0;
+                sink.match(m->first, m->second);
+                // une longue correspondance n'indexe que sa première position
+                if (m->second > lv.nice_len) { finder.insert_until(cur + 1); finder.skip_until(cur + m->second); }
+                cur += m->second;
+            }
+        }
+
+        template<typename Sink>
+        static void parse_lazy(std::span<const D> src, std::size_t begin, finder_t& finder,
+                               std::size_t chunk_size, const level_params& lv, unsigned steps, Sink& sink) {
+            const std::size_t n = src.size();
+            std::size_t cur = begin;
+            auto m = finder.find(cur, chunk_size, lv.nice_len);
+            while (cur < n) {
+                if (!m) {
+                    sink.literal(src[cur]); ++cur;
+                    m = finder.find(cur, chunk_size, lv.nice_len);
+                    continue;
+                }
+                // une correspondance plus longue de plus de s-1 symboles s positions plus loin
+                // vaut les s littéraux qui la précèdent
+                bool deferred = false;
+                if (m->second < lv.nice_len) {
+                    for (unsigned s = 1; s <= steps && cur + s < n; ++s) {
+                        auto next = finder.find(cur + s, chunk_size, lv.nice_len);
+                        if (next && next->second > m->second + (s - 1)) {
+                            for (unsigned i = 0; i < s; ++i) sink.literal(src[cur + i]);
+                            cur += s;
+                            m = next;
+                            deferred = true;
+                            break;
+                        }
+                    }
+                }
+                if (deferred) continue;
+                sink.match(m->first, m->second);
+                cur += m->second;
+                m = finder.find(cur, chunk_size, lv.nice_len);
+            }
+        }
+
+        template<typename Sink>
+        static void parse_optimal(std::span<const D> src, std::size_t begin, workspace& ws,
+                                  std::size_t chunk_size, const level_params& lv, Sink& sink) {
+            // fenêtre de programmation dynamique ; les correspondances n'en sortent pas
+            constexpr std::size_t window = std::size_t{1} << 14;
+            constexpr std::uint32_t inf = std::numeric_limits<std::uint32_t>::max();
+            finder_t& finder = ws.finder;
+            const std::size_t n = src.size();
+            auto& steps = ws.steps;
+            auto& path = ws.path;
+            steps.assign(std::min(n, window) + 1, opt_step{});
+
+            // émet le meilleur chemin de start à start + k
+            auto emit = [&](std::size_t start, std::size_t k) {
+                path.clear();
+                for (std::size_t j = k; j > 0; j -= steps[j].len) path.push_back(j);
+                for (auto it = path.rbegin(); it != path.rend(); ++it) {
+                    const opt_step& st = steps[*it];
+                    if (st.len == 1) sink.literal(src[start + *it - 1]);
+                    else sink.match(st.off, st.len);
+                }
+            };
+
+            std::size_t start = begin;
+            while (start < n) {
+                const std::size_t w = std::min(n - start, window);
+                for (std::size_t k = 1; k <= w; ++k) steps[k].price = inf;
+                steps[0].price = 0;
+                std::size_t k = 0;
+                bool closed = false;
+                for (; k < w && !closed; ++k) {
+                    const std::uint32_t base = steps[k].price;
+                    if (base + literal_price < steps[k + 1].price) steps[k + 1] = {base + literal_price, 1, 0};
+                    std::size_t prev_len = finder_t::min_match - 1;
+                    std::size_t long_off = 0, long_len = 0;
+                    finder.for_each_match(start + k, std::min(chunk_size, w - k), lv.nice_len,
+                                          [&](std::size_t off, std::size_t len) {
+                        for (std::size_t l = prev_len + 1; l <= len; ++l) {
+                            const std::uint32_t p = base + match_price(off, l);
+                            if (p <= steps[k + l].price)
+                                steps[k + l] = {p, static_cast<std::uint32_t>(l), off};
+                        }
+                        prev_len = len;
+                        if (len >= lv.nice_len) { long_off = off; long_len = len; }
+                    });
+                    // correspondance assez longue : on la prend telle quelle, la fenêtre
+                    // est close juste avant
+                    if (long_len) {
+                        emit(start, k);
+                        sink.match(long_off, long_len);
+                        k += long_len - 1;
+                        closed = true;
+                    }
+                }
+                if (!closed) emit(start, w);
+                start += k;
             }
-            if (best_len>0) return std::make_pair(best_off,best_len);
-            return std::nullopt;
         }
 
         [[nodiscard]]
         static std::vector<token>
-        encode(const std::vector<D>& src, std::size_t buffer_size, std::size_t chunk_size) {
-            assert(chunk_size < buffer_size);
+        encode(std::span<const D> src, std::size_t buffer_size, std::size_t chunk_size,
+               const level_params& lv) {
+            struct token_sink {
+                std::vector<token>& out;
+                void literal(const D& d) { out.emplace_back(d); }
+                void match(std::size_t off, std::size_t len) { out.emplace_back(std::pair{off, len}); }
+            };
             std::vector<token> out; out.reserve(src.size());
-            std::size_t cur=0, n=src.size();
-            while (cur<n) {
-                std::size_t sbeg = (cur>=buffer_size)? (cur-buffer_size) : 0;
-                std::vector<D> search(src.begin()+sbeg, src.begin()+cur);
-                std::vector<D> look  (src.begin()+cur,  src.begin()+std::min(cur+chunk_size, n));
-                auto m = find_match(search, look);
-                if (m && m->second>0) { out.emplace_back(*m); cur += m->second; }
-                else { out.emplace_back(src[cur]); ++cur; }
-            }
+            token_sink sink{out};
+            parse(src, buffer_size, chunk_size, lv, sink);
             return out;
         }
 
         [[nodiscard]]
-        static std::vector<D>
-        decode(const std::vector<token>& enc, std::size_t buffer_size) {
-            std::vector<D> res; res.reserve(enc.size());
-            std::vector<D> win; win.reserve(buffer_size);
+        static std::vector<token>
+        encode(std::span<const D> src, std::size_t buffer_size, std::size_t chunk_size,
+               std::size_t max_chain = 64) {
+            return encode(src, buffer_size, chunk_size, level_params{strategy::greedy, max_chain, chunk_size, 0});
+        }
+
+        // taille de la sortie décodée
+        [[nodiscard]]
+        static std::size_t decoded_size(std::span<const token> enc) noexcept {
+            std::size_t n = 0;
             for (auto& t : enc) {
-                if (std::holds_alternative<D>(t)) {
-                    D v = std::get<D>(t); res.push_back(v); win.push_back(v);
+                if (auto m = std::get_if<std::pair<std::size_t,std::size_t>>(&t)) n += m->second;
+                else ++n;
+            }
+            return n;
+        }
+
+        // décode dans un tampon fourni par l'appelant ; les correspondances sont recopiées
+        // depuis la sortie déjà produite. Renvoie le nombre de symboles écrits, ou nullopt
+        // si out est trop petit ou si un offset sort de la sortie.
+        [[nodiscard]]
+        static std::optional<std::size_t>
+        decode_into(std::span<const token> enc, std::span<D> out) {
+            [[maybe_unused]] typename Stats::timer t(stats::stage::lz77_decode);
+            std::size_t pos = 0;
+            for (auto& t : enc) {
+                if (auto lit = std::get_if<D>(&t)) {
+                    if (pos == out.size()) return std::nullopt;
+                    out[pos++] = *lit;
                 } else {
                     auto [off,len] = std::get<std::pair<std::size_t,std::size_t>>(t);
-                    std::size_t ws = win.size(), start = ws - off;
-                    for (std::size_t i=0;i<len;++i){ D v=win[start+i]; res.push_back(v); win.push_back(v); }
+                    if (off == 0 || off > pos || len > out.size() - pos) return std::nullopt;
+                    utils::copy_match(out.data() + pos, off, len);
+                    pos += len;
                 }
-                if (win.size()>buffer_size)
-                    win.erase(win.begin(), win.begin() + (win.size()-buffer_size));
             }
+            return pos;
+        }
+
+        // décodage en flux : la fenêtre circulaire est conservée d'un appel à l'autre
+        template<typename OutIt>
+        static OutIt decode_to(std::span<const token> enc, utils::RingWindow<D>& window, OutIt out) {
+            for (auto& t : enc) {
+                if (auto lit = std::get_if<D>(&t)) { window.push(*lit); *out++ = *lit; }
+                else {
+                    auto [off,len] = std::get<std::pair<std::size_t,std::size_t>>(t);
+                    out = window.copy_match(off, len, out);
+                }
+            }
+            return out;
+        }
+
+        // buffer_size n'est plus nécessaire : la fenêtre est la sortie elle-même
+        [[nodiscard]]
+        static std::vector<D>
+        decode(const std::vector<token>& enc, [[maybe_unused]] std::size_t buffer_size) {
+            std::vector<D> res(decoded_size(enc));
+            [[maybe_unused]] const auto n = decode_into(enc, res);
+            assert(n && *n == res.size());
             return res;
         }
     };
@@ -12,58 +12,781 @@
 #include <type_traits>
 #include <algorithm>
 #include <numeric>
+#include <array>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <cstdint>
+#include <limits>
+#include <bit>
+#include "fft.hpp"
+#include "stats.hpp"
+#include "utils.hpp"
 
 namespace encoding::lossy {
 
-    struct DiscreteCosinus {
-        // D = type des données d'entrée (arithmétique), R = type retour (float/double)
+    namespace detail {
+        // feuilles impaires de DctPlan : table de cosinus dense jusqu'à cette taille, FFT au-delà
+        inline constexpr std::size_t dct_dense_leaf_max = 63;
+
+        // mémoire de travail d'une feuille FFT pour une DCT de taille n : (re, im) de la feuille
+        // plus le tampon de FftPlan, Bluestein compris (2M + 2M, M = bit_ceil(2 leaf - 1))
+        [[nodiscard]] constexpr std::size_t dct_leaf_work(std::size_t n) noexcept {
+            while (n > 0 && n % 2 == 0) n /= 2;
+            return n > dct_dense_leaf_max ? 2 * n + 4 * std::bit_ceil(2 * n - 1) : 0;
+        }
+    } // namespace detail
+
+    // ===== DctPlan : DCT-II / DCT-III rapides pour une taille N donnée =====
+    // Découpage récursif de Lee : tant que la taille est paire, une DCT de taille n se ramène
+    // à deux DCT de taille n/2 (somme / différence pondérée par 1/(2 cos)). Les petites feuilles
+    // de taille impaire utilisent une table de cosinus précalculée ; au-delà de
+    // detail::dct_dense_leaf_max, une FFT complexe de même taille (réordonnancement de Makhoul,
+    // Bluestein pour les grands facteurs premiers). Coût O(N log N) pour toute taille ; aucun
+    // appel trigonométrique hors construction.
+    // Les plans sont immuables et partagés par taille (DctPlan::get).
+    template<std::floating_point T>
+    class DctPlan {
+    private:
+        std::size_t                 m_n;
+        std::vector<std::vector<T>> m_half_sec;  // par niveau : 1 / (2 cos(pi (i + 1/2) / n))
+        std::size_t                 m_leaf;      // taille (impaire) des feuilles
+        std::vector<T>              m_leaf_cos;  // cos(pi (i + 1/2) k / leaf), rangé [k * leaf + i]
+        std::shared_ptr<const FftPlan<T>> m_fft; // grandes feuilles
+        std::vector<T>              m_leaf_tw_re, m_leaf_tw_im; // cos, sin (pi k / (2 leaf))
+
+        // X[k] = Re(exp(-i pi k / (2n)) V[k]), V = FFT de v (pairs dans l'ordre puis impairs à
+        // rebours). work : detail::dct_leaf_work(m_n) éléments.
+        template<std::size_t L>
+        void leaf_fft_forward(T* data, T* work) const {
+            const std::size_t n = m_leaf;
+            T* re = work;
+            T* im = work + n;
+            for (std::size_t l = 0; l < L; ++l) {
+                for (std::size_t i = 0; 2 * i < n; ++i)     re[i]         = data[2 * i * L + l];
+                for (std::size_t i = 0; 2 * i + 1 < n; ++i) re[n - 1 - i] = data[(2 * i + 1) * L + l];
+                std::fill_n(im, n, T{0});
+                m_fft->forward(re, im, work + 2 * n);
+                for (std::size_t k = 0; k < n; ++k) data[k * L + l] = m_leaf_tw_re[k] * re[k] + m_leaf_tw_im[k] * im[k];
+            }
+        }
+
+        // transposée : v = Re(FFT(exp(-i pi k / (2n)) X)), puis v remis dans l'ordre naturel
+        template<std::size_t L>
+        void leaf_fft_inverse(T* data, T* work) const {
+            const std::size_t n = m_leaf;
+            T* re = work;
+            T* im = work + n;
+            for (std::size_t l = 0; l < L; ++l) {
+                for (std::size_t k = 0; k < n; ++k) {
+                    const T x = data[k * L + l];
+                    re[k] = m_leaf_tw_re[k] * x;
+                    im[k] = -m_leaf_tw_im[k] * x;
+                }
+                m_fft->forward(re, im, work + 2 * n);
+                for (std::size_t i = 0; 2 * i < n; ++i)     data[2 * i * L + l]       = re[i];
+                for (std::size_t i = 0; 2 * i + 1 < n; ++i) data[(2 * i + 1) * L + l] = re[n - 1 - i];
+            }
+        }
+
+        // L signaux traités ensemble, rangés par échantillon : valeur i du signal l en data[i * L + l].
+        // Chaque opération scalaire devient une boucle de L voies, vectorisée par le compilateur.
+        template<std::size_t L>
+        void forward_rec(T* data, T* tmp, T* work, std::size_t n, std::size_t level) const {
+            if (n == 1) return; // X[0] = x[0]
+            if (n == m_leaf && m_fft) { leaf_fft_forward<L>(data, work); return; }
+            if (n == m_leaf) {
+                for (std::size_t k = 0; k < n; ++k) {
+                    const T* c = m_leaf_cos.data() + k * n;
+                    T acc[L] = {};
+                    for (std::size_t i = 0; i < n; ++i)
+                        for (std::size_t l = 0; l < L; ++l) acc[l] += data[i * L + l] * c[i];
+                    std::copy_n(acc, L, tmp + k * L);
+                }
+                std::copy_n(tmp, n * L, data);
+                return;
+            }
+            const T* hs = m_half_sec[level].data();
+            if (n == 2) { // feuilles de taille 1 : pas d'appel
+                for (std::size_t l = 0; l < L; ++l) {
+                    const T a = data[l], b = data[L + l];
+                    data[l]     = a + b;
+                    data[L + l] = (a - b) * hs[0];
+                }
+                return;
+            }
+            const std::size_t m = n / 2;
+            for (std::size_t i = 0; i < m; ++i) {
+                const T* a = data + i * L;
+                const T* b = data + (n - 1 - i) * L;
+                T* s = tmp + i * L;
+                T* d = tmp + (m + i) * L;
+                for (std::size_t l = 0; l < L; ++l) {
+                    s[l] = a[l] + b[l];
+                    d[l] = (a[l] - b[l]) * hs[i];
+                }
+            }
+            forward_rec<L>(tmp,         data, work, m, level + 1);
+            forward_rec<L>(tmp + m * L, data, work, m, level + 1);
+            for (std::size_t k = 0; k + 1 < m; ++k)
+                for (std::size_t l = 0; l < L; ++l) {
+                    data[2 * k * L + l]       = tmp[k * L + l];
+                    data[(2 * k + 1) * L + l] = tmp[(m + k) * L + l] + tmp[(m + k + 1) * L + l];
+                }
+            std::copy_n(tmp + (m - 1) * L, L, data + (n - 2) * L);
+            std::copy_n(tmp + (n - 1) * L, L, data + (n - 1) * L);
+        }
+
+        // transposée exacte de forward_rec
+        template<std::size_t L>
+        void inverse_rec(T* data, T* tmp, T* work, std::size_t n, std::size_t level) const {
+            if (n == 1) return;
+            if (n == m_leaf && m_fft) { leaf_fft_inverse<L>(data, work); return; }
+            if (n == m_leaf) {
+                std::fill_n(tmp, n * L, T{0});
+                for (std::size_t k = 0; k < n; ++k) {
+                    const T* c = m_leaf_cos.data() + k * n;
+                    const T* ck = data + k * L;
+                    for (std::size_t i = 0; i < n; ++i)
+                        for (std::size_t l = 0; l < L; ++l) tmp[i * L + l] += ck[l] * c[i];
+                }
+                std::copy_n(tmp, n * L, data);
+                return;
+            }
+            if (n == 2) {
+                const T* hs = m_half_sec[level].data();
+                for (std::size_t l = 0; l < L; ++l) {
+                    const T u = data[l], w = data[L + l] * hs[0];
+                    data[l]     = u + w;
+                    data[L + l] = u - w;
+                }
+                return;
+            }
+            const std::size_t m = n / 2;
+            std::copy_n(data,     L, tmp);
+            std::copy_n(data + L, L, tmp + m * L);
+            for (std::size_t k = 1; k < m; ++k)
+                for (std::size_t l = 0; l < L; ++l) {
+                    tmp[k * L + l]       = data[2 * k * L + l];
+                    tmp[(m + k) * L + l] = data[(2 * k + 1) * L + l] + data[(2 * k - 1) * L + l];
+                }
+            inverse_rec<L>(tmp,         data, work, m, level + 1);
+            inverse_rec<L>(tmp + m * L, data, work, m, level + 1);
+            const T* hs = m_half_sec[level].data();
+            for (std::size_t i = 0; i < m; ++i) {
+                const T* u = tmp + i * L;
+                const T* v = tmp + (m + i) * L;
+                T* lo = data + i * L;
+                T* hi = data + (n - 1 - i) * L;
+                for (std::size_t l = 0; l < L; ++l) {
+                    const T w = v[l] * hs[i];
+                    lo[l] = u[l] + w;
+                    hi[l] = u[l] - w;
+                }
+            }
+        }
+
+    public:
+        explicit DctPlan(std::size_t n) : m_n(n), m_leaf(n) {
+            assert(n > 0);
+            const long double pi = std::numbers::pi_v<long double>;
+            while (m_leaf % 2 == 0) {
+                const std::size_t m = m_leaf / 2;
+                std::vector<T> hs(m);
+                for (std::size_t i = 0; i < m; ++i)
+                    hs[i] = static_cast<T>(0.5L / std::cos(pi * (static_cast<long double>(i) + 0.5L)
+                                                          / static_cast<long double>(m_leaf)));
+                m_half_sec.push_back(std::move(hs));
+                m_leaf = m;
+            }
+            if (m_leaf > detail::dct_dense_leaf_max) {
+                m_fft = FftPlan<T>::get(m_leaf);
+                assert(2 * m_leaf + m_fft->scratch_size() <= detail::dct_leaf_work(m_n));
+                m_leaf_tw_re.resize(m_leaf);
+                m_leaf_tw_im.resize(m_leaf);
+                for (std::size_t k = 0; k < m_leaf; ++k) {
+                    const long double a = pi * static_cast<long double>(k) / (2 * static_cast<long double>(m_leaf));
+                    m_leaf_tw_re[k] = static_cast<T>(std::cos(a));
+                    m_leaf_tw_im[k] = static_cast<T>(std::sin(a));
+                }
+                return;
+            }
+            m_leaf_cos.resize(m_leaf * m_leaf);
+            for (std::size_t k = 0; k < m_leaf; ++k)
+                for (std::size_t i = 0; i < m_leaf; ++i)
+                    m_leaf_cos[k * m_leaf + i] = static_cast<T>(std::cos(pi * (static_cast<long double>(i) + 0.5L)
+                                                                         * static_cast<long double>(k)
+                                                                         / static_cast<long double>(m_leaf)));
+        }
+
+        [[nodiscard]] std::size_t size() const noexcept { return m_n; }
+
+        // éléments de scratch attendus pour lanes signaux à la fois
+        [[nodiscard]] std::size_t scratch_size(std::size_t lanes = 1) const noexcept {
+            return lanes * m_n + detail::dct_leaf_work(m_n);
+        }
+
+        // X[k] = sum_n x[n] cos(pi (n + 1/2) k / N), en place ; scratch de scratch_size() éléments
+        void forward(T* data, T* scratch) const { forward_rec<1>(data, scratch, scratch + m_n, m_n, 0); }
+
+        // x[n] = sum_k X[k] cos(pi (n + 1/2) k / N), en place ; scratch de scratch_size() éléments
+        void inverse(T* data, T* scratch) const { inverse_rec<1>(data, scratch, scratch + m_n, m_n, 0); }
+
+        // L signaux à la fois (data[i * L + l] : échantillon i du signal l), en place ;
+        // scratch de scratch_size(L) éléments. Mêmes opérations que forward / inverse, voie par voie.
+        template<std::size_t L>
+        void forward_lanes(T* data, T* scratch) const { forward_rec<L>(data, scratch, scratch + L * m_n, m_n, 0); }
+
+        template<std::size_t L>
+        void inverse_lanes(T* data, T* scratch) const { inverse_rec<L>(data, scratch, scratch + L * m_n, m_n, 0); }
+
+        // plan partagé (construit une seule fois par taille, utilisable par plusieurs threads)
+        [[nodiscard]] static std::shared_ptr<const DctPlan> get(std::size_t n) {
+            return detail::cached_plan<DctPlan>(n);
+        }
+    };
+
+    // ===== frame_view : lot de count trames de length échantillons =====
+    // at(f, i) = data[f * frame_stride + i * sample_stride]. rows : trames rangées l'une après
+    // l'autre (pas stride >= length) ; interleaved : échantillon i de toutes les trames côte à
+    // côte, comme un flux multicanal. Vue non possédante, comme std::span.
+    template<typename T>
+    struct frame_view {
+        T*          data          = nullptr;
+        std::size_t count         = 0;
+        std::size_t length        = 0;
+        std::size_t frame_stride  = 0;
+        std::size_t sample_stride = 1;
+
+        [[nodiscard]] static frame_view rows(T* p, std::size_t count, std::size_t length) noexcept {
+            return {p, count, length, length, 1};
+        }
+        [[nodiscard]] static frame_view rows(T* p, std::size_t count, std::size_t length, std::size_t stride) noexcept {
+            assert(stride >= length);
+            return {p, count, length, stride, 1};
+        }
+        [[nodiscard]] static frame_view interleaved(T* p, std::size_t count, std::size_t length) noexcept {
+            return {p, count, length, 1, count};
+        }
+
+        [[nodiscard]] T& at(std::size_t f, std::size_t i) const noexcept {
+            return data[f * frame_stride + i * sample_stride];
+        }
+        // trames [first, first + n)
+        [[nodiscard]] frame_view subframes(std::size_t first, std::size_t n) const noexcept {
+            assert(first + n <= count);
+            return {data + first * frame_stride, n, length, frame_stride, sample_stride};
+        }
+
+        operator frame_view<const T>() const noexcept requires (!std::is_const_v<T>) {
+            return {data, count, length, frame_stride, sample_stride};
+        }
+    };
+
+    namespace detail {
+        // trames transformées ensemble : un échantillon du groupe occupe une ligne de cache
+        // (deux registres AVX2) ; plus de voies amortit aussi la récursion de DctPlan
+        template<typename T>
+        inline constexpr std::size_t batch_lanes = 64 / sizeof(T);
+
+        // au-delà, les L trames ne tiennent plus en cache : une trame à la fois
+        inline constexpr std::size_t batch_lane_max = 1024;
+    } // namespace detail
+
+    // Stats : politique d'instrumentation (stats.hpp) ; DiscreteCosinus = sans instrumentation
+    template<typename Stats = stats::none>
+    struct BasicDiscreteCosinus {
+        // type de calcul : R s'il est flottant, double sinon
+        template<typename R>
+        using compute_t = std::conditional_t<std::is_floating_point_v<R>, R, double>;
+
+        // ramène la fréquence k dans [0, N] : X[k + 2N] = -X[k], X[2N - k] = -X[k], X[N] = 0.
+        // Renvoie (indice, signe) ; indice == N désigne un coefficient nul.
+        [[nodiscard]] static std::pair<std::size_t, int> fold(std::size_t k, std::size_t N) noexcept {
+            std::size_t kk = k % (4 * N);
+            int sign = 1;
+            if (kk >= 2 * N) { kk -= 2 * N; sign = -sign; }
+            if (kk > N)      { kk = 2 * N - kk; sign = -sign; }
+            return {kk, sign};
+        }
+
+        // taille du tampon de travail de encode_into / decode_into pour une transformée de taille n
+        [[nodiscard]] static constexpr std::size_t work_size(std::size_t n) noexcept {
+            return 2 * n + detail::dct_leaf_work(n);
+        }
+
+        // énergie des coefficients gardés (k < nb_coefs) rapportée à celle du spectre ;
+        // coefficient k non normalisé en buf[k * stride]
+        template<typename T>
+        static void note_energy(const T* buf, std::size_t stride, std::size_t N, std::size_t nb_coefs, T scale) {
+            auto& c = Stats::local().dct;
+            double all = 0.0, kept = 0.0;
+            for (std::size_t k = 0; k < N; ++k) {
+                const double e = static_cast<double>(buf[k * stride]) * static_cast<double>(buf[k * stride]);
+                all += e;
+                if (k < nb_coefs) kept += e;
+            }
+            const double s2 = static_cast<double>(scale) * static_cast<double>(scale);
+            ++c.blocks;
+            c.coefs += N;
+            c.kept += std::min(nb_coefs, N);
+            c.energy += all * s2;
+            c.energy_kept += kept * s2;
+        }
+
+        // taille du tampon de travail de encode_batch_into / decode_batch_into (trames de taille n)
+        template<typename R>
+        [[nodiscard]] static constexpr std::size_t batch_work_size(std::size_t n) noexcept {
+            return 2 * n * detail::batch_lanes<compute_t<R>> + detail::dct_leaf_work(n);
+        }
+
+        // D = type des données d'entrée (arithmétique), R = type des coefficients ;
+        // X[k] = sqrt(2/N) sum_n x[n] cos(pi (n + 1/2) k / N), calculé par DctPlan.
+        // Sans allocation : out reçoit les out.size() premiers coefficients, work (au moins
+        // work_size(N) valeurs) sert de tampon.
         template <typename D, typename R>
         requires (std::is_arithmetic_v<D> && std::is_arithmetic_v<R>)
-        [[nodiscard]]
-        static std::vector<R> encode(std::span<const D> source, std::size_t nb_coefs) {
-            if (source.empty() || nb_coefs == 0) return {};
-            using std::cos;
+        static void encode_into(std::span<const D> source, std::span<R> out, std::span<compute_t<R>> work) {
+            using T = compute_t<R>;
             const auto N = source.size();
-            std::vector<R> res(nb_coefs, R{0});
+            const std::size_t nb_coefs = out.size();
+            if (N == 0 || nb_coefs == 0) { std::fill(out.begin(), out.end(), R{0}); return; }
+            assert(work.size() >= work_size(N));
+            [[maybe_unused]] typename Stats::timer t(stats::stage::dct_forward);
+            const auto plan = DctPlan<T>::get(N);
+            T* const buf = work.data();
+            std::copy(source.begin(), source.end(), buf);
+            plan->forward(buf, buf + N);
+
+            const T scale = std::sqrt(T{2} / static_cast<T>(N));
+            if constexpr (Stats::enabled) note_energy(buf, 1, N, nb_coefs, scale);
             for (std::size_t k = 0; k < nb_coefs; ++k) {
-                R sum = R{0};
-                for (std::size_t n = 0; n < N; ++n) {
-                    sum += static_cast<R>(source[n]) *
-                           static_cast<R>(cos(std::numbers::pi_v<long double> * (static_cast<long double>(n) + 0.5L)
-                                              * static_cast<long double>(k) / static_cast<long double>(N)));
-                }
-                res[k] = sum * static_cast<R>(std::sqrt(2.0 / static_cast<long double>(N)));
+                auto [kk, sign] = fold(k, N);
+                const T v = kk < N ? buf[kk] : T{0};
+                out[k] = static_cast<R>(sign * v * scale);
             }
+        }
+
+        template <typename D, typename R>
+        requires (std::is_arithmetic_v<D> && std::is_arithmetic_v<R>)
+        [[nodiscard]]
+        static std::vector<R> encode(std::span<const D> source, std::size_t nb_coefs) {
+            if (source.empty() || nb_coefs == 0) return {};
+            std::vector<R> res(nb_coefs);
+            std::vector<compute_t<R>> work(work_size(source.size()));
+            encode_into<D, R>(source, std::span<R>(res), std::span<compute_t<R>>(work));
             return res;
         }
 
+        // x[n] = sqrt(2/size) sum_k X[k] cos(pi (n + 1/2) k / size), size = out.size(), calculé
+        // par DctPlan. Sans allocation : work compte au moins work_size(size) valeurs.
+        template <typename D, typename R>
+        requires (std::is_arithmetic_v<D> && std::is_arithmetic_v<R>)
+        static void decode_into(std::span<const R> encoded, std::span<D> out, std::span<compute_t<R>> work) {
+            using T = compute_t<R>;
+            const std::size_t size = out.size();
+            if (encoded.empty() || size == 0) { std::fill(out.begin(), out.end(), D{}); return; }
+            assert(work.size() >= work_size(size));
+            [[maybe_unused]] typename Stats::timer t(stats::stage::dct_inverse);
+            const auto plan = DctPlan<T>::get(size);
+            T* const buf = work.data();
+            std::fill_n(buf, size, T{0});
+            for (std::size_t k = 0; k < encoded.size(); ++k) {
+                auto [kk, sign] = fold(k, size);
+                if (kk < size) buf[kk] += static_cast<T>(sign) * static_cast<T>(encoded[k]);
+            }
+            plan->inverse(buf, buf + size);
+
+            const T scale = std::sqrt(T{2} / static_cast<T>(size));
+            for (std::size_t n = 0; n < size; ++n) out[n] = static_cast<D>(buf[n] * scale);
+        }
+
         template <typename D, typename R>
         requires (std::is_arithmetic_v<D> && std::is_arithmetic_v<R>)
         [[nodiscard]]
         static std::vector<D> decode(std::span<const R> encoded, std::size_t size) {
-            if (encoded.empty() || size == 0) return std::vector<D>(size, D{});
-            using std::cos;
-            const auto K = encoded.size();
             std::vector<D> res(size, D{});
-            for (std::size_t n = 0; n < size; ++n) {
-                long double acc = 0.0L;
-                for (std::size_t k = 0; k < K; ++k) {
-                    acc += static_cast<long double>(encoded[k]) *
-                           cos(std::numbers::pi_v<long double> *
-                               (static_cast<long double>(n) + 0.5L) *
-                               static_cast<long double>(k) / static_cast<long double>(size));
+            if (encoded.empty() || size == 0) return res;
+            std::vector<compute_t<R>> work(work_size(size));
+            decode_into<D, R>(encoded, std::span<D>(res), std::span<compute_t<R>>(work));
+            return res;
+        }
+
+        // ===== Lots de trames =====
+        // Même transformée que encode_into / decode_into, pour src.count trames de même taille.
+        // Le plan est cherché une fois par appel ; pour N <= detail::batch_lane_max, les trames
+        // passent par groupes de detail::batch_lanes<T> : un groupe est rangé échantillon par
+        // échantillon (une trame par voie SIMD) et transformé par DctPlan::forward_lanes.
+        // Sans allocation : work compte au moins batch_work_size<R>(N) valeurs.
+    private:
+        template<std::size_t L, typename D, typename R, typename T>
+        static void encode_groups(const DctPlan<T>& plan, frame_view<const D> src, frame_view<R> out, T* buf) {
+            const std::size_t N = src.length;
+            const std::size_t nb_coefs = out.length;
+            const T scale = std::sqrt(T{2} / static_cast<T>(N));
+            for (std::size_t f0 = 0; f0 < src.count; f0 += L) {
+                const std::size_t nb = std::min(L, src.count - f0);
+                for (std::size_t i = 0; i < N; ++i) {
+                    T* row = buf + i * L;
+                    for (std::size_t l = 0; l < nb; ++l) row[l] = static_cast<T>(src.at(f0 + l, i));
+                    std::fill(row + nb, row + L, T{0});
+                }
+                plan.template forward_lanes<L>(buf, buf + N * L);
+                if constexpr (Stats::enabled)
+                    for (std::size_t l = 0; l < nb; ++l) note_energy(buf + l, L, N, nb_coefs, scale);
+                for (std::size_t k = 0; k < nb_coefs; ++k) {
+                    auto [kk, sign] = fold(k, N);
+                    for (std::size_t l = 0; l < nb; ++l) {
+                        const T v = kk < N ? buf[kk * L + l] : T{0};
+                        out.at(f0 + l, k) = static_cast<R>(sign * v * scale);
+                    }
                 }
-                acc *= std::sqrt(2.0L / static_cast<long double>(size));
-                res[n] = static_cast<D>(acc);
             }
+        }
+
+        template<std::size_t L, typename D, typename R, typename T>
+        static void decode_groups(const DctPlan<T>& plan, frame_view<const R> encoded, frame_view<D> out, T* buf) {
+            const std::size_t size = out.length;
+            const T scale = std::sqrt(T{2} / static_cast<T>(size));
+            for (std::size_t f0 = 0; f0 < out.count; f0 += L) {
+                const std::size_t nb = std::min(L, out.count - f0);
+                std::fill_n(buf, size * L, T{0});
+                for (std::size_t k = 0; k < encoded.length; ++k) {
+                    auto [kk, sign] = fold(k, size);
+                    if (kk == size) continue;
+                    for (std::size_t l = 0; l < nb; ++l)
+                        buf[kk * L + l] += static_cast<T>(sign) * static_cast<T>(encoded.at(f0 + l, k));
+                }
+                plan.template inverse_lanes<L>(buf, buf + size * L);
+                for (std::size_t n = 0; n < size; ++n)
+                    for (std::size_t l = 0; l < nb; ++l) out.at(f0 + l, n) = static_cast<D>(buf[n * L + l] * scale);
+            }
+        }
+
+    public:
+        // out.at(f, k) = coefficient k de la trame f (k < out.length) ; out.count == src.count
+        template <typename D, typename R>
+        requires (std::is_arithmetic_v<D> && std::is_arithmetic_v<R>)
+        static void encode_batch_into(frame_view<const D> src, frame_view<R> out, std::span<compute_t<R>> work) {
+            using T = compute_t<R>;
+            assert(out.count == src.count);
+            if (src.count == 0 || out.length == 0) return;
+            if (src.length == 0) {
+                for (std::size_t f = 0; f < out.count; ++f)
+                    for (std::size_t k = 0; k < out.length; ++k) out.at(f, k) = R{0};
+                return;
+            }
+            assert(work.size() >= batch_work_size<R>(src.length));
+            [[maybe_unused]] typename Stats::timer t(stats::stage::dct_forward);
+            const auto plan = DctPlan<T>::get(src.length);
+            if (src.length <= detail::batch_lane_max)
+                encode_groups<detail::batch_lanes<T>>(*plan, src, out, work.data());
+            else
+                encode_groups<1>(*plan, src, out, work.data());
+        }
+
+        // out.at(f, n) = échantillon n de la trame f (size = out.length) ; encoded.count == out.count
+        template <typename D, typename R>
+        requires (std::is_arithmetic_v<D> && std::is_arithmetic_v<R>)
+        static void decode_batch_into(frame_view<const R> encoded, frame_view<D> out, std::span<compute_t<R>> work) {
+            using T = compute_t<R>;
+            assert(encoded.count == out.count);
+            if (out.count == 0 || out.length == 0) return;
+            if (encoded.length == 0) {
+                for (std::size_t f = 0; f < out.count; ++f)
+                    for (std::size_t n = 0; n < out.length; ++n) out.at(f, n) = D{};
+                return;
+            }
+            assert(work.size() >= batch_work_size<R>(out.length));
+            [[maybe_unused]] typename Stats::timer t(stats::stage::dct_inverse);
+            const auto plan = DctPlan<T>::get(out.length);
+            if (out.length <= detail::batch_lane_max)
+                decode_groups<detail::batch_lanes<T>>(*plan, encoded, out, work.data());
+            else
+                decode_groups<1>(*plan, encoded, out, work.data());
+        }
+
+        // coefficients rangés trame après trame : résultat[f * nb_coefs + k]
+        template <typename D, typename R>
+        requires (std::is_arithmetic_v<D> && std::is_arithmetic_v<R>)
+        [[nodiscard]]
+        static std::vector<R> encode_batch(frame_view<const D> src, std::size_t nb_coefs) {
+            std::vector<R> res(src.count * nb_coefs);
+            std::vector<compute_t<R>> work(batch_work_size<R>(src.length));
+            encode_batch_into<D, R>(src, frame_view<R>::rows(res.data(), src.count, nb_coefs), work);
+            return res;
+        }
+
+        // encoded : count trames de coefficients rangées l'une après l'autre ; résultat[f * size + n]
+        template <typename D, typename R>
+        requires (std::is_arithmetic_v<D> && std::is_arithmetic_v<R>)
+        [[nodiscard]]
+        static std::vector<D> decode_batch(frame_view<const R> encoded, std::size_t size) {
+            std::vector<D> res(encoded.count * size, D{});
+            std::vector<compute_t<R>> work(batch_work_size<R>(size));
+            decode_batch_into<D, R>(encoded, frame_view<D>::rows(res.data(), encoded.count, size), work);
             return res;
         }
     };
 
+    using DiscreteCosinus = BasicDiscreteCosinus<>;
+
+    // ===== Noyaux de quantification =====
+    // q = arrondi(x * inv) (au plus proche, demi loin de zéro comme std::lround), saturé au type Q,
+    // 0 pour NaN ; x = q * step. Versions AVX2 / SSE4.1 choisies à l'exécution (utils::simd_support),
+    // reste scalaire.
+    namespace detail {
+        template<typename Q>
+        concept quantized_int = std::same_as<Q, std::int16_t> || std::same_as<Q, std::int32_t>;
+
+        // plus grand T <= max(Q) (2^31 - 1 n'est pas représentable en float)
+        template<std::floating_point T, quantized_int Q>
+        inline constexpr T quant_max = std::is_same_v<T, float> && std::is_same_v<Q, std::int32_t>
+                                     ? T(2147483520.0) : T(std::numeric_limits<Q>::max());
+
+        // NaN donne 0, comme les noyaux vectoriels
+        template<std::floating_point T, quantized_int Q>
+        [[nodiscard]] inline Q quantize_one(T v) noexcept {
+            if (std::isnan(v)) return Q{0};
+            v = std::clamp(v, T(std::numeric_limits<Q>::min()), quant_max<T, Q>);
+            const T t = std::trunc(v);
+            return static_cast<Q>(t + (std::abs(v - t) >= T(0.5) ? std::copysign(T{1}, v) : T{0}));
+        }
+
+#ifdef ENCODING_X86_SIMD
+        // traite un multiple de la largeur vectorielle, renvoie le nombre d'éléments faits
+        template<std::floating_point T, quantized_int Q>
+        __attribute__((target("avx2")))
+        std::size_t quantize_avx2(const T* x, const T* inv, T inv1, Q* out, std::size_t n) noexcept {
+            std::size_t i = 0;
+            if constexpr (std::is_same_v<T, double>) {
+                const __m256d lo = _mm256_set1_pd(std::numeric_limits<Q>::min()), hi = _mm256_set1_pd(quant_max<T, Q>);
+                const __m256d half = _mm256_set1_pd(0.5), one = _mm256_set1_pd(1.0), sign = _mm256_set1_pd(-0.0);
+                const __m256d r1 = _mm256_set1_pd(inv1);
+                for (; i + 4 <= n; i += 4) {
+                    __m256d v = _mm256_mul_pd(_mm256_loadu_pd(x + i), inv ? _mm256_loadu_pd(inv + i) : r1);
+                    v = _mm256_and_pd(v, _mm256_cmp_pd(v, v, _CMP_ORD_Q)); // NaN -> 0
+                    v = _mm256_min_pd(_mm256_max_pd(v, lo), hi);
+                    const __m256d t = _mm256_round_pd(v, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+                    const __m256d d = _mm256_andnot_pd(sign, _mm256_sub_pd(v, t));
+                    const __m256d s = _mm256_or_pd(one, _mm256_and_pd(sign, v));
+                    const __m128i q = _mm256_cvttpd_epi32(_mm256_add_pd(t, _mm256_and_pd(_mm256_cmp_pd(d, half, _CMP_GE_OQ), s)));
+                    if constexpr (std::is_same_v<Q, std::int32_t>) _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), q);
+                    else _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi32(q, q));
+                }
+            } else {
+                const __m256 lo = _mm256_set1_ps(static_cast<float>(std::numeric_limits<Q>::min())), hi = _mm256_set1_ps(quant_max<T, Q>);
+                const __m256 half = _mm256_set1_ps(0.5f), one = _mm256_set1_ps(1.0f), sign = _mm256_set1_ps(-0.0f);
+                const __m256 r1 = _mm256_set1_ps(inv1);
+                for (; i + 8 <= n; i += 8) {
+                    __m256 v = _mm256_mul_ps(_mm256_loadu_ps(x + i), inv ? _mm256_loadu_ps(inv + i) : r1);
+                    v = _mm256_and_ps(v, _mm256_cmp_ps(v, v, _CMP_ORD_Q));
+                    v = _mm256_min_ps(_mm256_max_ps(v, lo), hi);
+                    const __m256 t = _mm256_round_ps(v, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+                    const __m256 d = _mm256_andnot_ps(sign, _mm256_sub_ps(v, t));
+                    const __m256 s = _mm256_or_ps(one, _mm256_and_ps(sign, v));
+                    const __m256i q = _mm256_cvttps_epi32(_mm256_add_ps(t, _mm256_and_ps(_mm256_cmp_ps(d, half, _CMP_GE_OQ), s)));
+                    if constexpr (std::is_same_v<Q, std::int32_t>) _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), q);
+                    else _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+                                          _mm_packs_epi32(_mm256_castsi256_si128(q), _mm256_extracti128_si256(q, 1)));
+                }
+            }
+            return i;
+        }
+
+        template<std::floating_point T, quantized_int Q>
+        __attribute__((target("sse4.1")))
+        std::size_t quantize_sse41(const T* x, const T* inv, T inv1, Q* out, std::size_t n) noexcept {
+            std::size_t i = 0;
+            if constexpr (std::is_same_v<T, double>) {
+                const __m128d lo = _mm_set1_pd(std::numeric_limits<Q>::min()), hi = _mm_set1_pd(quant_max<T, Q>);
+                const __m128d half = _mm_set1_pd(0.5), one = _mm_set1_pd(1.0), sign = _mm_set1_pd(-0.0);
+                const __m128d r1 = _mm_set1_pd(inv1);
+                for (; i + 2 <= n; i += 2) {
+                    __m128d v = _mm_mul_pd(_mm_loadu_pd(x + i), inv ? _mm_loadu_pd(inv + i) : r1);
+                    v = _mm_and_pd(v, _mm_cmpord_pd(v, v)); // NaN -> 0
+                    v = _mm_min_pd(_mm_max_pd(v, lo), hi);
+                    const __m128d t = _mm_round_pd(v, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+                    const __m128d d = _mm_andnot_pd(sign, _mm_sub_pd(v, t));
+                    const __m128d s = _mm_or_pd(one, _mm_and_pd(sign, v));
+                    const __m128i q = _mm_cvttpd_epi32(_mm_add_pd(t, _mm_and_pd(_mm_cmpge_pd(d, half), s)));
+                    if constexpr (std::is_same_v<Q, std::int32_t>) _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), q);
+                    else {
+                        const int packed = _mm_cvtsi128_si32(_mm_packs_epi32(q, q));
+                        std::memcpy(out + i, &packed, sizeof(packed));
+                    }
+                }
+            } else {
+                const __m128 lo = _mm_set1_ps(static_cast<float>(std::numeric_limits<Q>::min())), hi = _mm_set1_ps(quant_max<T, Q>);
+                const __m128 half = _mm_set1_ps(0.5f), one = _mm_set1_ps(1.0f), sign = _mm_set1_ps(-0.0f);
+                const __m128 r1 = _mm_set1_ps(inv1);
+                for (; i + 4 <= n; i += 4) {
+                    __m128 v = _mm_mul_ps(_mm_loadu_ps(x + i), inv ? _mm_loadu_ps(inv + i) : r1);
+                    v = _mm_and_ps(v, _mm_cmpord_ps(v, v));
+                    v = _mm_min_ps(_mm_max_ps(v, lo), hi);
+                    const __m128 t = _mm_round_ps(v, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+                    const __m128 d = _mm_andnot_ps(sign, _mm_sub_ps(v, t));
+                    const __m128 s = _mm_or_ps(one, _mm_and_ps(sign, v));
+                    const __m128i q = _mm_cvttps_epi32(_mm_add_ps(t, _mm_and_ps(_mm_cmpge_ps(d, half), s)));
+                    if constexpr (std::is_same_v<Q, std::int32_t>) _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), q);
+                    else _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi32(q, q));
+                }
+            }
+            return i;
+        }
+
+        template<std::floating_point T, quantized_int Q>
+        __attribute__((target("avx2")))
+        std::size_t dequantize_avx2(const Q* q, const T* step, T step1, T* out, std::size_t n) noexcept {
+            std::size_t i = 0;
+            if constexpr (std::is_same_v<T, double>) {
+                const __m256d s1 = _mm256_set1_pd(step1);
+                for (; i + 4 <= n; i += 4) {
+                    const __m128i v = std::is_same_v<Q, std::int32_t>
+                        ? _mm_loadu_si128(reinterpret_cast<const __m128i*>(q + i))
+                        : _mm_cvtepi16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(q + i)));
+                    _mm256_storeu_pd(out + i, _mm256_mul_pd(_mm256_cvtepi32_pd(v), step ? _mm256_loadu_pd(step + i) : s1));
+                }
+            } else {
+                const __m256 s1 = _mm256_set1_ps(step1);
+                for (; i + 8 <= n; i += 8) {
+                    const __m256i v = std::is_same_v<Q, std::int32_t>
+                        ? _mm256_loadu_si256(reinterpret_cast<const __m256i*>(q + i))
+                        : _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(q + i)));
+                    _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(v), step ? _mm256_loadu_ps(step + i) : s1));
+                }
+            }
+            return i;
+        }
+
+        template<std::floating_point T, quantized_int Q>
+        __attribute__((target("sse4.1")))
+        std::size_t dequantize_sse41(const Q* q, const T* step, T step1, T* out, std::size_t n) noexcept {
+            std::size_t i = 0;
+            if constexpr (std::is_same_v<T, double>) {
+                const __m128d s1 = _mm_set1_pd(step1);
+                for (; i + 2 <= n; i += 2) {
+                    std::int32_t pair[2] = {q[i], q[i + 1]};
+                    const __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(pair));
+                    _mm_storeu_pd(out + i, _mm_mul_pd(_mm_cvtepi32_pd(v), step ? _mm_loadu_pd(step + i) : s1));
+                }
+            } else {
+                const __m128 s1 = _mm_set1_ps(step1);
+                for (; i + 4 <= n; i += 4) {
+                    const __m128i v = std::is_same_v<Q, std::int32_t>
+                        ? _mm_loadu_si128(reinterpret_cast<const __m128i*>(q + i))
+                        : _mm_cvtepi16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(q + i)));
+                    _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(v), step ? _mm_loadu_ps(step + i) : s1));
+                }
+            }
+            return i;
+        }
+#endif
+
+        // inv == nullptr : réciproque constante inv1
+        template<std::floating_point T, quantized_int Q>
+        void quantize(const T* x, const T* inv, T inv1, Q* out, std::size_t n) noexcept {
+            std::size_t i = 0;
+#ifdef ENCODING_X86_SIMD
+            switch (utils::simd_support()) {
+                case utils::simd_level::avx2:  i = quantize_avx2<T, Q>(x, inv, inv1, out, n);  break;
+                case utils::simd_level::sse41: i = quantize_sse41<T, Q>(x, inv, inv1, out, n); break;
+                case utils::simd_level::scalar: break;
+            }
+#endif
+            for (; i < n; ++i) out[i] = quantize_one<T, Q>(x[i] * (inv ? inv[i] : inv1));
+        }
+
+        // step == nullptr : pas constant step1
+        template<std::floating_point T, quantized_int Q>
+        void dequantize(const Q* q, const T* step, T step1, T* out, std::size_t n) noexcept {
+            std::size_t i = 0;
+#ifdef ENCODING_X86_SIMD
+            switch (utils::simd_support()) {
+                case utils::simd_level::avx2:  i = dequantize_avx2<T, Q>(q, step, step1, out, n);  break;
+                case utils::simd_level::sse41: i = dequantize_sse41<T, Q>(q, step, step1, out, n); break;
+                case utils::simd_level::scalar: break;
+            }
+#endif
+            for (; i < n; ++i) out[i] = static_cast<T>(q[i]) * (step ? step[i] : step1);
+        }
+    } // namespace detail
+
+    // table de pas précalculée (utilisable en constexpr) avec ses inverses
+    template<std::floating_point T, std::size_t N>
+    struct quantum_table {
+        std::array<T, N> step{};
+        std::array<T, N> inv{};
+
+        constexpr explicit quantum_table(const std::array<T, N>& steps) : step(steps) {
+            for (std::size_t i = 0; i < N; ++i) inv[i] = T{1} / steps[i];
+        }
+    };
+
+    // vue sur une table de pas et ses inverses (même taille, non vide) ; appliquée périodiquement
+    template<std::floating_point T>
+    struct quantum_view {
+        std::span<const T> step;
+        std::span<const T> inv;
+
+        quantum_view(std::span<const T> s, std::span<const T> i) : step(s), inv(i) {
+            assert(!step.empty() && step.size() == inv.size());
+        }
+        template<std::size_t N>
+        quantum_view(const quantum_table<T, N>& t) : quantum_view(std::span<const T>(t.step), std::span<const T>(t.inv)) {}
+    };
+
     struct Quantization {
         using get_quantum_t = std::function<double(std::size_t)>;
 
-        // quantum constant
+        // inverses d'une table de pas, à associer dans une quantum_view
+        template<std::floating_point T>
+        [[nodiscard]]
+        static std::vector<T> inverses(std::span<const T> steps) {
+            std::vector<T> inv(steps.size());
+            for (std::size_t i = 0; i < steps.size(); ++i) inv[i] = T{1} / steps[i];
+            return inv;
+        }
+
+        // ----- sans allocation : out.size() == source.size(), Q = int16_t (saturé) ou int32_t -----
+        template<std::floating_point T, typename Q>
+        requires detail::quantized_int<Q>
+        static void encode_into(std::span<const T> source, T quantum, std::span<Q> out) noexcept {
+            assert(out.size() == source.size());
+            detail::quantize<T, Q>(source.data(), nullptr, T{1} / quantum, out.data(), source.size());
+        }
+
+        template<std::floating_point T, typename Q>
+        requires detail::quantized_int<Q>
+        static void encode_into(std::span<const T> source, quantum_view<T> table, std::span<Q> out) noexcept {
+            assert(out.size() == source.size());
+            const std::size_t L = table.inv.size();
+            for (std::size_t o = 0; o < source.size(); o += L)
+                detail::quantize<T, Q>(source.data() + o, table.inv.data(), T{0}, out.data() + o,
+                                       std::min(L, source.size() - o));
+        }
+
+        template<typename Q, std::floating_point T>
+        requires detail::quantized_int<Q>
+        static void decode_into(std::span<const Q> source, T quantum, std::span<T> out) noexcept {
+            assert(out.size() == source.size());
+            detail::dequantize<T, Q>(source.data(), nullptr, quantum, out.data(), source.size());
+        }
+
+        template<typename Q, std::floating_point T>
+        requires detail::quantized_int<Q>
+        static void decode_into(std::span<const Q> source, quantum_view<T> table, std::span<T> out) noexcept {
+            assert(out.size() == source.size());
+            const std::size_t L = table.step.size();
+            for (std::size_t o = 0; o < source.size(); o += L)
+                detail::dequantize<T, Q>(source.data() + o, table.step.data(), T{0}, out.data() + o,
+                                         std::min(L, source.size() - o));
+        }
+
+        // quantum constant : division exacte, x / quantum arrondi par std::lround. Les noyaux
+        // vectoriels (multiplication par 1 / quantum, qui peut différer d'un pas quand x / quantum
+        // tombe près d'un demi-entier) passent par encode_into et les tables de pas.
         template<typename D>
         requires std::is_arithmetic_v<D>
         [[nodiscard]]
@@ -82,6 +805,23 @@ namespace encoding::lossy {
             return res;
         }
 
+        // table de pas précalculée (quantum_table constexpr ou quantum_view sur des spans)
+        template<std::floating_point T>
+        [[nodiscard]]
+        static std::vector<int> encode(std::span<const T> source, quantum_view<T> table) {
+            std::vector<int> res(source.size());
+            encode_into<T, int>(source, table, res);
+            return res;
+        }
+
+        template<std::floating_point T>
+        [[nodiscard]]
+        static std::vector<T> decode(std::span<const int> source, quantum_view<T> table) {
+            std::vector<T> res(source.size());
+            decode_into<int, T>(source, table, res);
+            return res;
+        }
+
         // quantum par coefficient (version std::function)
         template<typename D>
         requires std::is_arithmetic_v<D>
@@ -134,7 +874,12 @@ namespace encoding::lossy {
     };
 
     struct DiscreteFourier {
-        // encode renvoie (parties réelle, imaginaire)
+        template<typename R>
+        using compute_t = DiscreteCosinus::compute_t<R>;
+
+        // encode renvoie (parties réelle, imaginaire) :
+        // real[k] = sum_n x[n] cos(2 pi k n / N), imag[k] = sum_n x[n] sin(2 pi k n / N),
+        // soit le conjugué de la FFT réelle (RealFftPlan) ; k >= N est pris modulo N.
         template<typename D, typename R>
         requires (std::is_arithmetic_v<D> && std::is_arithmetic_v<R>)
         [[nodiscard]]
@@ -142,25 +887,50 @@ namespace encoding::lossy {
         encode(std::span<const D> source, std::size_t nb_coefs) {
             std::vector<R> real, imag;
             if (source.empty() || nb_coefs == 0) return {real, imag};
-
             real.assign(nb_coefs, R{});
             imag.assign(nb_coefs, R{});
-            const auto N = source.size();
-            for (std::size_t k = 0; k < nb_coefs; ++k) {
-                R rr = R{}, ii = R{};
-                for (std::size_t n = 0; n < N; ++n) {
-                    const long double theta =
-                        (2.0L * std::numbers::pi_v<long double> * static_cast<long double>(k) * static_cast<long double>(n))
-                        / static_cast<long double>(N);
-                    rr += static_cast<R>(source[n]) * static_cast<R>(std::cos(theta));
-                    ii += static_cast<R>(source[n]) * static_cast<R>(std::sin(theta));
+            encode_batch<D, R>(frame_view<const D>::rows(source.data(), 1, source.size()),
+                               frame_view<R>::rows(real.data(), 1, nb_coefs),
+                               frame_view<R>::rows(imag.data(), 1, nb_coefs));
+            return {real, imag};
+        }
+
+        // encode pour src.count trames : real.at(f, k), imag.at(f, k) (k < real.length).
+        // Un plan et un tampon de travail pour tout le lot (une allocation par appel).
+        template<typename D, typename R>
+        requires (std::is_arithmetic_v<D> && std::is_arithmetic_v<R>)
+        static void encode_batch(frame_view<const D> src, frame_view<R> real, frame_view<R> imag) {
+            assert(real.count == src.count && imag.count == src.count && real.length == imag.length);
+            const std::size_t N = src.length;
+            const std::size_t nb_coefs = real.length;
+            if (src.count == 0 || nb_coefs == 0) return;
+            if (N == 0) {
+                for (std::size_t f = 0; f < src.count; ++f)
+                    for (std::size_t k = 0; k < nb_coefs; ++k) real.at(f, k) = imag.at(f, k) = R{};
+                return;
+            }
+
+            using T = compute_t<R>;
+            const auto plan = RealFftPlan<T>::get(N);
+            const std::size_t h = plan->spectrum_size();
+            std::vector<T> work(N + 2 * h + plan->scratch_size());
+            T* const x  = work.data();
+            T* const re = x + N;
+            T* const im = re + h;
+            for (std::size_t f = 0; f < src.count; ++f) {
+                for (std::size_t n = 0; n < N; ++n) x[n] = static_cast<T>(src.at(f, n));
+                plan->forward(x, re, im, im + h);
+                for (std::size_t k = 0; k < nb_coefs; ++k) {
+                    const std::size_t kk = k % N;
+                    // X[N - k] = conj(X[k]) pour un signal réel
+                    if (kk < h) { real.at(f, k) = static_cast<R>(re[kk]);     imag.at(f, k) = static_cast<R>(T{0} - im[kk]); }
+                    else        { real.at(f, k) = static_cast<R>(re[N - kk]); imag.at(f, k) = static_cast<R>(im[N - kk]); }
                 }
-                real[k] = rr;
-                imag[k] = ii;
             }
-            return {real, imag};
         }
 
+        // x[n] = (1/K) sum_k (real[k] cos(2 pi k n / K) - imag[k] sin(2 pi k n / K)), K = nb de coefficients,
+        // calculé par une FftPlan inverse de taille K (n >= K est pris modulo K)
         template<typename D, typename R>
         requires (std::is_arithmetic_v<D> && std::is_arithmetic_v<R>)
         [[nodiscard]]
@@ -173,18 +943,14 @@ namespace encoding::lossy {
             std::vector<D> out(size, D{});
             if (size == 0 || K == 0) return out;
 
-            for (std::size_t n = 0; n < size; ++n) {
-                long double acc = 0.0L;
-                for (std::size_t k = 0; k < K; ++k) {
-                    const long double theta =
-                        (2.0L * std::numbers::pi_v<long double> * static_cast<long double>(k) * static_cast<long double>(n))
-                        / static_cast<long double>(K);
-                    acc += static_cast<long double>(real[k]) * std::cos(theta)
-                         - static_cast<long double>(imag[k]) * std::sin(theta);
-                }
-                // normalisation simple par K (cohérente avec encode ci-dessus)
-                out[n] = static_cast<D>(acc / static_cast<long double>(K));
-            }
+            using T = compute_t<R>;
+            const auto plan = FftPlan<T>::get(K);
+            std::vector<T> re(real.begin(), real.end()), im(imag.begin(), imag.end()), scratch(plan->scratch_size());
+            plan->inverse(re.data(), im.data(), scratch.data());
+
+            // normalisation simple par K (cohérente avec encode ci-dessus)
+            const T inv = T{1} / static_cast<T>(K);
+            for (std::size_t n = 0; n < size; ++n) out[n] = static_cast<D>(re[n % K] * inv);
             return out;
         }
     };
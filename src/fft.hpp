@@ -0,0 +1,352 @@
+#pragma once
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <cmath>
+#include <numbers>
+#include <concepts>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <bit>
+
+namespace encoding::lossy {
+
+    namespace detail {
+        // plans gardés par type de plan : les plan_cache_capacity derniers utilisés. Au-delà, le
+        // moins récemment demandé sort du cache ; il vit tant qu'un appelant (ou un plan de
+        // Bluestein, pour sa convolution) en garde le shared_ptr. Un processus qui passe par
+        // beaucoup de tailles ne garde donc qu'un nombre borné de plans.
+        inline constexpr std::size_t plan_cache_capacity = 64;
+
+        template<typename Plan>
+        struct plan_cache {
+            struct entry {
+                std::shared_ptr<const Plan> plan;
+                std::uint64_t               last_use;
+            };
+            std::mutex                             m;
+            std::unordered_map<std::size_t, entry> plans;
+            std::uint64_t                          tick = 0;
+
+            [[nodiscard]] static plan_cache& instance() {
+                static plan_cache c;
+                return c;
+            }
+        };
+
+        // un plan par taille, construit à la première demande puis partagé (lecture seule).
+        // La construction se fait hors verrou : un plan peut demander un sous-plan (Bluestein).
+        template<typename Plan>
+        [[nodiscard]] std::shared_ptr<const Plan> cached_plan(std::size_t n) {
+            auto& c = plan_cache<Plan>::instance();
+            {
+                std::lock_guard lk(c.m);
+                if (auto it = c.plans.find(n); it != c.plans.end()) {
+                    it->second.last_use = ++c.tick;
+                    return it->second.plan;
+                }
+            }
+            auto p = std::make_shared<const Plan>(n);
+            std::lock_guard lk(c.m);
+            if (auto it = c.plans.find(n); it != c.plans.end()) return it->second.plan;
+            if (c.plans.size() >= plan_cache_capacity) {
+                auto lru = c.plans.begin();
+                for (auto it = c.plans.begin(); it != c.plans.end(); ++it)
+                    if (it->second.last_use < lru->second.last_use) lru = it;
+                c.plans.erase(lru);
+            }
+            c.plans.emplace(n, typename plan_cache<Plan>::entry{p, ++c.tick});
+            return p;
+        }
+
+        // nombre de plans de type Plan gardés par le cache
+        template<typename Plan>
+        [[nodiscard]] std::size_t cached_plan_count() {
+            auto& c = plan_cache<Plan>::instance();
+            std::lock_guard lk(c.m);
+            return c.plans.size();
+        }
+    } // namespace detail
+
+    // ===== FftPlan : FFT complexe, parties réelle et imaginaire dans deux tableaux =====
+    // Tailles à facteurs premiers <= max_radix : Stockham auto-trié en radix 4, 2, 3 puis
+    // radix génériques (pas de permutation finale, boucle interne contiguë par étage).
+    // Autres tailles : Bluestein (convolution par une FFT radix 2/4 de taille puissance de deux).
+    // X[k] = sum_n x[n] exp(-2 pi i n k / N) ; inverse : signe +, sans normalisation.
+    template<std::floating_point T>
+    class FftPlan {
+    public:
+        static constexpr std::size_t max_radix = 31;
+
+    private:
+        struct stage {
+            std::size_t radix;
+            std::size_t l_prev;     // longueur des DFT déjà calculées
+            std::size_t m_out;      // nombre de sous-suites après l'étage
+            std::size_t tw_offset;  // twiddles w_{l_prev * radix}^{q f}, rangés [f * (radix - 1) + q - 1]
+            std::size_t root_offset;// racines radix-ièmes (radix génériques), rangées [g * radix + q]
+        };
+
+        std::size_t        m_n;
+        std::vector<stage> m_stages;
+        std::vector<T>     m_tw_re, m_tw_im;
+        std::vector<T>     m_root_re, m_root_im;
+
+        // Bluestein
+        std::shared_ptr<const FftPlan> m_conv;
+        std::vector<T>                 m_chirp_re, m_chirp_im;   // exp(-pi i n^2 / N)
+        std::vector<T>                 m_filter_re, m_filter_im; // FFT_M(conj(chirp)) / M
+
+        static void cis(long double angle, T& re, T& im) {
+            re = static_cast<T>(std::cos(angle));
+            im = static_cast<T>(std::sin(angle));
+        }
+
+        void run_stage(const stage& st, const T* ar, const T* ai, T* br, T* bi) const {
+            const std::size_t p = st.radix, L = st.l_prev, m = st.m_out, m_in = m * p;
+            const T* twr = m_tw_re.data() + st.tw_offset;
+            const T* twi = m_tw_im.data() + st.tw_offset;
+            for (std::size_t f = 0; f < L; ++f) {
+                const T* xr = ar + f * m_in;
+                const T* xi = ai + f * m_in;
+                const T* wr = twr + f * (p - 1);
+                const T* wi = twi + f * (p - 1);
+                T* yr = br + f * m;
+                T* yi = bi + f * m;
+                const std::size_t ys = L * m; // écart entre deux sorties g et g + 1
+                if (p == 2) {
+                    const T w1r = wr[0], w1i = wi[0];
+                    for (std::size_t r = 0; r < m; ++r) {
+                        const T ur = xr[m + r] * w1r - xi[m + r] * w1i;
+                        const T ui = xr[m + r] * w1i + xi[m + r] * w1r;
+                        yr[r]      = xr[r] + ur; yi[r]      = xi[r] + ui;
+                        yr[ys + r] = xr[r] - ur; yi[ys + r] = xi[r] - ui;
+                    }
+                } else if (p == 4) {
+                    const T w1r = wr[0], w1i = wi[0], w2r = wr[1], w2i = wi[1], w3r = wr[2], w3i = wi[2];
+                    for (std::size_t r = 0; r < m; ++r) {
+                        const T u0r = xr[r], u0i = xi[r];
+                        const T u1r = xr[m + r] * w1r - xi[m + r] * w1i,         u1i = xr[m + r] * w1i + xi[m + r] * w1r;
+                        const T u2r = xr[2 * m + r] * w2r - xi[2 * m + r] * w2i, u2i = xr[2 * m + r] * w2i + xi[2 * m + r] * w2r;
+                        const T u3r = xr[3 * m + r] * w3r - xi[3 * m + r] * w3i, u3i = xr[3 * m + r] * w3i + xi[3 * m + r] * w3r;
+                        const T t0r = u0r + u2r, t0i = u0i + u2i, t1r = u0r - u2r, t1i = u0i - u2i;
+                        const T t2r = u1r + u3r, t2i = u1i + u3i, t3r = u1r - u3r, t3i = u1i - u3i;
+                        yr[r]          = t0r + t2r; yi[r]          = t0i + t2i;
+                        yr[ys + r]     = t1r + t3i; yi[ys + r]     = t1i - t3r;
+                        yr[2 * ys + r] = t0r - t2r; yi[2 * ys + r] = t0i - t2i;
+                        yr[3 * ys + r] = t1r - t3i; yi[3 * ys + r] = t1i + t3r;
+                    }
+                } else if (p == 3) {
+                    const T c = static_cast<T>(std::numbers::sqrt3_v<long double> / 2);
+                    const T w1r = wr[0], w1i = wi[0], w2r = wr[1], w2i = wi[1];
+                    for (std::size_t r = 0; r < m; ++r) {
+                        const T u0r = xr[r], u0i = xi[r];
+                        const T u1r = xr[m + r] * w1r - xi[m + r] * w1i,         u1i = xr[m + r] * w1i + xi[m + r] * w1r;
+                        const T u2r = xr[2 * m + r] * w2r - xi[2 * m + r] * w2i, u2i = xr[2 * m + r] * w2i + xi[2 * m + r] * w2r;
+                        const T sr = u1r + u2r, si = u1i + u2i, dr = u1r - u2r, di = u1i - u2i;
+                        const T mr = u0r - sr / 2, mi = u0i - si / 2;
+                        yr[r]          = u0r + sr;  yi[r]          = u0i + si;
+                        yr[ys + r]     = mr + c * di; yi[ys + r]     = mi - c * dr;
+                        yr[2 * ys + r] = mr - c * di; yi[2 * ys + r] = mi + c * dr;
+                    }
+                } else {
+                    const T* rr = m_root_re.data() + st.root_offset;
+                    const T* ri = m_root_im.data() + st.root_offset;
+                    T ur[max_radix], ui[max_radix];
+                    for (std::size_t r = 0; r < m; ++r) {
+                        ur[0] = xr[r]; ui[0] = xi[r];
+                        for (std::size_t q = 1; q < p; ++q) {
+                            const T a = xr[q * m + r], b = xi[q * m + r];
+                            ur[q] = a * wr[q - 1] - b * wi[q - 1];
+                            ui[q] = a * wi[q - 1] + b * wr[q - 1];
+                        }
+                        for (std::size_t g = 0; g < p; ++g) {
+                            T sr = T{0}, si = T{0};
+                            for (std::size_t q = 0; q < p; ++q) {
+                                sr += ur[q] * rr[g * p + q] - ui[q] * ri[g * p + q];
+                                si += ur[q] * ri[g * p + q] + ui[q] * rr[g * p + q];
+                            }
+                            yr[g * ys + r] = sr; yi[g * ys + r] = si;
+                        }
+                    }
+                }
+            }
+        }
+
+        void bluestein(T* re, T* im, T* scratch) const {
+            const std::size_t M = m_conv->size();
+            T* ar = scratch;
+            T* ai = scratch + M;
+            for (std::size_t n = 0; n < m_n; ++n) {
+                ar[n] = re[n] * m_chirp_re[n] - im[n] * m_chirp_im[n];
+                ai[n] = re[n] * m_chirp_im[n] + im[n] * m_chirp_re[n];
+            }
+            std::fill(ar + m_n, ar + M, T{0});
+            std::fill(ai + m_n, ai + M, T{0});
+            m_conv->forward(ar, ai, scratch + 2 * M);
+            for (std::size_t k = 0; k < M; ++k) {
+                const T r = ar[k] * m_filter_re[k] - ai[k] * m_filter_im[k];
+                const T i = ar[k] * m_filter_im[k] + ai[k] * m_filter_re[k];
+                ar[k] = r; ai[k] = i;
+            }
+            m_conv->inverse(ar, ai, scratch + 2 * M);
+            for (std::size_t k = 0; k < m_n; ++k) {
+                re[k] = ar[k] * m_chirp_re[k] - ai[k] * m_chirp_im[k];
+                im[k] = ar[k] * m_chirp_im[k] + ai[k] * m_chirp_re[k];
+            }
+        }
+
+    public:
+        explicit FftPlan(std::size_t n) : m_n(n) {
+            assert(n > 0);
+            const long double pi = std::numbers::pi_v<long double>;
+
+            std::vector<std::size_t> radices;
+            std::size_t rest = n;
+            while (rest % 4 == 0) { radices.push_back(4); rest /= 4; }
+            while (rest % 2 == 0) { radices.push_back(2); rest /= 2; }
+            for (std::size_t p = 3; p <= max_radix && rest > 1; p += 2)
+                while (rest % p == 0) { radices.push_back(p); rest /= p; }
+
+            if (rest > 1) {
+                // facteur premier trop grand : Bluestein sur la taille entière
+                const std::size_t M = std::bit_ceil(2 * n - 1);
+                m_conv = detail::cached_plan<FftPlan>(M);
+                m_chirp_re.resize(n); m_chirp_im.resize(n);
+                // k^2 mod 2N, tenu à jour par (k + 1)^2 = k^2 + 2k + 1 pour garder un angle précis
+                for (std::size_t k = 0, k2 = 0; k < n; k2 = (k2 + 2 * k + 1) % (2 * n), ++k)
+                    cis(-pi * static_cast<long double>(k2) / static_cast<long double>(n), m_chirp_re[k], m_chirp_im[k]);
+                m_filter_re.assign(M, T{0}); m_filter_im.assign(M, T{0});
+                m_filter_re[0] = m_chirp_re[0]; m_filter_im[0] = -m_chirp_im[0];
+                for (std::size_t k = 1; k < n; ++k) {
+                    m_filter_re[k] = m_filter_re[M - k] = m_chirp_re[k];
+                    m_filter_im[k] = m_filter_im[M - k] = -m_chirp_im[k];
+                }
+                std::vector<T> tmp(m_conv->scratch_size());
+                m_conv->forward(m_filter_re.data(), m_filter_im.data(), tmp.data());
+                const T inv = T{1} / static_cast<T>(M);
+                for (std::size_t k = 0; k < M; ++k) { m_filter_re[k] *= inv; m_filter_im[k] *= inv; }
+                return;
+            }
+
+            std::size_t L = 1;
+            for (std::size_t p : radices) {
+                stage st{p, L, n / (L * p), m_tw_re.size(), m_root_re.size()};
+                const std::size_t Lp = L * p;
+                for (std::size_t f = 0; f < L; ++f)
+                    for (std::size_t q = 1; q < p; ++q) {
+                        T wr, wi;
+                        cis(-2 * pi * static_cast<long double>(q * f) / static_cast<long double>(Lp), wr, wi);
+                        m_tw_re.push_back(wr); m_tw_im.push_back(wi);
+                    }
+                if (p > 4) {
+                    for (std::size_t g = 0; g < p; ++g)
+                        for (std::size_t q = 0; q < p; ++q) {
+                            T wr, wi;
+                            cis(-2 * pi * static_cast<long double>((g * q) % p) / static_cast<long double>(p), wr, wi);
+                            m_root_re.push_back(wr); m_root_im.push_back(wi);
+                        }
+                }
+                m_stages.push_back(st);
+                L = Lp;
+            }
+        }
+
+        [[nodiscard]] std::size_t size() const noexcept { return m_n; }
+
+        // nombre d'éléments T de mémoire de travail attendus par forward / inverse
+        [[nodiscard]] std::size_t scratch_size() const noexcept {
+            return m_conv ? 2 * m_conv->size() + m_conv->scratch_size() : 2 * m_n;
+        }
+
+        // en place sur (re, im)
+        void forward(T* re, T* im, T* scratch) const {
+            if (m_conv) { bluestein(re, im, scratch); return; }
+            T *ar = re, *ai = im, *br = scratch, *bi = scratch + m_n;
+            for (const auto& st : m_stages) {
+                run_stage(st, ar, ai, br, bi);
+                std::swap(ar, br);
+                std::swap(ai, bi);
+            }
+            if (ar != re) {
+                std::copy_n(ar, m_n, re);
+                std::copy_n(ai, m_n, im);
+            }
+        }
+
+        // x[n] = sum_k X[k] exp(+2 pi i n k / N) : transformée directe sur (im, re)
+        void inverse(T* re, T* im, T* scratch) const { forward(im, re, scratch); }
+
+        [[nodiscard]] static std::shared_ptr<const FftPlan> get(std::size_t n) {
+            return detail::cached_plan<FftPlan>(n);
+        }
+    };
+
+    // ===== RealFftPlan : FFT d'un signal réel, demi-spectre X[0..N/2] =====
+    // N pair : le signal est replié en N/2 complexes (pairs en partie réelle, impairs en
+    // partie imaginaire), transformé par une FftPlan de taille N/2 puis séparé.
+    template<std::floating_point T>
+    class RealFftPlan {
+    private:
+        std::size_t                           m_n;
+        std::shared_ptr<const FftPlan<T>>     m_plan;
+        std::vector<T>                        m_tw_re, m_tw_im; // exp(-2 pi i k / N), k <= N/2
+
+    public:
+        explicit RealFftPlan(std::size_t n) : m_n(n) {
+            assert(n > 0);
+            if (n % 2 != 0) { m_plan = FftPlan<T>::get(n); return; }
+            m_plan = FftPlan<T>::get(n / 2);
+            const long double pi = std::numbers::pi_v<long double>;
+            m_tw_re.resize(n / 2 + 1); m_tw_im.resize(n / 2 + 1);
+            for (std::size_t k = 0; k <= n / 2; ++k) {
+                const long double a = -2 * pi * static_cast<long double>(k) / static_cast<long double>(n);
+                m_tw_re[k] = static_cast<T>(std::cos(a));
+                m_tw_im[k] = static_cast<T>(std::sin(a));
+            }
+        }
+
+        [[nodiscard]] std::size_t size() const noexcept { return m_n; }
+        [[nodiscard]] std::size_t spectrum_size() const noexcept { return m_n / 2 + 1; }
+        [[nodiscard]] std::size_t scratch_size() const noexcept {
+            return (m_n % 2 ? 2 * m_n : m_n) + m_plan->scratch_size();
+        }
+
+        // out_re / out_im : spectrum_size() éléments
+        void forward(const T* x, T* out_re, T* out_im, T* scratch) const {
+            if (m_n % 2 != 0) {
+                T* zr = scratch;
+                T* zi = scratch + m_n;
+                std::copy_n(x, m_n, zr);
+                std::fill_n(zi, m_n, T{0});
+                m_plan->forward(zr, zi, scratch + 2 * m_n);
+                std::copy_n(zr, spectrum_size(), out_re);
+                std::copy_n(zi, spectrum_size(), out_im);
+                return;
+            }
+            const std::size_t h = m_n / 2;
+            T* zr = scratch;
+            T* zi = scratch + h;
+            for (std::size_t j = 0; j < h; ++j) { zr[j] = x[2 * j]; zi[j] = x[2 * j + 1]; }
+            m_plan->forward(zr, zi, scratch + m_n);
+            for (std::size_t k = 0; k <= h; ++k) {
+                const std::size_t a = k % h, b = (h - k) % h;
+                // E = (Z[k] + conj Z[h-k]) / 2, O = (Z[k] - conj Z[h-k]) / 2i
+                const T er = (zr[a] + zr[b]) / 2, ei = (zi[a] - zi[b]) / 2;
+                const T orr = (zi[a] + zi[b]) / 2, oi = -(zr[a] - zr[b]) / 2;
+                out_re[k] = er + orr * m_tw_re[k] - oi * m_tw_im[k];
+                out_im[k] = ei + orr * m_tw_im[k] + oi * m_tw_re[k];
+            }
+        }
+
+        [[nodiscard]] static std::shared_ptr<const RealFftPlan> get(std::size_t n) {
+            return detail::cached_plan<RealFftPlan>(n);
+        }
+    };
+
+} // namespace encoding::lossy
@@ -0,0 +1,325 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <span>
+#include <optional>
+#include <utility>
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <cstdint>
+#include <cstddef>
+#include <cassert>
+#include <limits>
+#include "encoding_lossless.hpp"
+#include "encoding_lossy.hpp"
+#include "container.hpp"
+#include "utils.hpp"
+
+namespace encoding::image {
+
+    // ===== BlockDct : DCT-II 2D orthonormée d'un bloc B x B, B fixé à la compilation =====
+    // Séparable (lignes puis colonnes) ; chaque passe s'écrit comme des combinaisons de lignes
+    // de longueur B (y += a * x), que le compilateur déroule et vectorise.
+    // C[k][n] = a(k) cos(pi (2n + 1) k / 2B), a(0) = sqrt(1/B), a(k) = sqrt(2/B).
+    template<std::size_t B>
+    struct BlockDct {
+        static constexpr std::size_t area = B * B;
+
+        struct tables {
+            std::array<float, area> c;  // C[k][n]
+            std::array<float, area> ct; // C[n][k] (transposée)
+        };
+
+        static const tables& basis() {
+            static const tables t = [] {
+                tables r{};
+                const long double pi = std::numbers::pi_v<long double>;
+                for (std::size_t k = 0; k < B; ++k)
+                    for (std::size_t n = 0; n < B; ++n) {
+                        const long double a = std::sqrt((k == 0 ? 1.0L : 2.0L) / static_cast<long double>(B));
+                        const auto v = static_cast<float>(a * std::cos(pi * static_cast<long double>(2 * n + 1)
+                                                                        * static_cast<long double>(k)
+                                                                        / static_cast<long double>(2 * B)));
+                        r.c[k * B + n]  = v;
+                        r.ct[n * B + k] = v;
+                    }
+                return r;
+            }();
+            return t;
+        }
+
+        // out[r] = sum_i m[r][i] * in[i] (lignes de B flottants)
+        static void combine(const float* m, const float* in, float* out) noexcept {
+            for (std::size_t r = 0; r < B; ++r) {
+                float acc[B] = {};
+                for (std::size_t i = 0; i < B; ++i) {
+                    const float a = m[r * B + i];
+                    for (std::size_t j = 0; j < B; ++j) acc[j] += a * in[i * B + j];
+                }
+                std::copy_n(acc, B, out + r * B);
+            }
+        }
+
+        // en place : Y = C X C^T
+        static void forward(float* blk) noexcept {
+            const auto& t = basis();
+            float tmp[area];
+            combine(blk, t.ct.data(), tmp);   // X C^T
+            combine(t.c.data(), tmp, blk);    // C (X C^T)
+        }
+
+        // en place : X = C^T Y C
+        static void inverse(float* blk) noexcept {
+            const auto& t = basis();
+            float tmp[area];
+            combine(blk, t.c.data(), tmp);    // Y C
+            combine(t.ct.data(), tmp, blk);   // C^T (Y C)
+        }
+    };
+
+    // parcours zigzag d'un bloc B x B : zz[i] = indice (ligne * B + colonne) du i-ème coefficient
+    template<std::size_t B>
+    [[nodiscard]] constexpr std::array<std::uint16_t, B * B> zigzag_order() noexcept {
+        std::array<std::uint16_t, B * B> z{};
+        std::size_t i = 0;
+        for (std::size_t s = 0; s < 2 * B - 1; ++s) {
+            const std::size_t lo = s >= B ? s - B + 1 : 0, hi = std::min(s, B - 1);
+            if (s % 2 == 0) for (std::size_t y = hi + 1; y-- > lo; ) z[i++] = static_cast<std::uint16_t>(y * B + s - y);
+            else            for (std::size_t y = lo; y <= hi; ++y)  z[i++] = static_cast<std::uint16_t>(y * B + s - y);
+        }
+        return z;
+    }
+
+    // matrice de luminance JPEG (annexe K), mise à l'échelle par quality (formule IJG) ;
+    // en 16 x 16 chaque pas couvre 2 x 2 coefficients et double (la DCT orthonormée y est deux fois plus ample)
+    [[nodiscard]] inline std::vector<std::uint16_t> quant_matrix(std::size_t block_size, int quality) {
+        static constexpr std::uint8_t luma[64] = {
+            16, 11, 10, 16,  24,  40,  51,  61,
+            12, 12, 14, 19,  26,  58,  60,  55,
+            14, 13, 16, 24,  40,  57,  69,  56,
+            14, 17, 22, 29,  51,  87,  80,  62,
+            18, 22, 37, 56,  68, 109, 103,  77,
+            24, 35, 55, 64,  81, 104, 113,  92,
+            49, 64, 78, 87, 103, 121, 120, 101,
+            72, 92, 95, 98, 112, 100, 103,  99};
+        quality = std::clamp(quality, 1, 100);
+        const long scale = quality < 50 ? 5000 / quality : 200 - 2 * quality;
+        const std::size_t f = block_size / 8;
+        std::vector<std::uint16_t> m(block_size * block_size);
+        for (std::size_t y = 0; y < block_size; ++y)
+            for (std::size_t x = 0; x < block_size; ++x) {
+                const long v = (luma[(y / f) * 8 + x / f] * scale + 50) / 100;
+                m[y * block_size + x] = static_cast<std::uint16_t>(std::clamp<long>(v, 1, 255) * static_cast<long>(f));
+            }
+        return m;
+    }
+
+    struct params {
+        std::size_t                block_size = 8;   // 8 ou 16
+        int                        quality    = 75;  // 1..100, ignoré si matrix est fournie
+        std::vector<std::uint16_t> matrix;           // pas de quantification (ordre ligne), block_size^2 valeurs
+        std::size_t                batch      = 64;  // nombre de blocs transformés ensemble
+        container::codec           entropy    = container::codec::huffman; // ou rans
+    };
+
+    struct plane {
+        std::size_t               width  = 0;
+        std::size_t               height = 0;
+        std::vector<std::uint8_t> pixels; // ligne par ligne
+    };
+
+    namespace detail {
+
+        // arrondi au plus proche (demi loin de zéro) sans appel libm
+        [[nodiscard]] inline int round_to_int(float v) noexcept {
+            return static_cast<int>(v + std::copysign(0.5f, v));
+        }
+
+        // coefficients quantifiés, bloc par bloc en ordre zigzag, DC codé en différence avec le bloc précédent
+        template<std::size_t B>
+        [[nodiscard]] std::vector<std::int16_t>
+        forward_blocks(std::span<const std::uint8_t> px, std::size_t w, std::size_t h,
+                       std::span<const std::uint16_t> matrix, std::size_t batch) {
+            constexpr std::size_t BB = B * B;
+            static constexpr auto zz = zigzag_order<B>();
+            const std::size_t bw = (w + B - 1) / B, nb = bw * ((h + B - 1) / B);
+            std::array<float, BB> step, inv;
+            for (std::size_t i = 0; i < BB; ++i) { step[i] = static_cast<float>(matrix[i]); inv[i] = 1.0f / step[i]; }
+            const lossy::quantum_view<float> table(step, inv);
+
+            std::vector<std::int16_t> coefs(nb * BB), q(batch * BB);
+            std::vector<float> buf(batch * BB);
+            for (std::size_t b0 = 0; b0 < nb; b0 += batch) {
+                const std::size_t n = std::min(batch, nb - b0);
+                // lecture des blocs (bords répliqués), centrés sur 0
+                for (std::size_t t = 0; t < n; ++t) {
+                    const std::size_t bx = (b0 + t) % bw * B, by = (b0 + t) / bw * B;
+                    float* blk = buf.data() + t * BB;
+                    for (std::size_t y = 0; y < B; ++y) {
+                        const std::uint8_t* row = px.data() + std::min(by + y, h - 1) * w;
+                        for (std::size_t x = 0; x < B; ++x)
+                            blk[y * B + x] = static_cast<float>(row[std::min(bx + x, w - 1)]) - 128.0f;
+                    }
+                }
+                for (std::size_t t = 0; t < n; ++t) BlockDct<B>::forward(buf.data() + t * BB);
+                lossy::Quantization::encode_into<float, std::int16_t>(std::span<const float>(buf).first(n * BB), table,
+                                                                      std::span(q).first(n * BB));
+                for (std::size_t t = 0; t < n; ++t) {
+                    const std::int16_t* blk = q.data() + t * BB;
+                    std::int16_t* out = coefs.data() + (b0 + t) * BB;
+                    for (std::size_t i = 0; i < BB; ++i) out[i] = blk[zz[i]];
+                }
+            }
+            std::int16_t prev = 0;
+            for (std::size_t b = 0; b < nb; ++b) {
+                const std::int16_t dc = coefs[b * BB];
+                coefs[b * BB] = static_cast<std::int16_t>(dc - prev);
+                prev = dc;
+            }
+            return coefs;
+        }
+
+        template<std::size_t B>
+        void inverse_blocks(std::span<std::int16_t> coefs, std::size_t w, std::size_t h,
+                            std::span<const std::uint16_t> matrix, std::size_t batch, std::uint8_t* px) {
+            constexpr std::size_t BB = B * B;
+            static constexpr auto zz = zigzag_order<B>();
+            const std::size_t bw = (w + B - 1) / B, nb = coefs.size() / BB;
+            std::int16_t prev = 0;
+            for (std::size_t b = 0; b < nb; ++b) {
+                prev = static_cast<std::int16_t>(prev + coefs[b * BB]);
+                coefs[b * BB] = prev;
+            }
+            std::array<float, BB> step, inv;
+            for (std::size_t i = 0; i < BB; ++i) { step[i] = static_cast<float>(matrix[i]); inv[i] = 1.0f / step[i]; }
+            const lossy::quantum_view<float> table(step, inv);
+
+            std::vector<std::int16_t> q(batch * BB);
+            std::vector<float> buf(batch * BB);
+            for (std::size_t b0 = 0; b0 < nb; b0 += batch) {
+                const std::size_t n = std::min(batch, nb - b0);
+                for (std::size_t t = 0; t < n; ++t) {
+                    std::int16_t* blk = q.data() + t * BB;
+                    const std::int16_t* in = coefs.data() + (b0 + t) * BB;
+                    for (std::size_t i = 0; i < BB; ++i) blk[zz[i]] = in[i];
+                }
+                lossy::Quantization::decode_into<std::int16_t, float>(std::span<const std::int16_t>(q).first(n * BB), table,
+                                                                      std::span(buf).first(n * BB));
+                for (std::size_t t = 0; t < n; ++t) BlockDct<B>::inverse(buf.data() + t * BB);
+                // écriture des blocs, rognés aux dimensions de l'image
+                for (std::size_t t = 0; t < n; ++t) {
+                    const std::size_t bx = (b0 + t) % bw * B, by = (b0 + t) / bw * B;
+                    const float* blk = buf.data() + t * BB;
+                    for (std::size_t y = 0; y < B && by + y < h; ++y) {
+                        std::uint8_t* row = px + (by + y) * w;
+                        for (std::size_t x = 0; x < B && bx + x < w; ++x)
+                            row[bx + x] = static_cast<std::uint8_t>(std::clamp(round_to_int(blk[y * B + x] + 128.0f), 0, 255));
+                    }
+                }
+            }
+        }
+
+    } // namespace detail
+
+    // Flux : 'D' 'I' | block_size u8 | width | height (varints) | matrice (block_size^2 varints)
+    //        | count_end (varint) | bloc container des valeurs non nulles (int16)
+    //        | bloc container des plages de zéros qui les précèdent (uint32)
+    // Chaîne : DCT 2D par blocs -> quantification -> zigzag (+ DC différentiel)
+    //          -> CompressRepeating sur 0 -> codeur entropique p.entropy (Huffman ou rANS, lu
+    //          dans l'en-tête des blocs au décodage).
+    [[nodiscard]]
+    inline std::vector<std::uint8_t> encode(std::span<const std::uint8_t> pixels, std::size_t width,
+                                            std::size_t height, const params& p = {}) {
+        assert(pixels.size() == width * height);
+        assert(p.block_size == 8 || p.block_size == 16);
+        const std::size_t B = p.block_size;
+        const auto matrix = p.matrix.empty() ? quant_matrix(B, p.quality) : p.matrix;
+        assert(matrix.size() == B * B);
+        const std::size_t batch = std::max<std::size_t>(p.batch, 1);
+
+        std::vector<std::int16_t> coefs;
+        if (width != 0 && height != 0)
+            coefs = B == 8 ? detail::forward_blocks<8>(pixels, width, height, matrix, batch)
+                           : detail::forward_blocks<16>(pixels, width, height, matrix, batch);
+        assert(coefs.size() <= std::numeric_limits<std::uint32_t>::max());
+
+        const auto [pairs, count_end] = lossless::CompressRepeating<std::int16_t>::encode(coefs, 0);
+        std::vector<std::int16_t>  values(pairs.size());
+        std::vector<std::uint32_t> runs(pairs.size());
+        for (std::size_t i = 0; i < pairs.size(); ++i) {
+            values[i] = pairs[i].first;
+            runs[i]   = static_cast<std::uint32_t>(pairs[i].second);
+        }
+
+        std::vector<std::uint8_t> out{'D', 'I', static_cast<std::uint8_t>(B)};
+        utils::put_varint(out, width);
+        utils::put_varint(out, height);
+        for (auto q : matrix) utils::put_varint(out, q);
+        utils::put_varint(out, count_end);
+        container::encode_block<std::int16_t>(out, values, p.entropy);
+        container::encode_block<std::uint32_t>(out, runs, p.entropy);
+        return out;
+    }
+
+    // nullopt si le flux est tronqué, incohérent ou corrompu. max_pixels borne width * height et
+    // le nombre de coefficients (blocs complets) avant toute allocation.
+    [[nodiscard]]
+    inline std::optional<plane> decode(std::span<const std::uint8_t> in, std::size_t batch = 64,
+                                       std::size_t max_pixels = container::default_max_bytes) {
+        if (in.size() < 3 || in[0] != 'D' || in[1] != 'I' || (in[2] != 8 && in[2] != 16)) return std::nullopt;
+        const std::size_t B = in[2], BB = B * B;
+        const std::uint8_t* p = in.data() + 3;
+        const std::uint8_t* const end = in.data() + in.size();
+        const auto w = utils::get_varint(p, end);
+        const auto h = utils::get_varint(p, end);
+        if (!w || !h) return std::nullopt;
+        // nombre de coefficients borné par les plages 32 bits
+        const std::uint64_t limit = std::numeric_limits<std::uint32_t>::max() / BB;
+        const std::uint64_t bw = (*w + B - 1) / B, bh = (*h + B - 1) / B;
+        if (*w > limit * B || *h > limit * B || (bw != 0 && bh > limit / bw)) return std::nullopt;
+        const std::uint64_t nb_coefs64 = bw * bh * BB;
+        if (*w * *h > max_pixels || nb_coefs64 > max_pixels) return std::nullopt;
+        const std::size_t nb_coefs = static_cast<std::size_t>(nb_coefs64);
+
+        std::vector<std::uint16_t> matrix(BB);
+        for (auto& q : matrix) {
+            const auto v = utils::get_varint(p, end);
+            if (!v || *v == 0 || *v > std::numeric_limits<std::uint16_t>::max()) return std::nullopt;
+            q = static_cast<std::uint16_t>(*v);
+        }
+        const auto count_end = utils::get_varint(p, end);
+        if (!count_end || *count_end > nb_coefs) return std::nullopt;
+
+        std::span<const std::uint8_t> rest(p, end);
+        const auto hv = container::read_header(rest);
+        if (!hv || hv->nb_symbols > nb_coefs - *count_end) return std::nullopt;
+        std::vector<std::int16_t> values(hv->nb_symbols);
+        const auto used_v = container::decode_block<std::int16_t>(rest, values);
+        if (!used_v) return std::nullopt;
+        rest = rest.subspan(*used_v);
+        const auto hr = container::read_header(rest);
+        if (!hr || hr->nb_symbols != values.size()) return std::nullopt;
+        std::vector<std::uint32_t> runs(values.size());
+        const auto used_r = container::decode_block<std::uint32_t>(rest, runs);
+        if (!used_r || *used_r != rest.size()) return std::nullopt;
+
+        std::uint64_t total = *count_end + values.size();
+        std::vector<std::pair<std::int16_t, std::size_t>> pairs(values.size());
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            total += runs[i];
+            pairs[i] = {values[i], runs[i]};
+        }
+        if (total != nb_coefs) return std::nullopt;
+        auto coefs = lossless::CompressRepeating<std::int16_t>::decode(pairs, *count_end, 0);
+
+        plane img{static_cast<std::size_t>(*w), static_cast<std::size_t>(*h), {}};
+        img.pixels.resize(img.width * img.height);
+        batch = std::max<std::size_t>(batch, 1);
+        if (B == 8) detail::inverse_blocks<8>(coefs, img.width, img.height, matrix, batch, img.pixels.data());
+        else        detail::inverse_blocks<16>(coefs, img.width, img.height, matrix, batch, img.pixels.data());
+        return img;
+    }
+
+} // namespace encoding::image
@@ -0,0 +1,240 @@
+#pragma once
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <optional>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+
+namespace encoding::io {
+
+    // ===== Entrées / sorties fichier (POSIX) =====
+    // InputFile lit un fichier sans le charger : projection mmap (les codecs lisent directement
+    // le cache de pages au travers de spans), ou pread dans un tampon si la projection échoue.
+    // AsyncWriter écrit en double tampon : un thread écrit un tampon pendant que l'appelant
+    // remplit l'autre, le disque et le calcul se recouvrent.
+
+    class InputFile {
+    private:
+        int                       m_fd   = -1;
+        std::uint64_t             m_size = 0;
+        std::uint8_t*             m_map  = nullptr;
+        std::uint64_t             m_released = 0; // pages rendues (projection)
+        std::vector<std::uint8_t> m_buf;          // lectures pread
+
+        InputFile(int fd, std::uint64_t size) : m_fd(fd), m_size(size) {}
+
+    public:
+        InputFile(const InputFile&) = delete;
+        InputFile& operator=(const InputFile&) = delete;
+        InputFile(InputFile&& o) noexcept
+            : m_fd(std::exchange(o.m_fd, -1)), m_size(o.m_size), m_map(std::exchange(o.m_map, nullptr)),
+              m_released(o.m_released), m_buf(std::move(o.m_buf)) {}
+        InputFile& operator=(InputFile&&) = delete;
+
+        ~InputFile() {
+            if (m_map) ::munmap(m_map, static_cast<std::size_t>(m_size));
+            if (m_fd >= 0) ::close(m_fd);
+        }
+
+        // fichier régulier seulement ; use_map = false force pread. nullopt si l'ouverture échoue.
+        [[nodiscard]] static std::optional<InputFile> open(const char* path, bool use_map = true) {
+            const int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+            if (fd < 0) return std::nullopt;
+            struct stat st{};
+            if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) { ::close(fd); return std::nullopt; }
+            InputFile f(fd, static_cast<std::uint64_t>(st.st_size));
+            if (use_map && f.m_size > 0) {
+                void* p = ::mmap(nullptr, static_cast<std::size_t>(f.m_size), PROT_READ, MAP_PRIVATE, fd, 0);
+                if (p != MAP_FAILED) {
+                    f.m_map = static_cast<std::uint8_t*>(p);
+                    ::madvise(p, static_cast<std::size_t>(f.m_size), MADV_SEQUENTIAL);
+                }
+            }
+            return f;
+        }
+
+        [[nodiscard]] std::uint64_t size() const noexcept { return m_size; }
+        [[nodiscard]] bool mapped() const noexcept { return m_map != nullptr; }
+
+        // octets [offset, offset + n) : vue dans la projection, ou lus par pread dans un tampon
+        // interne (valide jusqu'au prochain appel). Plus court en fin de fichier ; nullopt si la
+        // lecture échoue.
+        [[nodiscard]] std::optional<std::span<const std::uint8_t>> read(std::uint64_t offset, std::size_t n) {
+            if (offset >= m_size) return std::span<const std::uint8_t>{};
+            n = static_cast<std::size_t>(std::min<std::uint64_t>(n, m_size - offset));
+            if (m_map) return std::span<const std::uint8_t>(m_map + offset, n);
+            m_buf.resize(n);
+            std::size_t got = 0;
+            while (got < n) {
+                const ssize_t r = ::pread(m_fd, m_buf.data() + got, n - got, static_cast<off_t>(offset + got));
+                if (r < 0 && errno == EINTR) continue;
+                if (r <= 0) return std::nullopt;
+                got += static_cast<std::size_t>(r);
+            }
+            return std::span<const std::uint8_t>(m_buf);
+        }
+
+        // les octets avant end ne seront plus lus : leurs pages quittent l'espace du processus
+        // (le RSS reste borné sur un gros fichier projeté)
+        void release(std::uint64_t end) noexcept {
+            if (!m_map) return;
+            const auto page = static_cast<std::uint64_t>(::sysconf(_SC_PAGESIZE));
+            end = std::min(end, m_size) / page * page;
+            if (end <= m_released) return;
+            ::madvise(m_map + m_released, static_cast<std::size_t>(end - m_released), MADV_DONTNEED);
+            m_released = end;
+        }
+    };
+
+    // ===== AsyncWriter : écriture en double tampon =====
+    // write copie dans le tampon courant ; buffer / commit laissent l'appelant y produire ses
+    // octets sans copie. Un tampon plein part au thread d'écriture, l'appelant passe à l'autre
+    // et n'attend que si le précédent n'est pas encore écrit.
+    class AsyncWriter {
+    private:
+        int                       m_fd;
+        std::vector<std::uint8_t> m_buf[2];
+        std::size_t               m_fill = 0;   // tampon rempli par l'appelant
+        std::size_t               m_used = 0;   // octets utiles de m_buf[m_fill]
+        std::size_t               m_job  = 0;   // octets à écrire de m_buf[1 - m_fill]
+        bool                      m_busy = false;
+        bool                      m_stop = false;
+        bool                      m_error = false;
+        bool                      m_finished = false;
+        std::uint64_t             m_bytes = 0;
+        std::mutex                m_m;
+        std::condition_variable   m_cv;
+        std::thread               m_thread;
+
+        [[nodiscard]] bool write_all(const std::uint8_t* p, std::size_t n) noexcept {
+            while (n > 0) {
+                const ssize_t r = ::write(m_fd, p, n);
+                if (r < 0 && errno == EINTR) continue;
+                if (r <= 0) return false;
+                p += r;
+                n -= static_cast<std::size_t>(r);
+            }
+            return true;
+        }
+
+        void worker() {
+            std::unique_lock lk(m_m);
+            for (;;) {
+                m_cv.wait(lk, [&]{ return m_busy || m_stop; });
+                if (!m_busy) return;
+                const std::uint8_t* p = m_buf[1 - m_fill].data();
+                const std::size_t n = m_job;
+                lk.unlock();
+                const bool ok = write_all(p, n);
+                lk.lock();
+                if (!ok) m_error = true;
+                m_busy = false;
+                m_cv.notify_all();
+            }
+        }
+
+        // passe le tampon courant au thread d'écriture, une fois le précédent écrit
+        void submit() {
+            std::unique_lock lk(m_m);
+            m_cv.wait(lk, [&]{ return !m_busy; });
+            if (m_used == 0) return;
+            m_fill = 1 - m_fill;
+            m_job = m_used;
+            m_bytes += m_used;
+            m_used = 0;
+            m_busy = true;
+            m_cv.notify_all();
+        }
+
+    public:
+        // fd est fermé par finish ou par le destructeur
+        AsyncWriter(int fd, std::size_t capacity = std::size_t{1} << 22) : m_fd(fd) {
+            assert(capacity > 0);
+            m_buf[0].resize(capacity);
+            m_buf[1].resize(capacity);
+            m_thread = std::thread([this]{ worker(); });
+        }
+
+        AsyncWriter(const AsyncWriter&) = delete;
+        AsyncWriter& operator=(const AsyncWriter&) = delete;
+
+        ~AsyncWriter() { (void)finish(); }
+
+        // crée (ou tronque) path ; nullptr si l'ouverture échoue
+        [[nodiscard]] static std::unique_ptr<AsyncWriter> create(const char* path,
+                                                                 std::size_t capacity = std::size_t{1} << 22) {
+            const int fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            if (fd < 0) return nullptr;
+            return std::make_unique<AsyncWriter>(fd, capacity);
+        }
+
+        void write(std::span<const std::uint8_t> in) {
+            assert(!m_finished);
+            while (!in.empty()) {
+                const auto room = buffer();
+                const std::size_t k = std::min(room.size(), in.size());
+                std::copy_n(in.begin(), k, room.begin());
+                commit(k);
+                in = in.subspan(k);
+            }
+        }
+
+        // place libre du tampon courant (jamais vide)
+        [[nodiscard]] std::span<std::uint8_t> buffer() {
+            assert(!m_finished);
+            if (m_used == m_buf[m_fill].size()) submit();
+            return std::span<std::uint8_t>(m_buf[m_fill]).subspan(m_used);
+        }
+
+        // les n premiers octets de buffer() sont produits
+        void commit(std::size_t n) noexcept {
+            assert(m_used + n <= m_buf[m_fill].size());
+            m_used += n;
+        }
+
+        // octets passés au thread d'écriture (ou en attente dans le tampon courant)
+        [[nodiscard]] std::uint64_t bytes() const noexcept { return m_bytes + m_used; }
+
+        // écrit le reste, attend le thread et ferme le fichier ; false si une écriture a échoué
+        [[nodiscard]] bool finish() {
+            if (m_finished) return !m_error;
+            submit();
+            {
+                std::unique_lock lk(m_m);
+                m_cv.wait(lk, [&]{ return !m_busy; });
+                m_stop = true;
+            }
+            m_cv.notify_all();
+            m_thread.join();
+            if (::close(m_fd) != 0) m_error = true;
+            m_finished = true;
+            return !m_error;
+        }
+    };
+
+    // pic de mémoire résidente du processus, en octets
+    [[nodiscard]] inline std::size_t peak_rss() noexcept {
+        struct rusage ru{};
+        if (::getrusage(RUSAGE_SELF, &ru) != 0) return 0;
+#if defined(__APPLE__)
+        return static_cast<std::size_t>(ru.ru_maxrss);
+#else
+        return static_cast<std::size_t>(ru.ru_maxrss) * 1024;
+#endif
+    }
+
+} // namespace encoding::io
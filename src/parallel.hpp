@@ -0,0 +1,391 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <utility>
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <concepts>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+#include "container.hpp"
+#include "encoding_lossy.hpp"
+#include "utils.hpp"
+
+namespace encoding::parallel {
+
+    // ===== ThreadPool : files par thread avec vol de tâches =====
+    // Chaque worker dépile sa propre file par l'arrière et vole les autres par l'avant.
+    // Le thread appelant de parallel_for participe : un pool de n threads lance n - 1 workers.
+    class ThreadPool {
+    private:
+        using task_t = std::function<void()>;
+
+        struct worker_queue {
+            std::mutex         m;
+            std::deque<task_t> tasks;
+        };
+
+        std::vector<std::unique_ptr<worker_queue>> m_queues;
+        std::vector<std::thread>                   m_threads;
+        std::mutex                                 m_wake_m;
+        std::condition_variable                    m_wake;
+        std::atomic<std::ptrdiff_t>                m_pending{0}; // tâches en file, non démarrées
+        std::atomic<std::size_t>                   m_next{0};    // file de la prochaine soumission
+        bool                                       m_stop = false;
+
+        [[nodiscard]] std::optional<task_t> pop(std::size_t self) {
+            const std::size_t n = m_queues.size();
+            for (std::size_t k = 0; k < n; ++k) {
+                auto& q = *m_queues[(self + k) % n];
+                std::lock_guard lk(q.m);
+                if (q.tasks.empty()) continue;
+                task_t t;
+                if (k == 0) { t = std::move(q.tasks.back());  q.tasks.pop_back();  }
+                else        { t = std::move(q.tasks.front()); q.tasks.pop_front(); }
+                m_pending.fetch_sub(1, std::memory_order_relaxed);
+                return t;
+            }
+            return std::nullopt;
+        }
+
+        bool try_run(std::size_t self) {
+            auto t = pop(self);
+            if (!t) return false;
+            (*t)();
+            return true;
+        }
+
+        void worker(std::size_t self) {
+            for (;;) {
+                if (try_run(self)) continue;
+                std::unique_lock lk(m_wake_m);
+                m_wake.wait(lk, [&]{ return m_stop || m_pending.load() > 0; });
+                if (m_stop && m_pending.load() <= 0) return;
+            }
+        }
+
+        void submit(task_t t) {
+            {
+                std::lock_guard lk(m_wake_m);
+                m_pending.fetch_add(1, std::memory_order_relaxed);
+            }
+            auto& q = *m_queues[m_next.fetch_add(1, std::memory_order_relaxed) % m_queues.size()];
+            {
+                std::lock_guard lk(q.m);
+                q.tasks.push_back(std::move(t));
+            }
+            m_wake.notify_one();
+        }
+
+    public:
+        explicit ThreadPool(std::size_t nb_threads = std::max(1u, std::thread::hardware_concurrency())) {
+            const std::size_t workers = nb_threads > 1 ? nb_threads - 1 : 0;
+            for (std::size_t i = 0; i < std::max<std::size_t>(workers, 1); ++i)
+                m_queues.push_back(std::make_unique<worker_queue>());
+            for (std::size_t i = 0; i < workers; ++i)
+                m_threads.emplace_back([this, i]{ worker(i); });
+        }
+
+        ThreadPool(const ThreadPool&)            = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        ~ThreadPool() {
+            {
+                std::lock_guard lk(m_wake_m);
+                m_stop = true;
+            }
+            m_wake.notify_all();
+            for (auto& t : m_threads) t.join();
+        }
+
+        // nombre de threads de calcul, appelant compris
+        [[nodiscard]] std::size_t size() const noexcept { return m_threads.size() + 1; }
+
+        // exécute f(i) pour i dans [0, n) et attend la fin de toutes les tâches
+        void parallel_for(std::size_t n, const std::function<void(std::size_t)>& f) {
+            if (n == 0) return;
+            if (m_threads.empty()) { for (std::size_t i = 0; i < n; ++i) f(i); return; }
+
+            std::atomic<std::size_t> remaining{n};
+            std::mutex done_m;
+            std::condition_variable done;
+            for (std::size_t i = 0; i < n; ++i) {
+                submit([&, i]{
+                    f(i);
+                    std::lock_guard lk(done_m);
+                    if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) done.notify_all();
+                });
+            }
+            std::size_t self = 0;
+            while (remaining.load(std::memory_order_acquire) != 0) {
+                if (try_run(self++)) continue;
+                std::unique_lock lk(done_m);
+                done.wait(lk, [&]{ return remaining.load(std::memory_order_acquire) == 0; });
+            }
+            // la dernière tâche peut encore tenir done_m : on attend qu'elle le relâche
+            std::lock_guard lk(done_m);
+        }
+    };
+
+    // ===== Transformées par lots sur le pool =====
+    // Les trames sont découpées en tranches (multiples de la largeur SIMD, au moins
+    // min_batch_frames trames) ; chaque tranche a son tampon de travail et partage le plan
+    // mis en cache. Un petit lot reste sur le thread appelant.
+    inline constexpr std::size_t min_batch_frames = 256;
+
+    namespace detail {
+        // f(first, n) pour des tranches [first, first + n) couvrant [0, count)
+        template<typename F>
+        void for_frame_chunks(ThreadPool& pool, std::size_t count, std::size_t lanes, F&& f) {
+            std::size_t per = std::max(min_batch_frames, (count + 4 * pool.size() - 1) / (4 * pool.size()));
+            per = (per + lanes - 1) / lanes * lanes;
+            const std::size_t nb = (count + per - 1) / per;
+            if (nb <= 1) { f(std::size_t{0}, count); return; }
+            pool.parallel_for(nb, [&](std::size_t i) { f(i * per, std::min(per, count - i * per)); });
+        }
+    } // namespace detail
+
+    template<typename D, typename R, typename Stats = stats::none>
+    requires (std::is_arithmetic_v<D> && std::is_arithmetic_v<R>)
+    void dct_encode_batch(lossy::frame_view<const D> src, lossy::frame_view<R> out, ThreadPool& pool) {
+        using DC = lossy::BasicDiscreteCosinus<Stats>;
+        using T = typename DC::template compute_t<R>;
+        assert(out.count == src.count);
+        detail::for_frame_chunks(pool, src.count, lossy::detail::batch_lanes<T>, [&](std::size_t first, std::size_t n) {
+            std::vector<T> work(DC::template batch_work_size<R>(src.length));
+            DC::template encode_batch_into<D, R>(src.subframes(first, n), out.subframes(first, n), work);
+        });
+    }
+
+    template<typename D, typename R, typename Stats = stats::none>
+    requires (std::is_arithmetic_v<D> && std::is_arithmetic_v<R>)
+    void dct_decode_batch(lossy::frame_view<const R> encoded, lossy::frame_view<D> out, ThreadPool& pool) {
+        using DC = lossy::BasicDiscreteCosinus<Stats>;
+        using T = typename DC::template compute_t<R>;
+        assert(encoded.count == out.count);
+        detail::for_frame_chunks(pool, out.count, lossy::detail::batch_lanes<T>, [&](std::size_t first, std::size_t n) {
+            std::vector<T> work(DC::template batch_work_size<R>(out.length));
+            DC::template decode_batch_into<D, R>(encoded.subframes(first, n), out.subframes(first, n), work);
+        });
+    }
+
+    template<typename D, typename R>
+    requires (std::is_arithmetic_v<D> && std::is_arithmetic_v<R>)
+    void dft_encode_batch(lossy::frame_view<const D> src, lossy::frame_view<R> real, lossy::frame_view<R> imag,
+                          ThreadPool& pool) {
+        assert(real.count == src.count && imag.count == src.count);
+        detail::for_frame_chunks(pool, src.count, 1, [&](std::size_t first, std::size_t n) {
+            lossy::DiscreteFourier::encode_batch<D, R>(src.subframes(first, n), real.subframes(first, n),
+                                                       imag.subframes(first, n));
+        });
+    }
+
+    // ===== Codecs de bloc =====
+    // Un codec ajoute le codage d'un bloc à un tampon, et décode un bloc dans un span de la
+    // taille du bloc d'origine.
+    template<typename C, typename D>
+    concept block_codec = requires(const C& c, std::span<const D> in, std::vector<std::uint8_t>& out,
+                                   std::span<const std::uint8_t> blk, std::span<D> dst) {
+        c.encode(in, out);
+        { c.decode(blk, dst) } -> std::same_as<bool>;
+    };
+
+    // Huffman, rANS, LZ77, RLE (RunLength) ou stockage brut, via container
+    template<typename D>
+    struct container_codec {
+        container::codec       id = container::codec::lz77;
+        container::lz77_params lz = {};
+
+        void encode(std::span<const D> in, std::vector<std::uint8_t>& out) const {
+            container::encode_block<D>(out, in, id, lz);
+        }
+        [[nodiscard]] bool decode(std::span<const std::uint8_t> blk, std::span<D> dst) const {
+            const auto h = container::read_header(blk);
+            return h && h->nb_symbols == dst.size() && container::decode_block<D>(blk, dst).has_value();
+        }
+    };
+
+    // DCT par trames de frame_size échantillons (> 0), nb_coefs coefficients gardés, quantifiés
+    // par quantum puis écrits en varints zigzag (avec perte)
+    template<typename D>
+    requires std::is_arithmetic_v<D>
+    struct dct_codec {
+        std::size_t frame_size = 64;
+        std::size_t nb_coefs   = 16;
+        double      quantum    = 1.0;
+
+        dct_codec() = default;
+        dct_codec(std::size_t frame, std::size_t coefs, double q) : frame_size(frame), nb_coefs(coefs), quantum(q) {
+            assert(frame_size > 0);
+        }
+
+        // frame_size == 0 : rien n'est écrit, et decode refuse le bloc
+        void encode(std::span<const D> in, std::vector<std::uint8_t>& out) const {
+            assert(frame_size > 0);
+            if (frame_size == 0) return;
+            // trames complètes en un lot, la dernière (incomplète) seule
+            const std::size_t full = in.size() / frame_size;
+            const std::size_t nb = std::min(nb_coefs, frame_size);
+            std::vector<double> coefs(full * nb);
+            std::vector<double> work(lossy::DiscreteCosinus::batch_work_size<double>(frame_size));
+            lossy::DiscreteCosinus::encode_batch_into<D, double>(lossy::frame_view<const D>::rows(in.data(), full, frame_size),
+                                                                 lossy::frame_view<double>::rows(coefs.data(), full, nb), work);
+            for (int q : lossy::Quantization::encode<double>(coefs, quantum))
+                utils::put_varint(out, utils::zigzag_encode(q));
+            if (full * frame_size < in.size()) {
+                const auto frame = in.subspan(full * frame_size);
+                const auto last = lossy::DiscreteCosinus::encode<D, double>(frame, std::min(nb_coefs, frame.size()));
+                for (int q : lossy::Quantization::encode<double>(last, quantum))
+                    utils::put_varint(out, utils::zigzag_encode(q));
+            }
+        }
+        [[nodiscard]] bool decode(std::span<const std::uint8_t> blk, std::span<D> dst) const {
+            if (frame_size == 0) return false;
+            const std::uint8_t* p = blk.data();
+            const std::uint8_t* const end = p + blk.size();
+            const auto read = [&](std::vector<int>& q) {
+                for (auto& v : q) {
+                    const auto u = utils::get_varint(p, end);
+                    if (!u) return false;
+                    v = static_cast<int>(utils::zigzag_decode(*u));
+                }
+                return true;
+            };
+            const std::size_t full = dst.size() / frame_size;
+            const std::size_t nb = std::min(nb_coefs, frame_size);
+            std::vector<int> q(full * nb);
+            if (!read(q)) return false;
+            const auto coefs = lossy::Quantization::decode<double>(q, quantum);
+            std::vector<double> work(lossy::DiscreteCosinus::batch_work_size<double>(frame_size));
+            lossy::DiscreteCosinus::decode_batch_into<D, double>(lossy::frame_view<const double>::rows(coefs.data(), full, nb),
+                                                                 lossy::frame_view<D>::rows(dst.data(), full, frame_size), work);
+            if (full * frame_size < dst.size()) {
+                const std::size_t len = dst.size() - full * frame_size;
+                q.resize(std::min(nb_coefs, len));
+                if (!read(q)) return false;
+                const auto last = lossy::DiscreteCosinus::decode<D, double>(lossy::Quantization::decode<double>(q, quantum), len);
+                std::copy(last.begin(), last.end(), dst.begin() + static_cast<std::ptrdiff_t>(full * frame_size));
+            }
+            return p == end;
+        }
+    };
+
+    // ===== Archive par blocs indépendants =====
+    // 'D' 'P' | block_size | nb_symbols | nb_blocks (varints) | offsets[nb_blocks + 1] (u64 LE,
+    // relatifs au début des données) | blocs. L'index permet de décoder un bloc isolé.
+    struct archive_index {
+        std::size_t                block_size = 0;
+        std::size_t                nb_symbols = 0;
+        std::vector<std::uint64_t> offsets;
+        std::size_t                data_start = 0;
+
+        [[nodiscard]] std::size_t nb_blocks() const noexcept { return offsets.empty() ? 0 : offsets.size() - 1; }
+        [[nodiscard]] std::size_t block_length(std::size_t i) const noexcept {
+            return std::min(block_size, nb_symbols - i * block_size);
+        }
+    };
+
+    template<typename D, typename Codec>
+    requires block_codec<Codec, D>
+    [[nodiscard]]
+    std::vector<std::uint8_t> compress(std::span<const D> src, const Codec& codec,
+                                       std::size_t block_size, ThreadPool& pool) {
+        assert(block_size > 0);
+        const std::size_t nb_blocks = (src.size() + block_size - 1) / block_size;
+        std::vector<std::vector<std::uint8_t>> blocks(nb_blocks);
+        pool.parallel_for(nb_blocks, [&](std::size_t i) {
+            const std::size_t beg = i * block_size;
+            codec.encode(src.subspan(beg, std::min(block_size, src.size() - beg)), blocks[i]);
+        });
+
+        std::vector<std::uint8_t> out{'D', 'P'};
+        utils::put_varint(out, block_size);
+        utils::put_varint(out, src.size());
+        utils::put_varint(out, nb_blocks);
+        std::uint64_t offset = 0;
+        std::size_t total = 0;
+        for (auto& b : blocks) total += b.size();
+        out.reserve(out.size() + 8 * (nb_blocks + 1) + total);
+        std::uint8_t word[8];
+        for (std::size_t i = 0; i <= nb_blocks; ++i) {
+            utils::store_le64(word, offset);
+            out.insert(out.end(), word, word + 8);
+            if (i < nb_blocks) offset += blocks[i].size();
+        }
+        for (auto& b : blocks) out.insert(out.end(), b.begin(), b.end());
+        return out;
+    }
+
+    // taille de bloc acceptée par défaut à la lecture (comme stream::Decoder)
+    inline constexpr std::size_t default_max_block_size = std::size_t{1} << 26;
+
+    // nullopt si l'index est tronqué ou incohérent, ou si ses blocs dépassent max_block_size
+    // symboles
+    [[nodiscard]]
+    inline std::optional<archive_index> read_index(std::span<const std::uint8_t> in,
+                                                   std::size_t max_block_size = default_max_block_size) {
+        if (in.size() < 2 || in[0] != 'D' || in[1] != 'P') return std::nullopt;
+        const std::uint8_t* p = in.data() + 2;
+        const std::uint8_t* const end = in.data() + in.size();
+        const auto block_size = utils::get_varint(p, end);
+        const auto nb_symbols = utils::get_varint(p, end);
+        const auto nb_blocks  = utils::get_varint(p, end);
+        if (!block_size || !nb_symbols || !nb_blocks || *block_size == 0 || *block_size > max_block_size)
+            return std::nullopt;
+        if (*nb_blocks != (*nb_symbols + *block_size - 1) / *block_size) return std::nullopt;
+        if (*nb_blocks >= static_cast<std::size_t>(end - p) / 8) return std::nullopt;
+
+        archive_index idx;
+        idx.block_size = static_cast<std::size_t>(*block_size);
+        idx.nb_symbols = static_cast<std::size_t>(*nb_symbols);
+        idx.offsets.resize(static_cast<std::size_t>(*nb_blocks) + 1);
+        for (auto& o : idx.offsets) { o = utils::load_le64(p); p += 8; }
+        idx.data_start = static_cast<std::size_t>(p - in.data());
+        const std::size_t data_size = in.size() - idx.data_start;
+        for (std::size_t i = 0; i < idx.nb_blocks(); ++i)
+            if (idx.offsets[i] > idx.offsets[i + 1]) return std::nullopt;
+        if (idx.offsets.front() != 0 || idx.offsets.back() != data_size) return std::nullopt;
+        return idx;
+    }
+
+    // décode le bloc i seul (accès direct) dans out, de taille idx.block_length(i)
+    template<typename D, typename Codec>
+    requires block_codec<Codec, D>
+    [[nodiscard]]
+    bool decompress_block(std::span<const std::uint8_t> in, const archive_index& idx, std::size_t i,
+                          const Codec& codec, std::span<D> out) {
+        if (i >= idx.nb_blocks() || out.size() != idx.block_length(i)) return false;
+        const auto blk = in.subspan(idx.data_start + idx.offsets[i], idx.offsets[i + 1] - idx.offsets[i]);
+        return codec.decode(blk, out);
+    }
+
+    // max_symbols : plafond de la sortie, vérifié avant de l'allouer
+    template<typename D, typename Codec>
+    requires block_codec<Codec, D>
+    [[nodiscard]]
+    std::optional<std::vector<D>> decompress(std::span<const std::uint8_t> in, const Codec& codec, ThreadPool& pool,
+                                             std::size_t max_block_size = default_max_block_size,
+                                             std::size_t max_symbols = container::default_max_bytes / sizeof(D)) {
+        const auto idx = read_index(in, max_block_size);
+        if (!idx || idx->nb_symbols > max_symbols) return std::nullopt;
+        std::vector<D> out(idx->nb_symbols);
+        std::atomic<bool> ok{true};
+        pool.parallel_for(idx->nb_blocks(), [&](std::size_t i) {
+            const auto dst = std::span<D>(out).subspan(i * idx->block_size, idx->block_length(i));
+            if (!decompress_block<D>(in, *idx, i, codec, dst)) ok.store(false, std::memory_order_relaxed);
+        });
+        if (!ok.load()) return std::nullopt;
+        return out;
+    }
+
+} // namespace encoding::parallel
@@ -0,0 +1,502 @@
+#pragma once
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <optional>
+#include <concepts>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <bit>
+#include <memory_resource>
+#include "container.hpp"
+#include "encoding_lossless.hpp"
+#include "stats.hpp"
+#include "utils.hpp"
+
+namespace encoding::pipeline {
+
+    // ===== Pipeline analyse -> entropie, composé à la compilation =====
+    // Pipeline<Parse, Entropy> (par ex. Pipeline<lz77_stage<D>, huffman_stage<D>>, soit Deflate<D>)
+    // branche l'analyse directement sur le codeur entropique : les séquences (plage de littéraux,
+    // longueur, offset) s'accumulent dans un lot en structure de tableaux (sequence_batch), codé
+    // dès qu'il est plein. Aucun tampon n'a la taille des données : la mémoire est celle d'un
+    // lot, plus l'index de l'analyse.
+    // Format : 'D' 'Z' | sizeof(D) (u8) | id d'analyse (u8) | id d'entropie (u8) | nb_symbols
+    //          | buffer_size (varints) | crc32 (u32 LE) | lots.
+    // Lot : nb_sequences | nb_literals (varints) | 5 flux : littéraux, jetons de plage, de
+    //       longueur, d'offset, bits d'extra. Flux : mode (u8 : 0 brut, 1 codé) | taille | octets.
+    // Une longueur de correspondance ne dépasse pas sequence_batch::max_match.
+    // Chaque valeur (plage, longueur, offset ; offset 0 sans correspondance) devient un jeton
+    // d'un octet (detail::token_of) suivi de extra_bits(jeton) bits dans le flux d'extra, dans
+    // l'ordre des séquences.
+
+    namespace detail {
+
+        // v < 4 : jeton v ; sinon 4 + 4 (e - 2) + les deux bits sous le bit de tête (e = sa
+        // position), et les e - 2 bits de poids faible en extra. 124 jetons pour 32 bits.
+        inline constexpr unsigned nb_tokens = 124;
+
+        [[nodiscard]] constexpr std::uint8_t token_of(std::uint32_t v) noexcept {
+            if (v < 4) return static_cast<std::uint8_t>(v);
+            const unsigned e = static_cast<unsigned>(std::bit_width(v)) - 1;
+            return static_cast<std::uint8_t>(4 + 4 * (e - 2) + ((v >> (e - 2)) & 3));
+        }
+
+        [[nodiscard]] constexpr unsigned extra_bits(std::uint8_t t) noexcept { return t < 4 ? 0 : (t - 4u) / 4; }
+
+        [[nodiscard]] constexpr std::uint32_t token_base(std::uint8_t t) noexcept {
+            return t < 4 ? t : (4u | ((t - 4u) & 3)) << extra_bits(t);
+        }
+
+    } // namespace detail
+
+    // ===== Lot de séquences (structure de tableaux) =====
+    // Borné pour rester en cache : au plus max_sequences séquences et max_literals littéraux.
+    // Une correspondance fait au plus max_match symboles (une plus longue est découpée, même
+    // offset) : un lot décode au plus max_output symboles, ce qui borne la sortie d'un flux
+    // par sa taille avant toute allocation.
+    template<typename D>
+    struct sequence_batch {
+        static constexpr std::size_t max_sequences = 4096;
+        static constexpr std::size_t max_literals  = 16384;
+        static constexpr std::size_t max_match     = 258;
+        static constexpr std::size_t max_output    = max_literals + max_sequences * max_match;
+        // nb_sequences, nb_literals et 5 flux d'au moins 2 octets (mode, taille)
+        static constexpr std::size_t min_bytes     = 12;
+
+        std::pmr::vector<D>             literals;
+        std::pmr::vector<std::uint32_t> runs, lengths, offsets;
+
+        explicit sequence_batch(std::pmr::memory_resource* mr = std::pmr::get_default_resource())
+            : literals(mr), runs(mr), lengths(mr), offsets(mr) {}
+
+        void clear() noexcept { literals.clear(); runs.clear(); lengths.clear(); offsets.clear(); }
+
+        [[nodiscard]] std::size_t size() const noexcept { return runs.size(); }
+        [[nodiscard]] bool full() const noexcept {
+            return runs.size() == max_sequences || literals.size() == max_literals;
+        }
+    };
+
+    namespace detail {
+
+        // reçoit littéraux et correspondances de l'analyse ; chaque lot plein part à flush().
+        // Une plage coupée par la limite de littéraux finit par une séquence sans correspondance.
+        template<typename D, typename Flush>
+        struct batch_sink {
+            sequence_batch<D>& batch;
+            Flush              flush;
+            std::uint32_t      run = 0;
+
+            void push(std::uint32_t len, std::uint32_t off) {
+                batch.runs.push_back(run);
+                batch.lengths.push_back(len);
+                batch.offsets.push_back(off);
+                run = 0;
+                if (batch.full()) { flush(); batch.clear(); }
+            }
+            void literal(const D& d) {
+                batch.literals.push_back(d);
+                ++run;
+                if (batch.literals.size() == sequence_batch<D>::max_literals) push(0, 0);
+            }
+            void match(std::size_t off, std::size_t len) {
+                for (; len > sequence_batch<D>::max_match; len -= sequence_batch<D>::max_match)
+                    push(static_cast<std::uint32_t>(sequence_batch<D>::max_match), static_cast<std::uint32_t>(off));
+                push(static_cast<std::uint32_t>(len), static_cast<std::uint32_t>(off));
+            }
+            void finish() {
+                if (run != 0) push(0, 0);
+                if (batch.size() != 0) { flush(); batch.clear(); }
+            }
+        };
+
+        // symboles de plus d'un octet : quand les symboles distincts dépassent la moitié du flux,
+        // la table coûte plus qu'elle ne rapporte et le flux reste brut (sans la construire)
+        template<typename D, typename Stats, typename Vec>
+        [[nodiscard]] bool worth_coding(std::span<const D> src, Vec& freqs) {
+            if constexpr (sizeof(D) == 1) {
+                (void)src; (void)freqs;
+                return true;
+            } else {
+                lossless::detail::count_symbols<D, Stats>(src, freqs);
+                return freqs.size() * 2 <= src.size();
+            }
+        }
+
+        // sink minimal pour le concept parse_stage
+        template<typename D>
+        struct probe_sink {
+            void literal(const D&) {}
+            void match(std::size_t, std::size_t) {}
+        };
+
+    } // namespace detail
+
+    // ===== Étages =====
+    // analyse : symbol_type, id, window() (distance maximale) et parse(src, sink)
+    template<typename P>
+    concept parse_stage = requires(P& p, std::span<const typename P::symbol_type> src,
+                                   detail::probe_sink<typename P::symbol_type>& sink) {
+        { P::id } -> std::convertible_to<std::uint8_t>;
+        { p.window() } -> std::convertible_to<std::size_t>;
+        p.parse(src, sink);
+    };
+
+    // entropie : code un flux de littéraux (D) ou de jetons (octets) à la fin de out, et
+    // décode exactement out.size() symboles ; false si le flux ne se code pas ou est invalide
+    template<typename E, typename D>
+    concept entropy_stage = requires(E& e, std::span<const D> lit, std::span<const std::uint8_t> tok,
+                                     std::pmr::vector<std::uint8_t>& out, std::span<D> lit_out,
+                                     std::span<std::uint8_t> tok_out) {
+        { E::id } -> std::convertible_to<std::uint8_t>;
+        { e.encode_literals(lit, out) } -> std::same_as<bool>;
+        { e.encode_tokens(tok, out) } -> std::same_as<bool>;
+        { e.decode_literals(tok, lit_out) } -> std::same_as<bool>;
+        { e.decode_tokens(tok, tok_out) } -> std::same_as<bool>;
+    };
+
+    // LZ77 (niveaux 1-9) ; les distances tiennent sur 32 bits
+    template<typename D, typename Stats = stats::none>
+    struct lz77_stage {
+        using symbol_type = D;
+        static constexpr std::uint8_t id = 1;
+
+        container::lz77_params                       lz;
+        typename lossless::LZ77<D, Stats>::workspace ws;
+
+        explicit lz77_stage(const container::lz77_params& params = {},
+                            std::pmr::memory_resource* mr = std::pmr::get_default_resource())
+            : lz(params), ws(mr) {
+            assert(lz.buffer_size <= 0xFFFFFFFFu && lz.chunk_size <= 0xFFFFFFFFu);
+        }
+
+        [[nodiscard]] std::size_t window() const noexcept { return lz.buffer_size; }
+
+        template<typename Sink>
+        void parse(std::span<const D> src, Sink& sink) {
+            auto lv = lossless::LZ77<D, Stats>::level(lz.level);
+            if (lz.max_chain) lv.max_chain = lz.max_chain;
+            lossless::LZ77<D, Stats>::parse(src, 0, lz.buffer_size, lz.chunk_size, lv, sink, ws);
+        }
+    };
+
+    // Huffman canonique par flux et par lot (même forme que le codec huffman du container)
+    template<typename D, typename Stats = stats::none>
+    struct huffman_stage {
+        static constexpr std::uint8_t id = 1;
+
+        typename lossless::Huffman<D, Stats>::workspace            literals;
+        typename lossless::Huffman<std::uint8_t, Stats>::workspace tokens;
+
+        explicit huffman_stage(std::pmr::memory_resource* mr = std::pmr::get_default_resource())
+            : literals(mr), tokens(mr) {}
+
+        template<typename Alloc>
+        bool encode_literals(std::span<const D> src, std::vector<std::uint8_t, Alloc>& out) {
+            if (!detail::worth_coding<D, Stats>(src, literals.freqs)) return false;
+            container::detail::huffman_payload<D, Stats>(out, src, literals);
+            return true;
+        }
+        template<typename Alloc>
+        bool encode_tokens(std::span<const std::uint8_t> src, std::vector<std::uint8_t, Alloc>& out) {
+            container::detail::huffman_payload<std::uint8_t, Stats>(out, src, tokens);
+            return true;
+        }
+        bool decode_literals(std::span<const std::uint8_t> in, std::span<D> out) {
+            return container::detail::huffman_decode<D, Stats>(in, out, literals);
+        }
+        bool decode_tokens(std::span<const std::uint8_t> in, std::span<std::uint8_t> out) {
+            return container::detail::huffman_decode<std::uint8_t, Stats>(in, out, tokens);
+        }
+    };
+
+    // rANS par flux et par lot (même forme que le codec rans du container)
+    template<typename D, typename Stats = stats::none>
+    struct rans_stage {
+        static constexpr std::uint8_t id = 2;
+
+        typename lossless::Rans<D, Stats>::workspace            literals;
+        typename lossless::Rans<std::uint8_t, Stats>::workspace tokens;
+
+        explicit rans_stage(std::pmr::memory_resource* mr = std::pmr::get_default_resource())
+            : literals(mr), tokens(mr) {}
+
+        template<typename Alloc>
+        bool encode_literals(std::span<const D> src, std::vector<std::uint8_t, Alloc>& out) {
+            return detail::worth_coding<D, Stats>(src, literals.freqs)
+                && container::detail::rans_payload<D, Stats>(out, src, literals);
+        }
+        template<typename Alloc>
+        bool encode_tokens(std::span<const std::uint8_t> src, std::vector<std::uint8_t, Alloc>& out) {
+            return container::detail::rans_payload<std::uint8_t, Stats>(out, src, tokens);
+        }
+        bool decode_literals(std::span<const std::uint8_t> in, std::span<D> out) {
+            return container::detail::rans_decode<D, Stats>(in, out, literals);
+        }
+        bool decode_tokens(std::span<const std::uint8_t> in, std::span<std::uint8_t> out) {
+            return container::detail::rans_decode<std::uint8_t, Stats>(in, out, tokens);
+        }
+    };
+
+    struct header {
+        std::uint8_t  parse_id    = 0;
+        std::uint8_t  entropy_id  = 0;
+        std::size_t   nb_symbols  = 0;
+        std::size_t   window      = 0;
+        std::uint32_t checksum    = 0;
+        std::size_t   header_size = 0;
+    };
+
+    // ===== Pipeline =====
+    // Un Pipeline garde ses états (index LZ77, tables, lot) d'un appel à l'autre ; il sert à un
+    // seul thread à la fois.
+    template<typename Parse, typename Entropy>
+    requires parse_stage<Parse> && entropy_stage<Entropy, typename Parse::symbol_type>
+    class Pipeline {
+    public:
+        using symbol_type  = typename Parse::symbol_type;
+        using parse_type   = Parse;
+        using entropy_type = Entropy;
+
+    private:
+        using D = symbol_type;
+
+        Parse                          m_parse;
+        Entropy                        m_entropy;
+        sequence_batch<D>              m_batch;
+        std::pmr::vector<std::uint8_t> m_tokens; // jetons de plage | longueur | offset d'un lot
+        std::pmr::vector<std::uint8_t> m_stream; // flux en cours de codage
+        std::pmr::vector<std::uint8_t> m_extra;  // bits d'extra d'un lot
+
+        // mode | taille | octets ; brut si le codage échoue ou ne gagne rien
+        template<typename S, typename Alloc, typename Code>
+        void put_stream(std::vector<std::uint8_t, Alloc>& out, std::span<const S> src, Code&& code) {
+            m_stream.clear();
+            const bool coded = !src.empty() && code(src, m_stream) && m_stream.size() < src.size_bytes();
+            if (!coded) {
+                m_stream.clear();
+                container::detail::put_symbols<S>(m_stream, src);
+            }
+            out.push_back(coded ? 1 : 0);
+            utils::put_varint(out, m_stream.size());
+            out.insert(out.end(), m_stream.begin(), m_stream.end());
+        }
+
+        template<typename S, typename Decode>
+        [[nodiscard]] static bool get_stream(const std::uint8_t*& p, const std::uint8_t* end, std::span<S> dst,
+                                             Decode&& decode) {
+            if (p == end) return false;
+            const std::uint8_t mode = *p++;
+            const auto size = utils::get_varint(p, end);
+            if (!size || *size > static_cast<std::size_t>(end - p)) return false;
+            const std::span<const std::uint8_t> bytes(p, static_cast<std::size_t>(*size));
+            p += *size;
+            if (mode == 0) {
+                if (bytes.size() != dst.size_bytes()) return false;
+                if (!dst.empty()) container::detail::get_symbols<S>(bytes.data(), dst);
+                return true;
+            }
+            return mode == 1 && decode(bytes, dst);
+        }
+
+        template<typename Alloc>
+        void encode_batch(std::vector<std::uint8_t, Alloc>& out) {
+            const auto& b = m_batch;
+            const std::size_t n = b.size();
+            utils::put_varint(out, n);
+            utils::put_varint(out, b.literals.size());
+            put_stream<D>(out, std::span<const D>(b.literals),
+                          [&](std::span<const D> s, auto& o){ return m_entropy.encode_literals(s, o); });
+
+            m_tokens.resize(3 * n);
+            m_extra.resize(3 * n * sizeof(std::uint32_t) + 8);
+            utils::BitWriter w(m_extra);
+            std::uint8_t* const tok = m_tokens.data();
+            for (std::size_t i = 0; i < n; ++i) {
+                const std::uint32_t v[3] = {b.runs[i], b.lengths[i], b.offsets[i]};
+                for (std::size_t k = 0; k < 3; ++k) {
+                    const std::uint8_t t = detail::token_of(v[k]);
+                    tok[k * n + i] = t;
+                    w.put(v[k] - detail::token_base(t), detail::extra_bits(t));
+                }
+            }
+            m_extra.resize(w.finish());
+            const std::span<const std::uint8_t> tokens(m_tokens);
+            for (std::size_t k = 0; k < 3; ++k)
+                put_stream<std::uint8_t>(out, tokens.subspan(k * n, n),
+                                         [&](std::span<const std::uint8_t> s, auto& o){ return m_entropy.encode_tokens(s, o); });
+            out.push_back(0);
+            utils::put_varint(out, m_extra.size());
+            out.insert(out.end(), m_extra.begin(), m_extra.end());
+        }
+
+        // lot suivant dans out[pos, ...)
+        [[nodiscard]] bool decode_batch(const std::uint8_t*& p, const std::uint8_t* end, std::span<D> out,
+                                        std::size_t& pos, std::size_t window) {
+            const auto n = utils::get_varint(p, end);
+            const auto nl = utils::get_varint(p, end);
+            if (!n || !nl || *n == 0 || *n > sequence_batch<D>::max_sequences || *nl > sequence_batch<D>::max_literals
+                || *nl > out.size() - pos)
+                return false;
+            auto& lits = m_batch.literals;
+            lits.resize(static_cast<std::size_t>(*nl));
+            if (!get_stream<D>(p, end, std::span<D>(lits),
+                               [&](std::span<const std::uint8_t> in, std::span<D> o){ return m_entropy.decode_literals(in, o); }))
+                return false;
+            const std::size_t nb = static_cast<std::size_t>(*n);
+            m_tokens.resize(3 * nb);
+            for (std::size_t k = 0; k < 3; ++k)
+                if (!get_stream<std::uint8_t>(p, end, std::span<std::uint8_t>(m_tokens).subspan(k * nb, nb),
+                                              [&](std::span<const std::uint8_t> in, std::span<std::uint8_t> o){
+                                                  return m_entropy.decode_tokens(in, o);
+                                              }))
+                    return false;
+            if (p == end || *p++ != 0) return false;
+            const auto extra_size = utils::get_varint(p, end);
+            if (!extra_size || *extra_size > static_cast<std::size_t>(end - p)) return false;
+            utils::BitReader r({p, static_cast<std::size_t>(*extra_size)});
+            p += *extra_size;
+
+            const std::uint8_t* const tok = m_tokens.data();
+            const D* lit = lits.data();
+            const D* const lit_end = lit + lits.size();
+            const std::size_t size = out.size();
+            for (std::size_t i = 0; i < nb; ++i) {
+                std::uint32_t v[3];
+                for (std::size_t k = 0; k < 3; ++k) {
+                    const std::uint8_t t = tok[k * nb + i];
+                    if (t >= detail::nb_tokens) return false;
+                    v[k] = detail::token_base(t) + static_cast<std::uint32_t>(r.read(detail::extra_bits(t)));
+                }
+                const auto [run, len, off] = v;
+                if (run > static_cast<std::size_t>(lit_end - lit) || run > size - pos) return false;
+                std::copy_n(lit, run, out.begin() + static_cast<std::ptrdiff_t>(pos));
+                lit += run;
+                pos += run;
+                if (len == 0) continue;
+                if (off == 0 || off > pos || off > window || len > sequence_batch<D>::max_match || len > size - pos)
+                    return false;
+                utils::copy_match(out.data() + pos, off, len);
+                pos += len;
+            }
+            return lit == lit_end && !r.overrun();
+        }
+
+    public:
+        explicit Pipeline(Parse parse = Parse{}, Entropy entropy = Entropy{},
+                          std::pmr::memory_resource* mr = std::pmr::get_default_resource())
+            : m_parse(std::move(parse)), m_entropy(std::move(entropy)), m_batch(mr),
+              m_tokens(mr), m_stream(mr), m_extra(mr) {}
+
+        [[nodiscard]] Parse& parse_stage() noexcept { return m_parse; }
+        [[nodiscard]] Entropy& entropy_stage() noexcept { return m_entropy; }
+
+        // ajoute à out le codage de src
+        template<typename Alloc>
+        void encode(std::span<const D> src, std::vector<std::uint8_t, Alloc>& out) {
+            out.insert(out.end(), {'D', 'Z', static_cast<std::uint8_t>(sizeof(D)), Parse::id, Entropy::id});
+            utils::put_varint(out, src.size());
+            utils::put_varint(out, m_parse.window());
+            std::uint8_t crc[4];
+            container::detail::put_u32(crc, container::detail::checksum<D>(src));
+            out.insert(out.end(), crc, crc + 4);
+
+            m_batch.clear();
+            const auto flush = [&]{ encode_batch(out); };
+            detail::batch_sink<D, decltype(flush)> sink{m_batch, flush};
+            m_parse.parse(src, sink);
+            sink.finish();
+        }
+
+        // nullopt si l'en-tête est tronqué ou vient d'un autre pipeline
+        [[nodiscard]] static std::optional<header> read_header(std::span<const std::uint8_t> in) noexcept {
+            if (in.size() < 5 || in[0] != 'D' || in[1] != 'Z' || in[2] != sizeof(D) || in[3] != Parse::id
+                || in[4] != Entropy::id)
+                return std::nullopt;
+            header h;
+            h.parse_id = in[3];
+            h.entropy_id = in[4];
+            const std::uint8_t* p = in.data() + 5;
+            const std::uint8_t* const end = in.data() + in.size();
+            const auto nb = utils::get_varint(p, end);
+            const auto window = utils::get_varint(p, end);
+            if (!nb || !window || end - p < 4) return std::nullopt;
+            h.nb_symbols = static_cast<std::size_t>(*nb);
+            h.window = static_cast<std::size_t>(*window);
+            h.checksum = container::detail::get_u32(p);
+            h.header_size = static_cast<std::size_t>(p + 4 - in.data());
+            return h;
+        }
+
+        // symboles au plus que décodent les lots de bytes octets (qui suivent l'en-tête)
+        [[nodiscard]] static constexpr std::uint64_t max_symbols(std::size_t bytes) noexcept {
+            return std::uint64_t{bytes / sequence_batch<D>::min_bytes} * sequence_batch<D>::max_output;
+        }
+
+        // décode in dans out (au moins nb_symbols places) ; renvoie le nombre d'octets lus,
+        // nullopt si le flux est invalide ou corrompu
+        [[nodiscard]] std::optional<std::size_t> decode(std::span<const std::uint8_t> in, std::span<D> out) {
+            const auto h = read_header(in);
+            if (!h || h->nb_symbols > out.size()) return std::nullopt;
+            const auto dst = out.first(h->nb_symbols);
+            const std::uint8_t* p = in.data() + h->header_size;
+            const std::uint8_t* const end = in.data() + in.size();
+            std::size_t pos = 0;
+            while (pos < dst.size())
+                if (!decode_batch(p, end, dst, pos, h->window)) return std::nullopt;
+            if (container::detail::checksum<D>(dst) != h->checksum) return std::nullopt;
+            return static_cast<std::size_t>(p - in.data());
+        }
+    };
+
+    // LZ77 + Huffman, façon deflate
+    template<typename D, typename Stats = stats::none>
+    using Deflate = Pipeline<lz77_stage<D, Stats>, huffman_stage<D, Stats>>;
+
+    template<typename D, typename Stats = stats::none>
+    using DeflateRans = Pipeline<lz77_stage<D, Stats>, rans_stage<D, Stats>>;
+
+    // codec de parallel::compress / stream::Encoder : un pipeline neuf par bloc
+    template<typename P>
+    struct pipeline_codec {
+        using D = typename P::symbol_type;
+        container::lz77_params lz = {};
+
+        void encode(std::span<const D> in, std::vector<std::uint8_t>& out) const {
+            P p{typename P::parse_type(lz)};
+            p.encode(in, out);
+        }
+        [[nodiscard]] bool decode(std::span<const std::uint8_t> blk, std::span<D> dst) const {
+            P p;
+            const auto h = P::read_header(blk);
+            return h && h->nb_symbols == dst.size() && p.decode(blk, dst) == blk.size();
+        }
+    };
+
+    template<typename D>
+    [[nodiscard]] std::vector<std::uint8_t> deflate(std::span<const D> src, const container::lz77_params& lz = {}) {
+        std::vector<std::uint8_t> out;
+        Deflate<D> p{lz77_stage<D>(lz)};
+        p.encode(src, out);
+        return out;
+    }
+
+    // max_symbols : plafond de l'appelant ; un en-tête qui annonce plus que lui, ou plus que
+    // les lots qui suivent ne peuvent produire, donne nullopt sans allouer
+    template<typename D>
+    [[nodiscard]] std::optional<std::vector<D>> inflate(std::span<const std::uint8_t> in,
+                                                        std::size_t max_symbols = container::default_max_bytes / sizeof(D)) {
+        const auto h = Deflate<D>::read_header(in);
+        if (!h || h->nb_symbols > max_symbols || h->nb_symbols > Deflate<D>::max_symbols(in.size() - h->header_size))
+            return std::nullopt;
+        std::vector<D> out(h->nb_symbols);
+        Deflate<D> p;
+        if (!p.decode(in, out)) return std::nullopt;
+        return out;
+    }
+
+} // namespace encoding::pipeline
@@ -0,0 +1,258 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <chrono>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <bit>
+
+namespace encoding::stats {
+
+    // ===== Instrumentation des codecs =====
+    // Les codecs (LZ77, Huffman, Rans, BasicDiscreteCosinus, container::encode_block / decode_block)
+    // prennent une politique Stats en paramètre de template. Avec stats::none (défaut), toutes
+    // les sondes sont dans des `if constexpr (Stats::enabled)` ou des minuteurs vides :
+    // le code généré est celui d'avant. Avec stats::collect, les compteurs s'accumulent dans
+    // un bloc propre au thread appelant (collect::local), exportable en struct ou en JSON.
+
+    enum class stage : std::uint8_t {
+        count, huffman_build, huffman_encode, huffman_decode, rans_build, rans_encode, rans_decode,
+        lz77_parse, lz77_decode, dct_forward, dct_inverse, block_encode, block_decode,
+    };
+    inline constexpr std::size_t nb_stages = 13;
+    inline constexpr std::array<const char*, nb_stages> stage_names = {
+        "count", "huffman_build", "huffman_encode", "huffman_decode", "rans_build", "rans_encode", "rans_decode",
+        "lz77_parse", "lz77_decode", "dct_forward", "dct_inverse", "block_encode", "block_decode",
+    };
+
+    // histogramme par puissances de deux : buckets[k] compte les valeurs de [2^(k-1), 2^k)
+    struct log2_histogram {
+        std::array<std::uint64_t, 65> buckets{};
+
+        void add(std::uint64_t v) noexcept { ++buckets[std::bit_width(v)]; }
+        void merge(const log2_histogram& o) noexcept {
+            for (std::size_t k = 0; k < buckets.size(); ++k) buckets[k] += o.buckets[k];
+        }
+    };
+
+    struct stage_time {
+        std::uint64_t calls = 0;
+        std::uint64_t ns    = 0;
+    };
+
+    struct lz77_counters {
+        std::uint64_t  symbols  = 0; // symboles analysés
+        std::uint64_t  literals = 0;
+        std::uint64_t  matches  = 0;
+        std::uint64_t  matched  = 0; // symboles couverts par les correspondances
+        std::uint64_t  searches = 0; // parcours de chaîne de hachage
+        std::uint64_t  probes   = 0; // candidats comparés sur ces chaînes
+        log2_histogram lengths;
+        log2_histogram offsets;
+
+        [[nodiscard]] double literal_ratio() const noexcept {
+            return symbols ? static_cast<double>(literals) / static_cast<double>(symbols) : 0.0;
+        }
+        [[nodiscard]] double avg_chain_depth() const noexcept {
+            return searches ? static_cast<double>(probes) / static_cast<double>(searches) : 0.0;
+        }
+    };
+
+    struct huffman_counters {
+        std::uint64_t                 symbols      = 0;
+        std::uint64_t                 bits         = 0;   // bits de code émis
+        double                        entropy_bits = 0.0; // sum f log2(n / f), borne d'ordre 0
+        std::array<std::uint64_t, 33> code_lengths{};     // nb de codes par longueur
+        std::array<std::uint64_t, 33> coded_symbols{};    // nb de symboles codés par longueur
+
+        [[nodiscard]] double entropy() const noexcept {
+            return symbols ? entropy_bits / static_cast<double>(symbols) : 0.0;
+        }
+        [[nodiscard]] double bits_per_symbol() const noexcept {
+            return symbols ? static_cast<double>(bits) / static_cast<double>(symbols) : 0.0;
+        }
+    };
+
+    struct rans_counters {
+        std::uint64_t symbols      = 0;
+        std::uint64_t bits         = 0;   // flux rANS (états compris)
+        double        entropy_bits = 0.0; // sum f log2(n / f)
+
+        [[nodiscard]] double entropy() const noexcept {
+            return symbols ? entropy_bits / static_cast<double>(symbols) : 0.0;
+        }
+        [[nodiscard]] double bits_per_symbol() const noexcept {
+            return symbols ? static_cast<double>(bits) / static_cast<double>(symbols) : 0.0;
+        }
+    };
+
+    struct dct_counters {
+        std::uint64_t blocks      = 0;
+        std::uint64_t coefs       = 0; // taille des transformées
+        std::uint64_t kept        = 0; // coefficients gardés (nb_coefs)
+        double        energy      = 0.0;
+        double        energy_kept = 0.0;
+
+        [[nodiscard]] double energy_ratio() const noexcept { return energy > 0.0 ? energy_kept / energy : 1.0; }
+    };
+
+    // bytes_in / bytes_out : données et blocs produits par les codages (container::encode_block)
+    struct counters {
+        std::uint64_t                      bytes_in  = 0;
+        std::uint64_t                      bytes_out = 0;
+        std::array<stage_time, nb_stages>  time{};
+        lz77_counters                      lz77;
+        huffman_counters                   huffman;
+        rans_counters                      rans;
+        dct_counters                       dct;
+
+        [[nodiscard]] const stage_time& operator[](stage s) const noexcept { return time[static_cast<std::size_t>(s)]; }
+        [[nodiscard]] stage_time& operator[](stage s) noexcept { return time[static_cast<std::size_t>(s)]; }
+
+        // cumule o (par ex. les compteurs de plusieurs threads)
+        void merge(const counters& o) noexcept {
+            bytes_in += o.bytes_in; bytes_out += o.bytes_out;
+            for (std::size_t s = 0; s < nb_stages; ++s) { time[s].calls += o.time[s].calls; time[s].ns += o.time[s].ns; }
+            lz77.symbols += o.lz77.symbols; lz77.literals += o.lz77.literals; lz77.matches += o.lz77.matches;
+            lz77.matched += o.lz77.matched;
+            lz77.searches += o.lz77.searches; lz77.probes += o.lz77.probes;
+            lz77.lengths.merge(o.lz77.lengths); lz77.offsets.merge(o.lz77.offsets);
+            huffman.symbols += o.huffman.symbols; huffman.bits += o.huffman.bits;
+            huffman.entropy_bits += o.huffman.entropy_bits;
+            for (std::size_t l = 0; l < huffman.code_lengths.size(); ++l) {
+                huffman.code_lengths[l] += o.huffman.code_lengths[l];
+                huffman.coded_symbols[l] += o.huffman.coded_symbols[l];
+            }
+            rans.symbols += o.rans.symbols; rans.bits += o.rans.bits; rans.entropy_bits += o.rans.entropy_bits;
+            dct.blocks += o.dct.blocks; dct.coefs += o.dct.coefs; dct.kept += o.dct.kept;
+            dct.energy += o.dct.energy; dct.energy_kept += o.dct.energy_kept;
+        }
+    };
+
+    // ===== Politiques =====
+    // none : aucune sonde
+    struct none {
+        static constexpr bool enabled = false;
+
+        struct timer {
+            explicit constexpr timer(stage) noexcept {}
+        };
+    };
+
+    // collect : compteurs du thread courant ; le temps d'une étape est mesuré par un minuteur
+    // de portée (les étapes imbriquées se recouvrent : block_encode inclut lz77_parse)
+    struct collect {
+        static constexpr bool enabled = true;
+
+        [[nodiscard]] static counters& local() noexcept {
+            thread_local counters c;
+            return c;
+        }
+
+        // renvoie les compteurs du thread et les remet à zéro
+        [[nodiscard]] static counters take() noexcept {
+            counters c = local();
+            local() = counters{};
+            return c;
+        }
+
+        class timer {
+        private:
+            using clock = std::chrono::steady_clock;
+            stage             m_stage;
+            clock::time_point m_start;
+
+        public:
+            explicit timer(stage s) noexcept : m_stage(s), m_start(clock::now()) {}
+            timer(const timer&) = delete;
+            timer& operator=(const timer&) = delete;
+            ~timer() {
+                auto& t = local()[m_stage];
+                ++t.calls;
+                t.ns += static_cast<std::uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - m_start).count());
+            }
+        };
+    };
+
+    namespace detail {
+
+        inline void put(std::string& s, std::uint64_t v) {
+            char buf[24];
+            s.append(buf, std::to_chars(buf, buf + sizeof(buf), v).ptr);
+        }
+
+        inline void put(std::string& s, double v) {
+            char buf[32];
+            s.append(buf, std::to_chars(buf, buf + sizeof(buf), v, std::chars_format::general, 9).ptr);
+        }
+
+        // tableau JSON sans les zéros de fin
+        template<std::size_t N>
+        void put(std::string& s, const std::array<std::uint64_t, N>& a) {
+            std::size_t n = N;
+            while (n > 0 && a[n - 1] == 0) --n;
+            s += '[';
+            for (std::size_t i = 0; i < n; ++i) { if (i) s += ", "; put(s, a[i]); }
+            s += ']';
+        }
+
+        template<typename V>
+        void field(std::string& s, const char* name, const V& v, bool last = false) {
+            s += '"'; s += name; s += "\": ";
+            put(s, v);
+            if (!last) s += ", ";
+        }
+
+    } // namespace detail
+
+    // objet JSON sur une ligne ; les histogrammes sont indexés comme log2_histogram
+    [[nodiscard]] inline std::string to_json(const counters& c) {
+        using detail::field;
+        std::string s = "{";
+        field(s, "bytes_in", c.bytes_in);
+        field(s, "bytes_out", c.bytes_out);
+        s += "\"time\": {";
+        bool first = true;
+        for (std::size_t k = 0; k < nb_stages; ++k) {
+            if (c.time[k].calls == 0) continue;
+            if (!first) s += ", ";
+            first = false;
+            s += '"'; s += stage_names[k]; s += "\": {";
+            field(s, "calls", c.time[k].calls);
+            field(s, "ns", c.time[k].ns, true);
+            s += '}';
+        }
+        s += "}, \"lz77\": {";
+        field(s, "symbols", c.lz77.symbols);
+        field(s, "literals", c.lz77.literals);
+        field(s, "matches", c.lz77.matches);
+        field(s, "matched", c.lz77.matched);
+        field(s, "literal_ratio", c.lz77.literal_ratio());
+        field(s, "avg_chain_depth", c.lz77.avg_chain_depth());
+        field(s, "length_log2", c.lz77.lengths.buckets);
+        field(s, "offset_log2", c.lz77.offsets.buckets, true);
+        s += "}, \"huffman\": {";
+        field(s, "symbols", c.huffman.symbols);
+        field(s, "bits", c.huffman.bits);
+        field(s, "entropy", c.huffman.entropy());
+        field(s, "bits_per_symbol", c.huffman.bits_per_symbol());
+        field(s, "code_lengths", c.huffman.code_lengths);
+        field(s, "coded_symbols", c.huffman.coded_symbols, true);
+        s += "}, \"rans\": {";
+        field(s, "symbols", c.rans.symbols);
+        field(s, "bits", c.rans.bits);
+        field(s, "entropy", c.rans.entropy());
+        field(s, "bits_per_symbol", c.rans.bits_per_symbol(), true);
+        s += "}, \"dct\": {";
+        field(s, "blocks", c.dct.blocks);
+        field(s, "coefs", c.dct.coefs);
+        field(s, "kept", c.dct.kept);
+        field(s, "energy_ratio", c.dct.energy_ratio(), true);
+        s += "}}";
+        return s;
+    }
+
+} // namespace encoding::stats
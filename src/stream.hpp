@@ -0,0 +1,323 @@
+#pragma once
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <functional>
+#include <optional>
+#include <concepts>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include "container.hpp"
+#include "parallel.hpp"
+#include "utils.hpp"
+
+namespace encoding::stream {
+
+    // ===== Flux par trames, mémoire bornée =====
+    // 'D' 'S' | sizeof(D) (u8) | block_size (varint) | trames. Une trame = nb_symbols | taille
+    // (varints) | bloc du codec ; nb_symbols = 0 marque la fin du flux. L'encodeur code un bloc
+    // dès qu'il est plein et le décodeur ne garde qu'une trame : la mémoire reste bornée par
+    // block_size plus l'historique du codec (fenêtre LZ77), quelle que soit la taille du flux.
+
+    // reçoit les octets codés au fil de l'eau
+    using sink_t   = std::function<void(std::span<const std::uint8_t>)>;
+    // remplit le tampon donné et renvoie le nombre d'octets lus, 0 en fin de données
+    using source_t = std::function<std::size_t(std::span<std::uint8_t>)>;
+
+    // codec dont un bloc peut référencer les history_size() derniers symboles des blocs
+    // précédents : data[0, start) est l'historique, data[start, ...) le bloc
+    template<typename C, typename D>
+    concept windowed_codec = requires(const C& c, std::span<const D> data, std::size_t start,
+                                      std::vector<std::uint8_t>& out, std::span<const std::uint8_t> blk,
+                                      std::span<D> dst) {
+        { c.history_size() } -> std::convertible_to<std::size_t>;
+        c.encode(data, start, out);
+        { c.decode(blk, dst, start) } -> std::same_as<bool>;
+    };
+
+    // blocs indépendants (parallel::container_codec, parallel::dct_codec) ou fenêtrés
+    template<typename C, typename D>
+    concept stream_codec = parallel::block_codec<C, D> || windowed_codec<C, D>;
+
+    // LZ77 dont la fenêtre enjambe les blocs du flux
+    template<typename D>
+    struct lz77_codec {
+        container::lz77_params lz = {};
+
+        [[nodiscard]] std::size_t history_size() const noexcept { return lz.buffer_size; }
+
+        void encode(std::span<const D> data, std::size_t start, std::vector<std::uint8_t>& out) const {
+            container::encode_block<D>(out, data, start, container::codec::lz77, lz);
+        }
+        [[nodiscard]] bool decode(std::span<const std::uint8_t> blk, std::span<D> data, std::size_t start) const {
+            const auto h = container::read_header(blk);
+            return h && (h->id == container::codec::lz77 || h->id == container::codec::stored) && start <= data.size()
+                && h->nb_symbols == data.size() - start
+                && container::decode_block<D>(blk, data, start).has_value();
+        }
+    };
+
+    namespace detail {
+
+        template<typename D, typename C>
+        [[nodiscard]] std::size_t history_size(const C& c) {
+            if constexpr (windowed_codec<C, D>) return c.history_size();
+            else return 0;
+        }
+
+        // ne garde que les keep derniers symboles de v
+        template<typename D>
+        void keep_tail(std::vector<D>& v, std::size_t keep) {
+            if (v.size() <= keep) return;
+            v.erase(v.begin(), v.end() - static_cast<std::ptrdiff_t>(keep));
+        }
+
+    } // namespace detail
+
+    // ===== Encoder : write / flush / finish =====
+    // Les symboles s'accumulent jusqu'à block_size, puis le bloc est codé et passé au sink.
+    // Avec un codec à blocs indépendants, write code les blocs entiers reçus sans les copier.
+    template<typename D, typename Codec>
+    requires stream_codec<Codec, D>
+    class Encoder {
+    private:
+        Codec                     m_codec;
+        sink_t                    m_sink;
+        std::size_t               m_block_size;
+        std::size_t               m_history;
+        std::vector<D>            m_data;      // historique | bloc en cours
+        std::size_t               m_start = 0; // début du bloc en cours dans m_data
+        std::vector<std::uint8_t> m_head;
+        std::vector<std::uint8_t> m_payload;
+        bool                      m_started  = false;
+        bool                      m_finished = false;
+
+        void put_header() {
+            if (m_started) return;
+            m_head.insert(m_head.end(), {'D', 'S', static_cast<std::uint8_t>(sizeof(D))});
+            utils::put_varint(m_head, m_block_size);
+            m_started = true;
+        }
+
+        // une trame pour data[start, ...) ; data[0, start) est l'historique des codecs fenêtrés
+        void put_frame(std::span<const D> data, std::size_t start) {
+            m_payload.clear();
+            if constexpr (windowed_codec<Codec, D>) m_codec.encode(data, start, m_payload);
+            else m_codec.encode(data.subspan(start), m_payload);
+
+            put_header();
+            utils::put_varint(m_head, data.size() - start);
+            utils::put_varint(m_head, m_payload.size());
+            m_sink(m_head);
+            m_sink(m_payload);
+            m_head.clear();
+        }
+
+        void encode_block() {
+            if (m_data.size() == m_start) return;
+            put_frame(m_data, m_start);
+            detail::keep_tail(m_data, m_history);
+            m_start = m_data.size();
+        }
+
+    public:
+        Encoder(Codec codec, sink_t sink, std::size_t block_size = std::size_t{1} << 20)
+            : m_codec(std::move(codec)), m_sink(std::move(sink)), m_block_size(block_size),
+              m_history(detail::history_size<D>(m_codec)) {
+            assert(m_block_size > 0);
+            m_data.reserve(m_history + m_block_size);
+        }
+
+        [[nodiscard]] std::size_t block_size() const noexcept { return m_block_size; }
+
+        void write(std::span<const D> in) {
+            assert(!m_finished);
+            while (!in.empty()) {
+                // blocs indépendants : un bloc entier de in est codé sur place, sans copie
+                // (in peut être une projection mmap du fichier)
+                if constexpr (!windowed_codec<Codec, D>) {
+                    if (m_data.size() == m_start && in.size() >= m_block_size) {
+                        put_frame(in.first(m_block_size), 0);
+                        in = in.subspan(m_block_size);
+                        continue;
+                    }
+                }
+                const std::size_t room = m_block_size - (m_data.size() - m_start);
+                const std::size_t k = std::min(room, in.size());
+                m_data.insert(m_data.end(), in.begin(), in.begin() + static_cast<std::ptrdiff_t>(k));
+                in = in.subspan(k);
+                if (k == room) encode_block();
+            }
+        }
+
+        // code tout de suite le bloc partiel en cours (trame plus courte que block_size)
+        void flush() {
+            assert(!m_finished);
+            encode_block();
+        }
+
+        // dernier bloc puis marque de fin ; l'encodeur ne peut plus servir
+        void finish() {
+            if (m_finished) return;
+            encode_block();
+            put_header();
+            utils::put_varint(m_head, 0);
+            m_sink(m_head);
+            m_head.clear();
+            m_finished = true;
+        }
+    };
+
+    // ===== Decoder : read remplit un span de l'appelant =====
+    // Les octets sont tirés de la source à la demande, une trame à la fois.
+    template<typename D, typename Codec>
+    requires stream_codec<Codec, D>
+    class Decoder {
+    private:
+        enum class state : std::uint8_t { header, frames, done, failed };
+
+        static constexpr std::size_t input_size = std::size_t{1} << 16;
+
+        Codec                     m_codec;
+        source_t                  m_source;
+        std::size_t               m_max_block;
+        std::size_t               m_history;
+        std::size_t               m_block_size = 0;
+        std::vector<std::uint8_t> m_in;
+        std::size_t               m_in_pos = 0;
+        std::size_t               m_in_end = 0;
+        std::vector<std::uint8_t> m_payload;
+        std::vector<D>            m_data;    // historique | bloc décodé
+        std::size_t               m_pos = 0; // prochain symbole à rendre dans m_data
+        state                     m_state = state::header;
+
+        [[nodiscard]] bool refill() {
+            m_in_pos = 0;
+            m_in_end = m_source(m_in);
+            assert(m_in_end <= m_in.size());
+            return m_in_end != 0;
+        }
+
+        [[nodiscard]] std::optional<std::uint8_t> get_byte() {
+            if (m_in_pos == m_in_end && !refill()) return std::nullopt;
+            return m_in[m_in_pos++];
+        }
+
+        [[nodiscard]] std::optional<std::uint64_t> get_varint() {
+            std::uint64_t v = 0;
+            for (unsigned shift = 0; shift < 64; shift += 7) {
+                const auto b = get_byte();
+                if (!b) return std::nullopt;
+                v |= static_cast<std::uint64_t>(*b & 0x7F) << shift;
+                if (!(*b & 0x80)) return v;
+            }
+            return std::nullopt;
+        }
+
+        // le tampon ne grandit qu'avec les octets effectivement reçus
+        [[nodiscard]] bool read_payload(std::uint64_t size) {
+            m_payload.clear();
+            while (m_payload.size() < size) {
+                if (m_in_pos == m_in_end && !refill()) return false;
+                const std::size_t k = static_cast<std::size_t>(
+                    std::min<std::uint64_t>(size - m_payload.size(), m_in_end - m_in_pos));
+                m_payload.insert(m_payload.end(), m_in.begin() + static_cast<std::ptrdiff_t>(m_in_pos),
+                                 m_in.begin() + static_cast<std::ptrdiff_t>(m_in_pos + k));
+                m_in_pos += k;
+            }
+            return true;
+        }
+
+        [[nodiscard]] bool read_header() {
+            const auto d = get_byte(), s = get_byte(), size = get_byte();
+            if (!d || !s || !size || *d != 'D' || *s != 'S' || *size != sizeof(D)) return false;
+            const auto block_size = get_varint();
+            if (!block_size || *block_size == 0 || *block_size > m_max_block) return false;
+            m_block_size = static_cast<std::size_t>(*block_size);
+            m_state = state::frames;
+            return true;
+        }
+
+        [[nodiscard]] bool next_frame() {
+            const auto nb = get_varint();
+            if (!nb || *nb > m_block_size) return false;
+            if (*nb == 0) { m_state = state::done; return true; }
+            const auto size = get_varint();
+            if (!size || !read_payload(*size)) return false;
+
+            detail::keep_tail(m_data, m_history);
+            const std::size_t start = m_data.size();
+            m_data.resize(start + static_cast<std::size_t>(*nb));
+            m_pos = start;
+            if constexpr (windowed_codec<Codec, D>) return m_codec.decode(m_payload, std::span<D>(m_data), start);
+            else return m_codec.decode(m_payload, std::span<D>(m_data).subspan(start));
+        }
+
+    public:
+        // max_block_size borne la taille de bloc acceptée (mémoire allouée par le décodeur)
+        Decoder(Codec codec, source_t source, std::size_t max_block_size = std::size_t{1} << 26)
+            : m_codec(std::move(codec)), m_source(std::move(source)), m_max_block(max_block_size),
+              m_history(detail::history_size<D>(m_codec)), m_in(input_size) {}
+
+        [[nodiscard]] bool finished() const noexcept { return m_state == state::done && m_pos == m_data.size(); }
+
+        // remplit out et renvoie le nombre de symboles écrits, moins que out.size() seulement
+        // en fin de flux ; nullopt si le flux est tronqué ou corrompu
+        [[nodiscard]] std::optional<std::size_t> read(std::span<D> out) {
+            std::size_t written = 0;
+            while (written < out.size()) {
+                if (m_state == state::failed) return std::nullopt;
+                if (m_pos < m_data.size()) {
+                    const std::size_t k = std::min(out.size() - written, m_data.size() - m_pos);
+                    std::copy_n(m_data.begin() + static_cast<std::ptrdiff_t>(m_pos), k,
+                                out.begin() + static_cast<std::ptrdiff_t>(written));
+                    m_pos += k;
+                    written += k;
+                    continue;
+                }
+                if (m_state == state::done) break;
+                const bool ok = m_state == state::header ? read_header() : next_frame();
+                if (!ok) m_state = state::failed;
+            }
+            return written;
+        }
+    };
+
+    // ===== Raccourcis sur des tampons entiers =====
+    template<typename D, typename Codec>
+    requires stream_codec<Codec, D>
+    [[nodiscard]]
+    std::vector<std::uint8_t> compress(std::span<const D> src, const Codec& codec,
+                                       std::size_t block_size = std::size_t{1} << 20) {
+        std::vector<std::uint8_t> out;
+        Encoder<D, Codec> enc(codec, [&](std::span<const std::uint8_t> b){ out.insert(out.end(), b.begin(), b.end()); },
+                              block_size);
+        enc.write(src);
+        enc.finish();
+        return out;
+    }
+
+    template<typename D, typename Codec>
+    requires stream_codec<Codec, D>
+    [[nodiscard]]
+    std::optional<std::vector<D>> decompress(std::span<const std::uint8_t> in, const Codec& codec) {
+        Decoder<D, Codec> dec(codec, [&](std::span<std::uint8_t> buf) {
+            const std::size_t k = std::min(buf.size(), in.size());
+            std::copy_n(in.begin(), k, buf.begin());
+            in = in.subspan(k);
+            return k;
+        });
+        std::vector<D> out;
+        std::vector<D> chunk(std::size_t{1} << 16);
+        while (!dec.finished()) {
+            const auto n = dec.read(chunk);
+            if (!n) return std::nullopt;
+            out.insert(out.end(), chunk.begin(), chunk.begin() + static_cast<std::ptrdiff_t>(*n));
+        }
+        return out;
+    }
+
+} // namespace encoding::stream
@@ -1,9 +1,126 @@
 #include <iostream>
 #include <vector>
 #include <variant>
+#include <string>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <initializer_list>
+#include <limits>
 #include "encoding_lossy.hpp"      // <-- orthographe corrigée + .hpp
 #include "encoding_lossless.hpp"   // <-- .hpp
 #include "utils.hpp"               // <-- .hpp
+#include "container.hpp"
+#include "image.hpp"
+#include "stream.hpp"
+#include "stats.hpp"
+#include "dictionary.hpp"
+#include "pipeline.hpp"
+#include "dedup.hpp"
+#if defined(__unix__) || defined(__APPLE__)
+#include <filesystem>
+#include "io.hpp"
+#endif
+
+namespace {
+
+    // nombre de vérifications en échec : dc_test sort avec 1 s'il n'est pas nul
+    int failures = 0;
+
+    const char* verdict(bool ok, const char* pass = "round-trip OK", const char* fail = "round-trip FAILED") {
+        if (!ok) ++failures;
+        return ok ? pass : fail;
+    }
+
+    // remplace le varint à l'offset at (compte, taille) par v : en-tête forgé
+    std::vector<std::uint8_t> forge(const std::vector<std::uint8_t>& bytes, std::size_t at, std::uint64_t v) {
+        const std::uint8_t* p = bytes.data() + at;
+        (void)utils::get_varint(p, bytes.data() + bytes.size());
+        std::vector<std::uint8_t> out(bytes.begin(), bytes.begin() + static_cast<std::ptrdiff_t>(at));
+        utils::put_varint(out, v);
+        out.insert(out.end(), p, bytes.data() + bytes.size());
+        return out;
+    }
+
+    // entrées corrompues tirées de bytes ; decode renvoie nullopt (refus) ou si les données
+    // décodées sont les bonnes. Chaque préfixe strict et chaque en-tête forgé (varint à l'un
+    // des offsets counts mis à 2^62) doit être refusé ; un bit inversé doit être refusé ou
+    // redonner l'original (n'importe quel résultat si !checked : format sans crc). Aucune
+    // exception. Renvoie le nombre de cas en défaut.
+    template<typename Decode>
+    std::size_t corrupt_cases(const std::vector<std::uint8_t>& bytes, std::initializer_list<std::size_t> counts,
+                              Decode decode, bool checked = true) {
+        std::size_t bad = 0;
+        const auto run = [&](std::span<const std::uint8_t> in, bool must_reject) {
+            try {
+                const std::optional<bool> r = decode(in);
+                bad += r && (must_reject || (checked && !*r));
+            } catch (...) {
+                ++bad;
+            }
+        };
+        for (std::size_t n = 0; n < bytes.size(); ++n) run(std::span(bytes).first(n), true);
+        for (std::size_t i = 0; i < bytes.size(); ++i) {
+            auto flipped = bytes;
+            flipped[i] ^= static_cast<std::uint8_t>(1u << (i % 8));
+            run(flipped, false);
+        }
+        for (const std::size_t at : counts) run(forge(bytes, at, std::uint64_t{1} << 62), true);
+        return bad;
+    }
+
+    // noyaux de quantification comparés élément par élément à detail::quantize_one : dispatch
+    // (quantum constant et tables), puis AVX2 / SSE4.1 appelés directement si le processeur les
+    // a. Longueurs avec reste, saturation, négatifs et demis, NaN, périodes de table qui ne sont
+    // pas la largeur vectorielle.
+    template<std::floating_point T, typename Q>
+    bool quantize_kernels_match() {
+        using encoding::lossy::Quantization;
+        using encoding::lossy::quantum_view;
+        const auto one = [](T v) { return encoding::lossy::detail::quantize_one<T, Q>(v); };
+        const T pattern[] = {T(0.5), T(-0.5), T(1.5), T(-2.5), T(-0.49), T(3.7), T(-3.7), T(40000), T(-40000),
+                             T(16383.75), T(-16384.25), T(2147483647.0), T(-1e12), std::numeric_limits<T>::quiet_NaN(),
+                             T(0), T(-0.0)};
+        bool ok = true;
+        for (std::size_t n : {0, 1, 2, 3, 5, 7, 8, 9, 15, 16, 17, 31, 33}) {
+            std::vector<T> x(n), back(n);
+            std::vector<Q> q(n);
+            for (std::size_t i = 0; i < n; ++i) x[i] = pattern[i * 7 % std::size(pattern)];
+
+            Quantization::encode_into<T, Q>(x, T(0.5), q);
+            for (std::size_t i = 0; i < n; ++i) ok = ok && q[i] == one(x[i] * T(2));
+            Quantization::decode_into<Q, T>(q, T(0.5), back);
+            for (std::size_t i = 0; i < n; ++i) ok = ok && back[i] == static_cast<T>(q[i]) * T(0.5);
+
+            for (std::size_t period : {1, 3, 4, 5, 8, 13}) {
+                std::vector<T> step(period);
+                for (std::size_t j = 0; j < period; ++j) step[j] = T(0.5) * static_cast<T>(j + 1);
+                const auto inv = Quantization::inverses<T>(step);
+                const quantum_view<T> table(step, inv);
+                Quantization::encode_into<T, Q>(x, table, q);
+                for (std::size_t i = 0; i < n; ++i) ok = ok && q[i] == one(x[i] * inv[i % period]);
+                Quantization::decode_into<Q, T>(q, table, back);
+                for (std::size_t i = 0; i < n; ++i) ok = ok && back[i] == static_cast<T>(q[i]) * step[i % period];
+            }
+
+#ifdef ENCODING_X86_SIMD
+            namespace lossy = encoding::lossy::detail;
+            const auto level = utils::simd_support();
+            std::vector<T> inv(n);
+            for (std::size_t i = 0; i < n; ++i) inv[i] = T(1) / (T(0.5) * static_cast<T>(i % 5 + 1));
+            const auto check = [&](std::size_t done, const T* r) {
+                for (std::size_t i = 0; i < done; ++i) ok = ok && q[i] == one(x[i] * (r ? r[i] : T(2)));
+            };
+            for (const T* r : {static_cast<const T*>(nullptr), static_cast<const T*>(inv.data())}) {
+                if (level == utils::simd_level::avx2) check(lossy::quantize_avx2<T, Q>(x.data(), r, T(2), q.data(), n), r);
+                if (level >= utils::simd_level::sse41) check(lossy::quantize_sse41<T, Q>(x.data(), r, T(2), q.data(), n), r);
+            }
+#endif
+        }
+        return ok;
+    }
+
+} // namespace
 
 int main() {
     using namespace encoding::lossy;
@@ -19,7 +136,38 @@ int main() {
     for (const auto& v : encoded_cos) std::cout << v << " ";
     std::cout << "\nDecoded (DCT): ";
     for (const auto& v : decoded_cos) std::cout << v << " ";
-    std::cout << "\n\n";
+    std::cout << "\n";
+    {
+        // taille première : feuille FFT de DctPlan, comparée à la somme directe
+        const std::size_t N = 1021;
+        std::vector<double> x(N);
+        for (std::size_t n = 0; n < N; ++n) x[n] = std::sin(0.05 * static_cast<double>(n)) + 0.001 * static_cast<double>(n % 7);
+        const auto X = DiscreteCosinus::encode<double, double>(x, N);
+        double err = 0.0;
+        for (std::size_t k = 0; k < N; k += 17) {
+            double ref = 0.0;
+            for (std::size_t n = 0; n < N; ++n)
+                ref += x[n] * std::cos(std::numbers::pi * (static_cast<double>(n) + 0.5) * static_cast<double>(k) / N);
+            err = std::max(err, std::abs(ref * std::sqrt(2.0 / N) - X[k]));
+        }
+        std::cout << "DCT N=" << N << " (prime) vs direct sum: " << verdict(err < 1e-9, "OK", "FAILED") << "\n";
+    }
+    {
+        // cache de plans borné : 200 tailles passent, le cache en garde plan_cache_capacity, et
+        // un plan évincé puis reconstruit donne les mêmes coefficients
+        std::vector<double> x(200);
+        for (std::size_t n = 0; n < x.size(); ++n) x[n] = std::cos(0.3 * static_cast<double>(n));
+        const auto first = DiscreteCosinus::encode<double, double>(std::span<const double>(x).first(37), 37);
+        for (std::size_t n = 1; n <= x.size(); ++n)
+            (void)DiscreteCosinus::encode<double, double>(std::span<const double>(x).first(n), n);
+        const auto again = DiscreteCosinus::encode<double, double>(std::span<const double>(x).first(37), 37);
+        namespace plans = encoding::lossy::detail;
+        const bool bounded = plans::cached_plan_count<DctPlan<double>>() <= plans::plan_cache_capacity
+                          && plans::cached_plan_count<FftPlan<double>>() <= plans::plan_cache_capacity;
+        std::cout << "plan cache after 200 sizes: " << plans::cached_plan_count<DctPlan<double>>() << " DCT plans, "
+                  << verdict(bounded && first == again, "OK", "FAILED") << "\n";
+    }
+    std::cout << "\n";
 
     // ===== Quantization =====
     std::cout << "=== Test Quantization ===\n";
@@ -31,7 +179,22 @@ int main() {
     for (const auto& v : quantized) std::cout << v << " ";
     std::cout << "\nDequantized: ";
     for (const auto& v : dequantized) std::cout << v << " ";
-    std::cout << "\n\n";
+    std::cout << "\n";
+    {
+        // quantum constant : division exacte (lround(0.35 / 0.1) = 3) ; encode_into multiplie par
+        // l'inverse et peut arrondir d'un pas de plus près d'un demi-entier
+        const std::vector<double> ties = {0.35, 0.15, -0.35, 2.5};
+        const auto legacy = Quantization::encode<double>(ties, 0.1);
+        std::vector<int> fast(ties.size());
+        Quantization::encode_into<double, int>(ties, 0.1, fast);
+        const bool exact = legacy == std::vector<int>{3, 1, -3, 25};
+        std::cout << "constant quantum (exact division): " << verdict(exact, "OK", "FAILED")
+                  << ", reciprocal kernel: " << fast[0] << " " << fast[1] << " " << fast[2] << " " << fast[3] << "\n";
+        const bool kernels = quantize_kernels_match<double, std::int16_t>() && quantize_kernels_match<double, std::int32_t>()
+                          && quantize_kernels_match<float, std::int16_t>() && quantize_kernels_match<float, std::int32_t>();
+        std::cout << "SIMD kernels vs scalar: " << verdict(kernels, "OK", "FAILED") << "\n";
+    }
+    std::cout << "\n";
 
     // ===== Discrete Fourier =====
     std::cout << "=== Test Discrete Fourier ===\n";
@@ -46,19 +209,42 @@ int main() {
     for (const auto& v : decoded_fourier) std::cout << v << " ";
     std::cout << "\n\n";
 
+    // ===== Lots de trames (3 canaux entrelacés) =====
+    std::cout << "=== Test Batch Transform ===\n";
+    {
+        // échantillon i du canal c en interleaved[i * 3 + c]
+        std::vector<double> interleaved;
+        for (std::size_t i = 0; i < source_cos.size(); ++i)
+            for (double gain : {1.0, -2.0, 0.5}) interleaved.push_back(gain * source_cos[i]);
+        const auto frames = frame_view<const double>::interleaved(interleaved.data(), 3, source_cos.size());
+        auto coefs = DiscreteCosinus::encode_batch<double, double>(frames, source_cos.size());
+        auto back  = DiscreteCosinus::decode_batch<double, double>(frame_view<const double>::rows(coefs.data(), 3, source_cos.size()),
+                                                                   source_cos.size());
+        bool same = true, ok = true;
+        const auto single = DiscreteCosinus::encode<double, double>(source_cos, source_cos.size());
+        for (std::size_t k = 0; k < single.size(); ++k) same = same && std::abs(coefs[k] - single[k]) < 1e-9;
+        // chaque trame décodée comme par decode
+        for (std::size_t c = 0; c < 3; ++c) {
+            const auto one = DiscreteCosinus::decode<double, double>(
+                std::span<const double>(coefs).subspan(c * source_cos.size(), source_cos.size()), source_cos.size());
+            for (std::size_t i = 0; i < one.size(); ++i) ok = ok && std::abs(back[c * one.size() + i] - one[i]) < 1e-9;
+        }
+        std::cout << "Channel 0 (DCT): ";
+        for (std::size_t k = 0; k < single.size(); ++k) std::cout << coefs[k] << " ";
+        std::cout << "\nbatch == single: " << verdict(same && ok) << "\n\n";
+    }
+
     // ===== Huffman =====
     std::cout << "=== Test Huffman Encoding ===\n";
     std::vector<char> source_huffman = {'a','b','a','c','b','a'};
-    auto [huff_tree, huff_codes] = Huffman<char>::encode(source_huffman, false);
-
-    // aplatir pour tester le décodeur
-    std::vector<bool> bits;
-    for (const auto& code : huff_codes) bits.insert(bits.end(), code.begin(), code.end());
-    auto decoded_huffman = Huffman<char>::decode(huff_tree, bits);
+    auto [huff_table, huff_bytes, huff_count] = Huffman<char>::encode(source_huffman, false);
+    auto decoded_huffman = Huffman<char>::decode(huff_table, huff_bytes, huff_count);
 
-    std::cout << "Encoded Huffman: ";
-    for (const auto& code : huff_codes) {
-        for (bool b : code) std::cout << (b ? '1' : '0');
+    std::cout << "Encoded Huffman (" << huff_bytes.size() << " bytes): ";
+    auto huff_codes = Huffman<char>::make_codes(huff_table);
+    for (char c : source_huffman) {
+        auto code = *huff_codes.find(c);
+        for (unsigned b = 0; b < code.len; ++b) std::cout << ((code.bits >> b) & 1u ? '1' : '0');
         std::cout << " ";
     }
     std::cout << "\nDecoded Huffman: ";
@@ -87,7 +273,337 @@ int main() {
     std::cout << "\nDecoded LZ77: ";
     for (char c : dec_lz77) std::cout << c << " ";
     std::cout << "\n";
+    {
+        // contrat de find_match : au moins 3 symboles, la plus proche, chevauchement permis
+        const std::string search = "abxab", look = "abababz", shortm = "abq";
+        const auto m1 = utils::find_match<char>(search, look);
+        const auto m2 = utils::find_match<char>(search, shortm);
+        std::cout << "find_match: " << verdict(m1 && *m1 == std::pair<std::size_t, std::size_t>{2, 6} && !m2, "OK", "FAILED")
+                  << "\n";
+    }
+
+    // niveaux : même texte, taille du bloc container et aller-retour
+    const std::string phrase = "le chat mange, le chien mange, le chat dort ; le chien dort, le chat mange.";
+    std::vector<char> src_levels;
+    for (int r = 0; r < 8; ++r) src_levels.insert(src_levels.end(), phrase.begin() + r, phrase.end());
+    for (int level = LZ77<char>::min_level; level <= LZ77<char>::max_level; ++level) {
+        auto block = encoding::container::encode<char>(src_levels, encoding::container::codec::lz77,
+                                                       {1024, 64, 0, level});
+        auto back  = encoding::container::decode<char>(block);
+        std::cout << "level " << level << ": " << src_levels.size() << " -> " << block.size() << " bytes, "
+                  << verdict(back && *back == src_levels) << "\n";
+    }
+    std::cout << "\n";
+
+    // ===== Container =====
+    std::cout << "=== Test Container ===\n";
+    using encoding::container::codec;
+    for (auto id : {codec::stored, codec::huffman, codec::lz77, codec::rle, codec::rans}) {
+        auto block = encoding::container::encode<char>(src_lz77, id, {buffer_size, chunk_size, 64, 6});
+        auto back  = encoding::container::decode<char>(block);
+        const bool fallback = encoding::container::read_header(block)->id != id; // pas de gain : stored
+        std::cout << "codec " << static_cast<int>(id) << (fallback ? " (stored)" : "") << ": " << block.size()
+                  << " bytes, " << verdict(back && *back == src_lz77) << "\n";
+    }
+
+    // sans allocation : workspace sur un monotonic_buffer_resource sans amont (toute
+    // allocation au-delà du tampon lèverait std::bad_alloc), sortie dans un span
+    {
+        static std::byte arena[1 << 18];
+        std::pmr::monotonic_buffer_resource pool(arena, sizeof(arena), std::pmr::null_memory_resource());
+        encoding::container::workspace<char> ws(&pool);
+        std::vector<std::uint8_t> packed(encoding::container::max_compressed_size<char>(src_levels.size()));
+        std::vector<char> unpacked(src_levels.size());
+        bool ok = true;
+        std::size_t total = 0;
+        for (int message = 0; message < 100; ++message)
+            for (auto id : {codec::huffman, codec::lz77, codec::rle, codec::rans}) {
+                const auto n = encoding::container::encode_block_into<char>(packed, std::span<const char>(src_levels),
+                                                                            id, {1024, 64, 0, 6}, ws);
+                const auto used = n ? encoding::container::decode_block<char>(std::span(packed).first(*n), unpacked, 0, ws)
+                                    : std::nullopt;
+                ok = ok && used && unpacked == src_levels;
+                total += n.value_or(0);
+            }
+        std::cout << "400 blocks into spans, " << total << " bytes, arena "
+                  << verdict(ok) << "\n";
+    }
+
+    // ===== Pipeline LZ77 -> entropie (lots de séquences) =====
+    std::cout << "=== Test Pipeline ===\n";
+    {
+        std::vector<char> big;
+        for (int r = 0; r < 400; ++r) big.insert(big.end(), src_levels.begin() + r % 50, src_levels.end());
+        encoding::pipeline::Deflate<char> deflate;
+        encoding::pipeline::DeflateRans<char> deflate_rans;
+        const auto lz77_size = encoding::container::encode<char>(big, codec::lz77).size();
+        for (int k = 0; k < 2; ++k) {
+            std::vector<std::uint8_t> packed;
+            std::vector<char> back(big.size());
+            bool ok = false;
+            if (k == 0) { deflate.encode(std::span<const char>(big), packed); ok = deflate.decode(packed, std::span(back)).has_value(); }
+            else { deflate_rans.encode(std::span<const char>(big), packed); ok = deflate_rans.decode(packed, std::span(back)).has_value(); }
+            std::cout << (k == 0 ? "lz77+huffman: " : "lz77+rans: ") << big.size() << " -> " << packed.size()
+                      << " bytes (lz77 alone " << lz77_size << "), "
+                      << verdict(ok && back == big) << "\n";
+        }
+        auto inflated = encoding::pipeline::inflate<char>(encoding::pipeline::deflate<char>(src_lz77));
+        std::cout << "deflate/inflate: " << verdict(inflated && *inflated == src_lz77) << "\n";
+    }
+
+    // ===== Déduplication (répétitions hors de la fenêtre LZ77) =====
+    std::cout << "=== Test Dedup ===\n";
+    {
+        // un bloc de 16 Kio répété, séparé par 48 Kio de bruit (au-delà de la fenêtre de 32 Kio)
+        std::uint32_t x = 12345;
+        const auto noise = [&](std::size_t n) {
+            std::vector<char> v(n);
+            for (auto& c : v) { x = x * 1664525u + 1013904223u; c = static_cast<char>(x >> 24); }
+            return v;
+        };
+        const auto block = noise(16384);
+        std::vector<char> backup;
+        for (int r = 0; r < 8; ++r) {
+            backup.insert(backup.end(), block.begin(), block.end());
+            backup[backup.size() - 1000 * static_cast<std::size_t>(r + 1)] ^= 1; // copies modifiées
+            const auto fill = noise(49152);
+            backup.insert(backup.end(), fill.begin(), fill.end());
+        }
+        const auto lz77_size = encoding::container::encode<char>(backup, codec::lz77).size();
+        const auto packed = encoding::dedup::compress<char>(backup, {256, 1024, 8192, 64, std::size_t{1} << 16});
+        const auto back = encoding::dedup::decompress<char>(packed);
+        std::cout << "dedup+lz77: " << backup.size() << " -> " << packed.size() << " bytes (lz77 alone " << lz77_size << "), "
+                  << verdict(back && *back == backup) << "\n";
+        // bloc répété bout à bout : les références sont plus longues que leur distance (recouvrement)
+        const auto period = noise(3000);
+        std::vector<char> periodic;
+        for (int r = 0; r < 12; ++r) periodic.insert(periodic.end(), period.begin(), period.end());
+        const auto packed_periodic = encoding::dedup::compress<char>(periodic, {256, 1024, 8192, 64, std::size_t{1} << 16});
+        const auto back_periodic = encoding::dedup::decompress<char>(packed_periodic);
+        std::cout << "overlapping references: " << periodic.size() << " -> " << packed_periodic.size() << " bytes, "
+                  << verdict(back_periodic && *back_periodic == periodic) << "\n";
+    }
+
+    // ===== Dictionnaire (petits messages) =====
+    std::cout << "=== Test Dictionary ===\n";
+    const auto message = [](int i) {
+        const std::string m = "{\"user\": " + std::to_string(1000 + 37 * i) + ", \"event\": \""
+                            + (i % 3 ? "click" : "scroll") + "\", \"page\": \"/articles/" + std::to_string(i % 7)
+                            + "\", \"status\": \"ok\"}";
+        return std::vector<char>(m.begin(), m.end());
+    };
+    std::vector<std::vector<char>> samples;
+    for (int i = 0; i < 64; ++i) samples.push_back(message(i));
+    const auto dict = encoding::dictionary::Dictionary<char>::train(samples, {1024, 32, 6});
+    const auto dict_bytes = dict.serialize();
+    const auto loaded = encoding::dictionary::Dictionary<char>::load(dict_bytes);
+    std::cout << "dictionary: " << dict.content().size() << " symbols, " << dict_bytes.size() << " bytes serialized, "
+              << verdict(loaded && loaded->id() == dict.id(), "reload OK", "reload FAILED") << "\n";
+    for (auto id : {codec::lz77, codec::dict_lz77, codec::dict_huffman, codec::dict_rans}) {
+        std::size_t total = 0, nb = 0;
+        bool ok = true;
+        for (int i = 100; i < 120; ++i, ++nb) {
+            const auto m = message(i);
+            auto block = encoding::container::encode<char>(m, id, dict);
+            auto back  = loaded ? encoding::container::decode<char>(block, *loaded) : std::nullopt;
+            ok = ok && back && *back == m;
+            total += block.size();
+        }
+        std::cout << "codec " << static_cast<int>(id) << ": " << message(100).size() << " -> " << total / nb
+                  << " bytes per message, " << verdict(ok) << "\n";
+    }
+
+    // ===== Image (DCT 8x8 -> quantification -> zigzag -> RLE -> Huffman) =====
+    std::cout << "=== Test Image ===\n";
+    const std::size_t img_w = 37, img_h = 21;
+    std::vector<std::uint8_t> img(img_w * img_h);
+    for (std::size_t y = 0; y < img_h; ++y)
+        for (std::size_t x = 0; x < img_w; ++x) img[y * img_w + x] = static_cast<std::uint8_t>(4 * x + 3 * y);
+    auto img_enc = encoding::image::encode(img, img_w, img_h);
+    auto img_dec = encoding::image::decode(img_enc);
+    int max_err = -1;
+    if (img_dec && img_dec->pixels.size() == img.size()) {
+        max_err = 0;
+        for (std::size_t i = 0; i < img.size(); ++i)
+            max_err = std::max(max_err, std::abs(int(img[i]) - int(img_dec->pixels[i])));
+    }
+    // dégradé lisse à la qualité 75 : quelques niveaux d'erreur au plus
+    std::cout << img_w << "x" << img_h << " -> " << img_enc.size() << " bytes, max error " << max_err << ", "
+              << verdict(max_err >= 0 && max_err <= 4, "within 4", "FAILED") << "\n";
+    {
+        // image plate (bords partiels compris) : seul le DC est non nul, chaque pixel revient exactement
+        const std::vector<std::uint8_t> flat(img_w * img_h, 200);
+        bool exact = true;
+        for (std::size_t b : {8, 16}) {
+            encoding::image::params fp;
+            fp.block_size = b;
+            const auto back = encoding::image::decode(encoding::image::encode(flat, img_w, img_h, fp));
+            exact = exact && back && back->pixels == flat;
+        }
+        std::cout << "flat image, 8x8 and 16x16: " << verdict(exact, "exact", "FAILED") << "\n";
+    }
+    encoding::image::params img_rans;
+    img_rans.entropy = codec::rans;
+    auto img_enc_rans = encoding::image::encode(img, img_w, img_h, img_rans);
+    auto img_dec_rans = encoding::image::decode(img_enc_rans);
+    std::cout << "rANS: " << img_enc_rans.size() << " bytes, "
+              << verdict(img_dec && img_dec_rans && img_dec_rans->pixels == img_dec->pixels, "same pixels")
+              << "\n";
+
+    // ===== Flux (écriture par morceaux, lecture dans un span) =====
+    std::cout << "=== Test Stream ===\n";
+    std::vector<std::uint8_t> stream_bytes;
+    encoding::stream::Encoder<char, encoding::stream::lz77_codec<char>> senc(
+        {{256, 64, 0, 6}},
+        [&](std::span<const std::uint8_t> b){ stream_bytes.insert(stream_bytes.end(), b.begin(), b.end()); },
+        100);
+    for (std::size_t i = 0; i < src_levels.size(); i += 37)
+        senc.write(std::span<const char>(src_levels).subspan(i, std::min<std::size_t>(37, src_levels.size() - i)));
+    senc.finish();
+    auto stream_back = encoding::stream::decompress<char>(stream_bytes, encoding::stream::lz77_codec<char>{{256, 64, 0, 6}});
+    std::cout << src_levels.size() << " -> " << stream_bytes.size() << " bytes, "
+              << verdict(stream_back && *stream_back == src_levels) << "\n";
+
+#if defined(__unix__) || defined(__APPLE__)
+    // ===== Fichiers (AsyncWriter en double tampon, InputFile mmap / pread) =====
+    std::cout << "\n=== Test File I/O ===\n";
+    {
+        const auto path = (std::filesystem::temp_directory_path() / "dc_test_io.bin").string();
+        const encoding::parallel::container_codec<char> file_codec{codec::huffman, {}};
+        bool written = false;
+        if (auto w = encoding::io::AsyncWriter::create(path.c_str(), 64)) {
+            // blocs entiers codés sans copie ; tampons de 64 octets : plusieurs échanges
+            encoding::stream::Encoder<char, encoding::parallel::container_codec<char>> fenc(
+                file_codec, [&](std::span<const std::uint8_t> b){ w->write(b); }, 100);
+            fenc.write(src_levels);
+            fenc.finish();
+            written = w->finish();
+        }
+        for (bool use_map : {true, false}) {
+            auto f = encoding::io::InputFile::open(path.c_str(), use_map);
+            const auto bytes = f ? f->read(0, static_cast<std::size_t>(f->size())) : std::nullopt;
+            const auto back = bytes ? encoding::stream::decompress<char>(*bytes, file_codec) : std::nullopt;
+            std::cout << (use_map ? "mmap: " : "pread: ") << (f ? f->size() : 0) << " bytes, "
+                      << verdict(written && back && *back == src_levels) << "\n";
+        }
+        std::filesystem::remove(path);
+    }
+#endif
+
+    // ===== Statistiques (politique stats::collect) =====
+    std::cout << "=== Test Stats ===\n";
+    using encoding::stats::collect;
+    using encoding::stats::stage;
+    (void)collect::take();
+    std::vector<std::uint8_t> stats_block;
+    // stats::none (défaut) : aucune sonde, les compteurs du thread restent à zéro
+    encoding::container::encode_block<char>(stats_block, std::span<const char>(src_levels), codec::lz77);
+    encoding::container::encode_block<char>(stats_block, std::span<const char>(src_levels), codec::huffman);
+    encoding::container::encode_block<char>(stats_block, std::span<const char>(src_levels), codec::rans);
+    (void)DiscreteCosinus::encode<double, double>(source_cos, 2);
+    const auto idle = collect::take();
+    bool quiet = idle.bytes_in == 0 && idle.bytes_out == 0 && idle.lz77.symbols == 0 && idle.lz77.searches == 0
+              && idle.huffman.symbols == 0 && idle.rans.symbols == 0 && idle.dct.blocks == 0;
+    for (const auto& t : idle.time) quiet = quiet && t.calls == 0 && t.ns == 0;
+    std::cout << "stats::none counters: " << verdict(quiet, "zero", "FAILED") << "\n";
+
+    encoding::container::encode_block<char, collect>(stats_block, std::span<const char>(src_levels), codec::lz77);
+    encoding::container::encode_block<char, collect>(stats_block, std::span<const char>(src_levels), codec::huffman);
+    encoding::container::encode_block<char, collect>(stats_block, std::span<const char>(src_levels), codec::rans);
+    (void)BasicDiscreteCosinus<collect>::encode<double, double>(source_cos, 2);
+    const auto st = collect::take();
+    // une analyse LZ77 : littéraux et symboles des correspondances couvrent l'entrée
+    const bool lz77_counts = st.lz77.symbols == src_levels.size() && st.lz77.matches > 0
+                          && st.lz77.literals + st.lz77.matched == st.lz77.symbols
+                          && st.lz77.searches > 0 && st.lz77.probes > 0;
+    // étapes exécutées présentes, décodeurs absents ; block_encode inclut lz77_parse
+    bool stages = st[stage::block_encode].calls == 3 && st[stage::block_encode].ns >= st[stage::lz77_parse].ns;
+    for (auto s : {stage::count, stage::lz77_parse, stage::huffman_build, stage::huffman_encode, stage::rans_build,
+                   stage::rans_encode, stage::dct_forward})
+        stages = stages && st[s].calls > 0;
+    for (auto s : {stage::huffman_decode, stage::rans_decode, stage::lz77_decode, stage::dct_inverse, stage::block_decode})
+        stages = stages && st[s].calls == 0 && st[s].ns == 0;
+    std::cout << "stats::collect lz77 counts: " << verdict(lz77_counts, "OK", "FAILED")
+              << ", stage times: " << verdict(stages, "OK", "FAILED") << "\n";
+    std::cout << "lz77: literal ratio " << st.lz77.literal_ratio() << ", chain depth " << st.lz77.avg_chain_depth()
+              << "; huffman: " << st.huffman.bits_per_symbol() << " bits/symbol for entropy " << st.huffman.entropy()
+              << "; rans: " << st.rans.bits_per_symbol() << " bits/symbol"
+              << "; dct energy kept " << st.dct.energy_ratio() << "\n";
+    std::cout << encoding::stats::to_json(st) << "\n";
+
+    // ===== Entrées corrompues (préfixes, bits inversés, en-têtes forgés) =====
+    std::cout << "=== Test Corrupt Input ===\n";
+    {
+        const auto same = [](const auto& back, const auto& ref) {
+            return back ? std::optional<bool>(*back == ref) : std::nullopt;
+        };
+        const auto report = [](const char* name, std::size_t bad) {
+            std::cout << name << ": " << bad << " accepted or thrown, " << verdict(bad == 0, "OK", "FAILED") << "\n";
+        };
+
+        // container : nb_symbols à l'offset 4, pour chaque codec
+        std::size_t bad = 0;
+        for (auto id : {codec::stored, codec::huffman, codec::lz77, codec::rle, codec::rans})
+            bad += corrupt_cases(encoding::container::encode<char>(src_levels, id, {1024, 64, 0, 6}), {4},
+                                 [&](auto in) { return same(encoding::container::decode<char>(in), src_levels); });
+        const auto m = message(100);
+        for (auto id : {codec::dict_lz77, codec::dict_huffman, codec::dict_rans})
+            bad += corrupt_cases(encoding::container::encode<char>(m, id, dict), {4},
+                                 [&](auto in) { return same(encoding::container::decode<char>(in, dict), m); });
+        report("container", bad);
+
+        // flux : block_size à l'offset 3 ; trames container (crc)
+        const encoding::parallel::container_codec<char> frame_codec{codec::huffman, {}};
+        report("stream", corrupt_cases(encoding::stream::compress<char>(src_levels, frame_codec, 100), {3},
+                                       [&](auto in) { return same(encoding::stream::decompress<char>(in, frame_codec), src_levels); }));
+
+        // pipeline : nb_symbols à l'offset 5
+        report("pipeline", corrupt_cases(encoding::pipeline::deflate<char>(src_levels), {5},
+                                         [&](auto in) { return same(encoding::pipeline::inflate<char>(in), src_levels); }));
+
+        // dedup : nb_symbols à l'offset 3 ; un bloc répété hors de la fenêtre donne des références
+        std::vector<char> repeated(src_levels);
+        for (std::size_t i = 0; i < 2048; ++i) repeated.push_back(static_cast<char>(i * 2654435761u >> 24));
+        repeated.insert(repeated.end(), src_levels.begin(), src_levels.end());
+        report("dedup", corrupt_cases(encoding::dedup::compress<char>(repeated, {64, 128, 512, 64, std::size_t{1} << 16},
+                                                                      {{256, 64, 0, 6}}),
+                                      {3}, [&](auto in) { return same(encoding::dedup::decompress<char>(in, {{256, 64, 0, 6}}), repeated); }));
+
+        // archive parallèle : block_size à l'offset 2, nb_symbols à l'offset 3 (block_size < 128)
+        encoding::parallel::ThreadPool pool(2);
+        const encoding::parallel::container_codec<char> block_codec{codec::lz77, {1024, 64, 0, 6}};
+        report("parallel", corrupt_cases(encoding::parallel::compress<char>(src_levels, block_codec, 100, pool), {2, 3},
+                                         [&](auto in) { return same(encoding::parallel::decompress<char>(in, block_codec, pool), src_levels); }));
+
+        // image : largeur et hauteur aux offsets 3 et 4 (< 128), puis count_end après la matrice ;
+        // l'en-tête n'a pas de crc
+        const auto image_same = [&](auto in) {
+            const auto back = encoding::image::decode(in);
+            return back ? std::optional<bool>(back->pixels == img_dec->pixels) : std::nullopt;
+        };
+        const auto count_offset = [](const std::vector<std::uint8_t>& bytes) {
+            const std::uint8_t* q = bytes.data() + 3;
+            for (std::size_t i = 0; i < 2 + 64; ++i) (void)utils::get_varint(q, bytes.data() + bytes.size());
+            return static_cast<std::size_t>(q - bytes.data());
+        };
+        bad = corrupt_cases(img_enc, {3, 4, count_offset(img_enc)}, image_same, false);
+        // image plate : aucun coefficient non nul, blocs vides ; dimensions forgées à 65528 x 65528
+        // (3 octets chacune) et count_end à tous les coefficients, ~8 Go d'int16
+        const std::vector<std::uint8_t> flat(16 * 16, 128);
+        auto huge = forge(forge(encoding::image::encode(flat, 16, 16), 3, 65528), 6, 65528);
+        huge = forge(huge, count_offset(huge), std::uint64_t{8191} * 8191 * 64);
+        bad += corrupt_cases(huge, {}, image_same, false);
+        report("image", bad);
+
+        // dictionnaire : taille du contenu à l'offset 3 ; pas de crc, un bit inversé peut donner
+        // un autre dictionnaire valide
+        report("dictionary", corrupt_cases(dict_bytes, {3}, [&](auto in) {
+            const auto d = encoding::dictionary::Dictionary<char>::load(in);
+            return d ? std::optional<bool>(d->id() == dict.id()) : std::nullopt;
+        }, false));
+    }
 
-    return 0;
+    if (failures) std::cout << failures << " check(s) FAILED\n";
+    return failures == 0 ? 0 : 1;
 }
 
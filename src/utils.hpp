@@ -11,6 +11,20 @@
 #include <cassert>
 #include <span>
 #include <type_traits>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <array>
+#include <cstring>
+#include <unordered_map>
+#include <memory_resource>
+#include "stats.hpp"
+
+// noyaux SIMD x86 compilés à part (attribut target) et choisis à l'exécution
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define ENCODING_X86_SIMD 1
+#include <immintrin.h>
+#endif
 
 namespace utils {
 
@@ -102,6 +116,115 @@ public:
     }
 };
 
+// ===== FlatWeightedTree : arbre pondéré à plat, indexé, dans une seule arène =====
+// Même forme que WeightedBinaryTree mais sans allocation par nœud : les feuilles occupent
+// les indices [0, n), les nœuds internes suivent dans l'ordre de création. Construction
+// en O(n log n) (tri des feuilles) puis fusion linéaire à deux files : les nœuds internes
+// naissent avec des poids croissants, la plus petite paire est toujours en tête de l'une
+// ou l'autre file.
+template<typename W, typename D>
+class FlatWeightedTree {
+public:
+    using index_type = std::uint32_t;
+    static constexpr index_type none = std::numeric_limits<index_type>::max();
+
+    struct node {
+        W          weight{};
+        index_type left  = none; // none : feuille
+        index_type right = none;
+    };
+
+private:
+    std::pmr::vector<node>       m_nodes;
+    std::pmr::vector<D>          m_data;  // m_data[i] : symbole de la feuille i
+    std::pmr::vector<index_type> m_order; // feuilles triées par poids (construction)
+    mutable std::pmr::vector<std::pair<index_type, unsigned>> m_stack; // parcours des feuilles
+    index_type                   m_root = none;
+
+public:
+    FlatWeightedTree() = default;
+
+    // arbre vide dont les tableaux sont pris dans mr
+    explicit FlatWeightedTree(std::pmr::memory_resource* mr)
+        : m_nodes(mr), m_data(mr), m_order(mr), m_stack(mr) {}
+
+    // leaves : (symbole, poids) ; le moins lourd des deux devient l'enfant gauche
+    explicit FlatWeightedTree(std::span<const std::pair<D, W>> leaves) { assign(leaves); }
+
+    // reconstruit l'arbre en réutilisant la mémoire déjà réservée
+    void assign(std::span<const std::pair<D, W>> leaves) {
+        m_nodes.clear();
+        m_data.clear();
+        m_root = none;
+        const std::size_t n = leaves.size();
+        if (n == 0) return;
+        assert(n < none / 2);
+        m_nodes.reserve(2 * n);
+        m_data.reserve(n);
+        for (auto& [d,w] : leaves) { m_nodes.push_back({w, none, none}); m_data.push_back(d); }
+
+        m_order.resize(n);
+        for (std::size_t i = 0; i < n; ++i) m_order[i] = static_cast<index_type>(i);
+        // tri stable par indice à poids égal (std::stable_sort allouerait un tampon)
+        std::sort(m_order.begin(), m_order.end(), [&](index_type a, index_type b){
+            return m_nodes[a].weight != m_nodes[b].weight ? m_nodes[a].weight < m_nodes[b].weight : a < b;
+        });
+
+        // file 1 : m_order[q1..n) ; file 2 : nœuds internes [q2, size())
+        std::size_t q1 = 0;
+        std::size_t q2 = n;
+        auto pop_min = [&]() -> index_type {
+            if (q2 < m_nodes.size() && (q1 == n || m_nodes[q2].weight < m_nodes[m_order[q1]].weight))
+                return static_cast<index_type>(q2++);
+            return m_order[q1++];
+        };
+        for (std::size_t k = 1; k < n; ++k) {
+            const index_type l = pop_min();
+            const index_type r = pop_min();
+            m_nodes.push_back({m_nodes[l].weight + m_nodes[r].weight, l, r});
+        }
+        m_root = static_cast<index_type>(m_nodes.size() - 1);
+    }
+
+    [[nodiscard]] bool        empty() const noexcept { return m_root == none; }
+    [[nodiscard]] index_type  root()  const noexcept { return m_root; }
+    [[nodiscard]] std::size_t size()  const noexcept { return m_nodes.size(); }
+    [[nodiscard]] const node& operator[](index_type i) const { return m_nodes[i]; }
+
+    [[nodiscard]] bool is_leaf(index_type i) const noexcept {
+        return m_nodes[i].left == none && m_nodes[i].right == none;
+    }
+    [[nodiscard]] W        get_weight(index_type i) const noexcept { return m_nodes[i].weight; }
+    [[nodiscard]] const D& get_data(index_type i)   const { assert(i < m_data.size()); return m_data[i]; }
+
+    // même effet que WeightedBinaryTree::add_dummy : le sous-arbre droit de la racine
+    // descend d'un niveau sous un nœud à un seul enfant
+    void add_dummy() {
+        if (empty() || is_leaf(m_root)) return;
+        const index_type a = m_nodes[m_root].right;
+        if (a == none) return;
+        m_nodes.push_back({m_nodes[a].weight, a, none});
+        m_nodes[m_root].right = static_cast<index_type>(m_nodes.size() - 1);
+    }
+
+    // appelle f(symbole, profondeur, poids) pour chaque feuille, gauche d'abord
+    template<typename F>
+    void for_each_leaf(F&& f) const {
+        if (empty()) return;
+        auto& stack = m_stack;
+        stack.clear();
+        stack.emplace_back(m_root, 0u);
+        while (!stack.empty()) {
+            const auto [i, depth] = stack.back();
+            stack.pop_back();
+            const node& nd = m_nodes[i];
+            if (is_leaf(i)) { f(m_data[i], depth, nd.weight); continue; }
+            if (nd.right != none) stack.emplace_back(nd.right, depth + 1);
+            if (nd.left  != none) stack.emplace_back(nd.left,  depth + 1);
+        }
+    }
+};
+
 // insère dans v (ordre décroissant) en gardant l’ordre trié
 template<typename D>
 void insert_in_isorted(std::vector<D>& v, const D& data) {
@@ -109,31 +232,724 @@ void insert_in_isorted(std::vector<D>& v, const D& data) {
     v.insert(it.base(), data);
 }
 
-// find_match : retourne (offset depuis la fin du buffer de recherche, longueur)
+// clé entière d'un symbole, utilisée par les fonctions de hachage ci-dessous
+template<typename D>
+[[nodiscard]] constexpr std::uint64_t symbol_key(const D& d) {
+    if constexpr (std::is_integral_v<D> || std::is_enum_v<D>) return static_cast<std::uint64_t>(d);
+    else return static_cast<std::uint64_t>(std::hash<D>{}(d));
+}
+
+// ===== MatchFinder : recherche de correspondances par chaînes de hachage =====
+// Indexe la fenêtre au fil de l'eau : head[h] = dernière position dont les min_match
+// premiers symboles hachent vers h, prev[pos & mask] = position précédente de même
+// hachage. Travaille directement sur une vue (aucune copie de la fenêtre), et borne
+// le parcours d'une chaîne à max_chain candidats. Stats compte parcours et candidats.
+// Un index de base figé (set_base, par ex. un dictionnaire) peut précéder les données : ses
+// chaînes sont parcourues, en lecture seule, après celles des données.
+template<typename D, typename Stats = encoding::stats::none>
+class MatchFinder {
+    template<typename, typename> friend class MatchFinder;
+
+public:
+    using match_t = std::pair<std::size_t, std::size_t>; // (offset, longueur)
+
+    static constexpr std::size_t min_match = 3;
+    static constexpr std::size_t nil       = std::numeric_limits<std::size_t>::max();
+
+private:
+    std::span<const D>       m_data;
+    std::size_t              m_window;
+    std::size_t              m_max_chain;
+    unsigned                 m_hash_bits;
+    std::size_t              m_mask;
+    std::size_t              m_next = 0;   // prochaine position à indexer
+    std::pmr::vector<std::size_t> m_head;
+    std::pmr::vector<std::size_t> m_prev;
+    const MatchFinder<D>*         m_base = nullptr;
+
+    // hachage 64 bits ; une table de b bits en garde les b bits de poids fort, si bien qu'un
+    // même hachage sert à des tables de tailles différentes
+    [[nodiscard]] std::uint64_t hash64_at(std::size_t pos) const {
+        const D* p = m_data.data() + pos;
+        std::uint64_t h = 0;
+        for (std::size_t i = 0; i < min_match; ++i)
+            h = (h ^ symbol_key(p[i])) * 0x9E3779B97F4A7C15ull;
+        return h;
+    }
+
+    [[nodiscard]] std::size_t hash_at(std::size_t pos) const {
+        return static_cast<std::size_t>(hash64_at(pos) >> (64 - m_hash_bits));
+    }
+
+public:
+    // hash_bits = 0 : taille de la table de têtes déduite de la fenêtre
+    explicit MatchFinder(std::size_t window_size, std::size_t max_chain = 64, unsigned hash_bits = 0,
+                         std::pmr::memory_resource* mr = std::pmr::get_default_resource())
+        : m_head(mr), m_prev(mr) {
+        configure(window_size, max_chain, hash_bits);
+    }
+
+    // moteur à configurer (configure) avant usage ; ses tables sont prises dans mr
+    explicit MatchFinder(std::pmr::memory_resource* mr)
+        : m_window(0), m_max_chain(1), m_hash_bits(0), m_mask(0), m_head(mr), m_prev(mr) {}
+
+    // change fenêtre et profondeur de chaîne ; les tables gardent leur mémoire si elle suffit.
+    // L'index est à refaire (reset).
+    void configure(std::size_t window_size, std::size_t max_chain, unsigned hash_bits = 0) {
+        m_window    = window_size;
+        m_max_chain = std::max<std::size_t>(max_chain, 1);
+        m_hash_bits = hash_bits ? hash_bits
+                                : std::clamp<unsigned>(static_cast<unsigned>(std::bit_width(window_size)), 8u, 20u);
+        m_mask      = std::bit_ceil(std::max<std::size_t>(window_size, 1)) - 1;
+        m_next      = 0;
+        m_data      = {};
+        m_base      = nullptr;
+        m_head.assign(std::size_t{1} << m_hash_bits, nil);
+        // m_prev n'est lu que pour des positions indexées depuis le dernier reset : inutile de le vider
+        m_prev.resize(m_mask + 1, nil);
+    }
+
+    [[nodiscard]] std::size_t window_size() const noexcept { return m_window; }
+    [[nodiscard]] std::size_t max_chain() const noexcept { return m_max_chain; }
+    [[nodiscard]] std::span<const D> data() const noexcept { return m_data; }
+
+    // base : index figé de symboles qui précèdent immédiatement data[0] (position p de base à
+    // distance pos + base->data().size() - p de pos). Il doit couvrir toute sa vue
+    // (insert_until), rester inchangé et survivre au moteur ; nullptr le détache.
+    // Plusieurs moteurs peuvent partager la même base entre threads.
+    void set_base(const MatchFinder<D>* base) noexcept { m_base = base; }
+
+    // rattache le moteur à une nouvelle vue et vide l'index (la mémoire est conservée)
+    void reset(std::span<const D> data) {
+        m_data = data;
+        m_next = 0;
+        std::fill(m_head.begin(), m_head.end(), nil);
+    }
+
+    // indexe toutes les positions < end
+    void insert_until(std::size_t end) {
+        if (m_data.size() < min_match) return;
+        end = std::min(end, m_data.size() - min_match + 1);
+        for (; m_next < end; ++m_next) {
+            const std::size_t h = hash_at(m_next);
+            m_prev[m_next & m_mask] = m_head[h];
+            m_head[h] = m_next;
+        }
+    }
+
+    // saute les positions < end sans les indexer (analyses rapides)
+    void skip_until(std::size_t end) noexcept { m_next = std::max(m_next, end); }
+
+    // parcourt la chaîne de pos et appelle on_better(offset, longueur) à chaque correspondance
+    // plus longue que les précédentes (>= min_match, <= max_len) : les offsets croissent avec
+    // les longueurs. S'arrête dès qu'une longueur atteint nice_len. Renvoie la meilleure longueur
+    // (0 si aucune).
+    template<typename F>
+    std::size_t for_each_match(std::size_t pos, std::size_t max_len, std::size_t nice_len, F&& on_better) {
+        insert_until(pos);
+        if (pos >= m_data.size()) return 0;
+        const std::size_t avail = std::min(max_len, m_data.size() - pos);
+        if (avail < min_match) return 0;
+        nice_len = std::min(nice_len, avail);
+
+        const D* const cur = m_data.data() + pos;
+        const std::uint64_t h = hash64_at(pos);
+        std::size_t best_len = min_match - 1;
+        std::size_t depth = m_max_chain;
+        std::size_t cand  = m_head[static_cast<std::size_t>(h >> (64 - m_hash_bits))];
+        bool done = false; // fenêtre dépassée ou nice_len atteinte : pas de passage à la base
+        while (cand != nil && depth != 0) {
+            if (cand < pos) {
+                const std::size_t dist = pos - cand;
+                if (dist > m_window) { done = true; break; }
+                --depth;
+                const D* const ref = m_data.data() + cand;
+                if (ref[best_len] == cur[best_len]) {
+                    std::size_t len = 0;
+                    while (len < avail && ref[len] == cur[len]) ++len;
+                    if (len > best_len) {
+                        best_len = len;
+                        on_better(dist, len);
+                        if (len >= nice_len) { done = true; break; }
+                    }
+                }
+            }
+            const std::size_t next = m_prev[cand & m_mask];
+            if (next >= cand) break; // fin de chaîne (ou entrée écrasée)
+            cand = next;
+        }
+        if (m_base && !done && depth != 0) {
+            // chaînes de la base : une correspondance peut déborder de sa fin sur data[0, ...)
+            const MatchFinder<D>& b = *m_base;
+            const std::size_t size = b.m_data.size();
+            cand = b.m_head[static_cast<std::size_t>(h >> (64 - b.m_hash_bits))];
+            while (cand != nil && depth != 0) {
+                const std::size_t dist = pos + (size - cand);
+                if (dist > m_window) break;
+                --depth;
+                const D* const ref = b.m_data.data() + cand;
+                const std::size_t split = size - cand; // symboles de la base avant data[0]
+                const auto at = [&](std::size_t k) -> const D& { return k < split ? ref[k] : m_data[k - split]; };
+                if (at(best_len) == cur[best_len]) {
+                    std::size_t len = 0;
+                    const std::size_t head = std::min(avail, split);
+                    while (len < head && ref[len] == cur[len]) ++len;
+                    if (len == split) while (len < avail && m_data[len - split] == cur[len]) ++len;
+                    if (len > best_len) {
+                        best_len = len;
+                        on_better(dist, len);
+                        if (len >= nice_len) break;
+                    }
+                }
+                const std::size_t next = b.m_prev[cand & b.m_mask];
+                if (next >= cand) break;
+                cand = next;
+            }
+        }
+        if constexpr (Stats::enabled) {
+            auto& c = Stats::local().lz77;
+            ++c.searches;
+            c.probes += m_max_chain - depth;
+        }
+        return best_len >= min_match ? best_len : 0;
+    }
+
+    // plus longue correspondance (>= min_match, <= max_len) pour la position pos,
+    // à au plus window_size() symboles en arrière ; elle peut chevaucher pos. La recherche
+    // s'arrête à la première de longueur >= nice_len.
+    [[nodiscard]] std::optional<match_t> find(std::size_t pos, std::size_t max_len, std::size_t nice_len = nil) {
+        match_t best{0, 0};
+        for_each_match(pos, max_len, nice_len, [&](std::size_t off, std::size_t len){ best = {off, len}; });
+        if (best.first == 0) return std::nullopt;
+        return best;
+    }
+};
+
+// find_match : retourne (offset depuis la fin du buffer de recherche, longueur).
+// S'appuie sur MatchFinder (chaînes parcourues en entier) depuis qu'il a remplacé la
+// comparaison de toutes les positions, ce qui change le contrat :
+// - seules les correspondances d'au moins MatchFinder::min_match (3) symboles sont rapportées ;
+// - à longueur égale, la plus proche l'emporte ;
+// - une correspondance peut déborder sur le lookahead (copie chevauchante, gérée par le
+//   décodeur LZ77), elle n'est plus limitée au buffer de recherche.
+// finder garde ses tables d'un appel à l'autre (reconfiguré seulement si la taille du buffer de
+// recherche change) : un appelant qui boucle le fournit. Sans finder, un moteur propre au
+// thread est réutilisé.
 template<typename D>
 [[nodiscard]]
 std::optional<std::pair<std::size_t, std::size_t>>
-find_match(std::span<const D> search_buffer, std::span<const D> lookahead_buffer) {
+find_match(std::span<const D> search_buffer, std::span<const D> lookahead_buffer, MatchFinder<D>& finder) {
     if (search_buffer.empty() || lookahead_buffer.empty()) return std::nullopt;
 
-    std::optional<std::pair<std::size_t, std::size_t>> best_match;
-    std::size_t best_length = 0;
     const std::size_t S = search_buffer.size();
+    std::vector<D> joined;
+    std::span<const D> all;
+    if (search_buffer.data() + S == lookahead_buffer.data()) {
+        all = std::span<const D>(search_buffer.data(), S + lookahead_buffer.size());
+    } else {
+        joined.reserve(S + lookahead_buffer.size());
+        joined.insert(joined.end(), search_buffer.begin(), search_buffer.end());
+        joined.insert(joined.end(), lookahead_buffer.begin(), lookahead_buffer.end());
+        all = joined;
+    }
+
+    if (finder.window_size() != S || finder.max_chain() != S) finder.configure(S, S);
+    finder.set_base(nullptr);
+    finder.reset(all);
+    return finder.find(S, lookahead_buffer.size());
+}
+
+template<typename D>
+[[nodiscard]]
+std::optional<std::pair<std::size_t, std::size_t>>
+find_match(std::span<const D> search_buffer, std::span<const D> lookahead_buffer) {
+    thread_local MatchFinder<D> finder(std::pmr::get_default_resource());
+    return find_match<D>(search_buffer, lookahead_buffer, finder);
+}
+
+// copy_match : recopie length symboles situés offset positions avant dst.
+// Sans recouvrement (offset >= length) : une seule copie large ; offset == 1 : remplissage ;
+// motif court chevauchant : la portion déjà reproduite est doublée à chaque passe.
+template<typename D>
+void copy_match(D* dst, std::size_t offset, std::size_t length) {
+    assert(offset > 0);
+    const D* src = dst - offset;
+    if (offset >= length) { std::copy_n(src, length, dst); return; }
+    if (offset == 1)      { std::fill_n(dst, length, *src); return; }
+    std::size_t done = 0;
+    while (done < length) {
+        const std::size_t n = std::min(done + offset, length - done);
+        std::copy_n(src, n, dst + done);
+        done += n;
+    }
+}
+
+// ===== RingWindow : fenêtre glissante circulaire (taille puissance de deux) =====
+// Utilisée pour décoder LZ77 en flux : seuls les window_size derniers symboles sont
+// conservés, sans jamais décaler la mémoire.
+template<typename D>
+class RingWindow {
+private:
+    std::vector<D> m_buf;
+    std::size_t    m_mask;
+    std::size_t    m_total = 0; // nombre de symboles écrits depuis le début
+
+public:
+    explicit RingWindow(std::size_t window_size)
+        : m_buf(std::bit_ceil(std::max<std::size_t>(window_size, 1))),
+          m_mask(m_buf.size() - 1) {}
+
+    [[nodiscard]] std::size_t capacity() const noexcept { return m_buf.size(); }
+    [[nodiscard]] std::size_t total() const noexcept { return m_total; }
+    [[nodiscard]] std::size_t size() const noexcept { return std::min(m_total, m_buf.size()); }
+
+    void clear() noexcept { m_total = 0; }
+
+    void push(const D& v) { m_buf[m_total++ & m_mask] = v; }
+
+    // recopie (offset, length) depuis la fenêtre et émet les symboles dans out
+    template<typename OutIt>
+    OutIt copy_match(std::size_t offset, std::size_t length, OutIt out) {
+        assert(offset > 0 && offset <= size());
+        const std::size_t cap = m_buf.size();
+        D* const buf = m_buf.data();
+        while (length != 0) {
+            const std::size_t src = (m_total - offset) & m_mask;
+            const std::size_t dst = m_total & m_mask;
+            std::size_t n;
+            if (src < dst) {        // source juste avant dst en mémoire linéaire
+                n = std::min(length, cap - dst);
+                utils::copy_match(buf + dst, offset, n);
+            } else if (src > dst) { // source repliée en fin de tampon
+                n = std::min({length, cap - src, cap - dst});
+                std::copy_n(buf + src, n, buf + dst);
+            } else {                // offset == capacité : les valeurs sont déjà en place
+                n = std::min(length, cap - dst);
+            }
+            out = std::copy_n(buf + dst, n, out);
+            m_total += n;
+            length  -= n;
+        }
+        return out;
+    }
+};
+
+// ===== SymbolMap : association symbole -> valeur =====
+// Tableau plat de 256 cases pour les symboles d'un octet, table de hachage sinon.
+template<typename D, typename V>
+class SymbolMap {
+public:
+    static constexpr bool dense = std::is_integral_v<D> && sizeof(D) == 1;
+
+private:
+    using storage_t = std::conditional_t<dense, std::array<V, 256>, std::pmr::unordered_map<D, V>>;
+    storage_t m_data{};
+
+    [[nodiscard]] static storage_t make_storage([[maybe_unused]] std::pmr::memory_resource* mr) {
+        if constexpr (dense) return storage_t{};
+        else return storage_t(mr);
+    }
+
+public:
+    SymbolMap() = default;
+
+    // mr : mémoire de la table de hachage (ignorée par la version dense)
+    explicit SymbolMap(std::pmr::memory_resource* mr) : m_data(make_storage(mr)) {}
+
+    void clear() noexcept {
+        if constexpr (dense) m_data.fill(V{});
+        else m_data.clear();
+    }
+
+    V& operator[](const D& d) {
+        if constexpr (dense) return m_data[static_cast<unsigned char>(d)];
+        else return m_data[d];
+    }
+
+    // nullptr si le symbole est absent (jamais pour la version dense)
+    [[nodiscard]] const V* find(const D& d) const {
+        if constexpr (dense) return &m_data[static_cast<unsigned char>(d)];
+        else { auto it = m_data.find(d); return it == m_data.end() ? nullptr : &it->second; }
+    }
+};
+
+// lecture / écriture little-endian de 64 bits (accès non alignés)
+[[nodiscard]] inline std::uint64_t load_le64(const std::uint8_t* p) noexcept {
+    std::uint64_t v;
+    if constexpr (std::endian::native == std::endian::little) std::memcpy(&v, p, 8);
+    else { v = 0; for (int i = 7; i >= 0; --i) v = (v << 8) | p[i]; }
+    return v;
+}
+
+inline void store_le64(std::uint8_t* p, std::uint64_t v) noexcept {
+    if constexpr (std::endian::native == std::endian::little) std::memcpy(p, &v, 8);
+    else for (int i = 0; i < 8; ++i) p[i] = static_cast<std::uint8_t>(v >> (8 * i));
+}
+
+// inverse l'ordre des n bits de poids faible de v
+[[nodiscard]] constexpr std::uint32_t reverse_bits(std::uint32_t v, unsigned n) noexcept {
+    std::uint32_t r = 0;
+    for (unsigned i = 0; i < n; ++i) { r = (r << 1) | (v & 1u); v >>= 1; }
+    return r;
+}
+
+// ===== BitWriter : flux de bits compact (bit de poids faible en premier) =====
+// Accumulateur 64 bits ; tant qu'il reste 8 octets dans la sortie, chaque put() écrit
+// l'accumulateur entier puis avance du nombre d'octets complets (pas de branche par bit).
+class BitWriter {
+private:
+    std::uint8_t* m_data;
+    std::size_t   m_size;
+    std::size_t   m_pos      = 0;
+    std::uint64_t m_acc      = 0;
+    unsigned      m_count    = 0;   // bits en attente dans m_acc (< 8 entre deux appels)
+    bool          m_overflow = false;
+
+public:
+    static constexpr unsigned max_put = 56;
 
-    for (std::size_t i = 0; i < S; ++i) {
-        std::size_t length = 0;
-        while (i + length < S &&
-               length < lookahead_buffer.size() &&
-               search_buffer[i + length] == lookahead_buffer[length]) {
-            ++length;
+    explicit BitWriter(std::span<std::uint8_t> out) noexcept
+        : m_data(out.data()), m_size(out.size()) {}
+
+    // écrit les n bits de poids faible de bits (n <= max_put, bits au-delà de n nuls)
+    void put(std::uint64_t bits, unsigned n) noexcept {
+        assert(n <= max_put && (bits >> n) == 0);
+        m_acc   |= bits << m_count;
+        m_count += n;
+        const unsigned nbytes = m_count >> 3;
+        if (m_pos + 8 <= m_size) {
+            store_le64(m_data + m_pos, m_acc);
+        } else {
+            for (unsigned i = 0; i < nbytes; ++i) {
+                if (m_pos + i < m_size) m_data[m_pos + i] = static_cast<std::uint8_t>(m_acc >> (8 * i));
+                else m_overflow = true;
+            }
         }
-        if (length > best_length) {
-            best_length = length;
-            const std::size_t offset = S - i;
-            best_match = std::make_pair(offset, length);
+        m_pos   += nbytes;
+        m_acc  >>= 8 * nbytes;
+        m_count &= 7;
+    }
+
+    // vide l'octet partiel ; renvoie le nombre d'octets produits
+    std::size_t finish() noexcept {
+        if (m_count != 0) {
+            if (m_pos < m_size) m_data[m_pos] = static_cast<std::uint8_t>(m_acc);
+            else m_overflow = true;
+            ++m_pos; m_acc = 0; m_count = 0;
         }
+        return m_pos;
+    }
+
+    [[nodiscard]] std::size_t bit_count() const noexcept { return m_pos * 8 + m_count; }
+    [[nodiscard]] bool overflow() const noexcept { return m_overflow; }
+};
+
+// ===== BitReader : lecture du flux produit par BitWriter =====
+// refill() garantit au moins 56 bits disponibles ; au-delà de la fin, des zéros sont lus
+// (overrun() permet de le détecter).
+class BitReader {
+private:
+    const std::uint8_t* m_data;
+    std::size_t         m_size;
+    std::size_t         m_pos      = 0;  // octet aligné sur le bit m_count de m_acc
+    std::uint64_t       m_acc      = 0;
+    unsigned            m_count    = 0;
+    std::size_t         m_consumed = 0;
+
+public:
+    explicit BitReader(std::span<const std::uint8_t> in) noexcept
+        : m_data(in.data()), m_size(in.size()) {}
+
+    void refill() noexcept {
+        if (m_pos + 8 <= m_size) {
+            m_acc   |= load_le64(m_data + m_pos) << m_count;
+            m_pos   += (63 - m_count) >> 3;
+            m_count |= 56;
+        } else {
+            while (m_count <= 56) {
+                if (m_pos < m_size) m_acc |= static_cast<std::uint64_t>(m_data[m_pos]) << m_count;
+                ++m_pos;
+                m_count += 8;
+            }
+        }
+    }
+
+    // n <= 56, après refill()
+    [[nodiscard]] std::uint64_t peek(unsigned n) const noexcept {
+        assert(n <= m_count);
+        return m_acc & ((std::uint64_t{1} << n) - 1);
+    }
+
+    void consume(unsigned n) noexcept {
+        assert(n <= m_count);
+        m_acc >>= n; m_count -= n; m_consumed += n;
+    }
+
+    [[nodiscard]] std::uint64_t read(unsigned n) noexcept {
+        if (m_count < n) refill();
+        const auto v = peek(n);
+        consume(n);
+        return v;
+    }
+
+    [[nodiscard]] unsigned bits_available() const noexcept { return m_count; }
+    [[nodiscard]] std::size_t bits_consumed() const noexcept { return m_consumed; }
+    [[nodiscard]] bool overrun() const noexcept { return m_consumed > m_size * 8; }
+};
+
+// ===== Entiers de taille variable (LEB128 non signé) =====
+inline constexpr std::size_t max_varint_size = 10;
+
+template<typename Alloc>
+void put_varint(std::vector<std::uint8_t, Alloc>& out, std::uint64_t v) {
+    while (v >= 0x80) { out.push_back(static_cast<std::uint8_t>(v | 0x80)); v >>= 7; }
+    out.push_back(static_cast<std::uint8_t>(v));
+}
+
+// écrit dans p (au moins max_varint_size octets disponibles) ; renvoie la fin
+inline std::uint8_t* put_varint(std::uint8_t* p, std::uint64_t v) noexcept {
+    while (v >= 0x80) { *p++ = static_cast<std::uint8_t>(v | 0x80); v >>= 7; }
+    *p++ = static_cast<std::uint8_t>(v);
+    return p;
+}
+
+// lit un entier en avançant p ; nullopt si le flux est tronqué ou l'entier trop long
+[[nodiscard]] inline std::optional<std::uint64_t> get_varint(const std::uint8_t*& p, const std::uint8_t* end) noexcept {
+    std::uint64_t v = 0;
+    for (unsigned shift = 0; shift < 64 && p != end; shift += 7) {
+        const std::uint8_t b = *p++;
+        v |= static_cast<std::uint64_t>(b & 0x7F) << shift;
+        if (!(b & 0x80)) return v;
+    }
+    return std::nullopt;
+}
+
+// zigzag : entiers signés -> non signés petits pour les petites valeurs absolues
+[[nodiscard]] constexpr std::uint64_t zigzag_encode(std::int64_t v) noexcept {
+    return (static_cast<std::uint64_t>(v) << 1) ^ static_cast<std::uint64_t>(v >> 63);
+}
+
+[[nodiscard]] constexpr std::int64_t zigzag_decode(std::uint64_t v) noexcept {
+    return static_cast<std::int64_t>(v >> 1) ^ -static_cast<std::int64_t>(v & 1);
+}
+
+// ===== CRC-32 (polynôme IEEE réfléchi, découpage par 8 octets) =====
+namespace detail {
+    inline constexpr auto crc32_tables = [] {
+        std::array<std::array<std::uint32_t, 256>, 8> t{};
+        for (std::uint32_t i = 0; i < 256; ++i) {
+            std::uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = (c >> 1) ^ (0xEDB88320u & (0u - (c & 1u)));
+            t[0][i] = c;
+        }
+        for (std::size_t i = 0; i < 256; ++i)
+            for (std::size_t s = 1; s < 8; ++s) t[s][i] = (t[s - 1][i] >> 8) ^ t[0][t[s - 1][i] & 0xFF];
+        return t;
+    }();
+} // namespace detail
+
+// crc : valeur renvoyée par un appel précédent, pour chaîner les morceaux
+[[nodiscard]] inline std::uint32_t crc32(std::span<const std::uint8_t> data, std::uint32_t crc = 0) noexcept {
+    const auto& t = detail::crc32_tables;
+    const std::uint8_t* p = data.data();
+    std::size_t n = data.size();
+    crc = ~crc;
+    for (; n >= 8; p += 8, n -= 8) {
+        const std::uint64_t v = load_le64(p) ^ crc;
+        crc = t[7][v & 0xFF]         ^ t[6][(v >> 8) & 0xFF]  ^ t[5][(v >> 16) & 0xFF] ^ t[4][(v >> 24) & 0xFF]
+            ^ t[3][(v >> 32) & 0xFF] ^ t[2][(v >> 40) & 0xFF] ^ t[1][(v >> 48) & 0xFF] ^ t[0][v >> 56];
+    }
+    for (; n != 0; ++p, --n) crc = (crc >> 8) ^ t[0][(crc ^ *p) & 0xFF];
+    return ~crc;
+}
+
+// ===== Jeu d'instructions SIMD disponible (détecté une fois) =====
+enum class simd_level { scalar, sse41, avx2 };
+
+[[nodiscard]] inline simd_level simd_support() noexcept {
+#ifdef ENCODING_X86_SIMD
+    static const simd_level level = [] {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))   return simd_level::avx2;
+        if (__builtin_cpu_supports("sse4.1")) return simd_level::sse41;
+        return simd_level::scalar;
+    }();
+    return level;
+#else
+    return simd_level::scalar;
+#endif
+}
+
+// ===== Détection de plages (comparaison par représentation binaire) =====
+// Les symboles de 1, 2, 4 ou 8 octets sont comparés par blocs de 16 / 32 octets
+// (cmpeq + movemask) ; les autres tailles par memcmp, un symbole à la fois.
+namespace detail {
+    // bit de l'octet de tête de chaque symbole dont les S octets sont égaux
+    template<std::size_t S>
+    [[nodiscard]] constexpr std::uint32_t symbol_mask(std::uint32_t m) noexcept {
+        if constexpr (S == 1) return m;
+        else {
+            std::uint32_t e = m;
+            for (std::size_t s = 1; s < S; ++s) e &= m >> s;
+            constexpr std::uint32_t heads = S == 2 ? 0x55555555u : S == 4 ? 0x11111111u : 0x01010101u;
+            return e & heads;
+        }
+    }
+
+#ifdef ENCODING_X86_SIMD
+    // symbole de S octets en p répété sur tout le registre
+    template<std::size_t S>
+    __attribute__((target("avx2")))
+    __m256i broadcast_avx2(const std::uint8_t* p) noexcept {
+        if constexpr (S == 1) return _mm256_set1_epi8(static_cast<char>(*p));
+        else if constexpr (S == 2) { std::int16_t v; std::memcpy(&v, p, 2); return _mm256_set1_epi16(v); }
+        else if constexpr (S == 4) { std::int32_t v; std::memcpy(&v, p, 4); return _mm256_set1_epi32(v); }
+        else { long long v; std::memcpy(&v, p, 8); return _mm256_set1_epi64x(v); }
+    }
+
+    template<std::size_t S>
+    __attribute__((target("sse2")))
+    __m128i broadcast_sse2(const std::uint8_t* p) noexcept {
+        if constexpr (S == 1) return _mm_set1_epi8(static_cast<char>(*p));
+        else if constexpr (S == 2) { std::int16_t v; std::memcpy(&v, p, 2); return _mm_set1_epi16(v); }
+        else if constexpr (S == 4) { std::int32_t v; std::memcpy(&v, p, 4); return _mm_set1_epi32(v); }
+        else { long long v; std::memcpy(&v, p, 8); return _mm_set1_epi64x(v); }
+    }
+
+    // Equal == false : premier octet différent du symbole sym répété ;
+    // Equal == true  : premier symbole (octet de tête) égal à sym ; sinon pos = nombre d'octets examinés
+    template<std::size_t S, bool Equal>
+    __attribute__((target("avx2")))
+    bool scan_avx2(const std::uint8_t* p, std::size_t nbytes, const std::uint8_t* sym, std::size_t& pos) noexcept {
+        const __m256i v = broadcast_avx2<S>(sym);
+        std::size_t i = 0;
+        for (; i + 32 <= nbytes; i += 32) {
+            const auto eq = static_cast<std::uint32_t>(_mm256_movemask_epi8(
+                _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i)), v)));
+            const std::uint32_t m = Equal ? symbol_mask<S>(eq) : ~eq;
+            if (m) { pos = i + static_cast<std::size_t>(std::countr_zero(m)); return true; }
+        }
+        pos = i;
+        return false;
+    }
+
+    template<std::size_t S, bool Equal>
+    __attribute__((target("sse2")))
+    bool scan_sse2(const std::uint8_t* p, std::size_t nbytes, const std::uint8_t* sym, std::size_t& pos) noexcept {
+        const __m128i v = broadcast_sse2<S>(sym);
+        std::size_t i = 0;
+        for (; i + 16 <= nbytes; i += 16) {
+            const auto eq = static_cast<std::uint32_t>(_mm_movemask_epi8(
+                _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i)), v)));
+            const std::uint32_t m = Equal ? symbol_mask<S>(eq) : ~eq & 0xFFFFu;
+            if (m) { pos = i + static_cast<std::size_t>(std::countr_zero(m)); return true; }
+        }
+        pos = i;
+        return false;
+    }
+
+    // premier octet de tête d'un symbole suivi de deux copies de lui-même ; sinon pos = octets examinés
+    template<std::size_t S>
+    __attribute__((target("avx2")))
+    bool triple_avx2(const std::uint8_t* p, std::size_t nbytes, std::size_t& pos) noexcept {
+        std::size_t i = 0;
+        for (; i + 32 + 2 * S <= nbytes; i += 32) {
+            const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+            const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i + S));
+            const __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i + 2 * S));
+            const auto m = symbol_mask<S>(static_cast<std::uint32_t>(_mm256_movemask_epi8(
+                _mm256_and_si256(_mm256_cmpeq_epi8(a, b), _mm256_cmpeq_epi8(b, c)))));
+            if (m) { pos = i + static_cast<std::size_t>(std::countr_zero(m)); return true; }
+        }
+        pos = i;
+        return false;
+    }
+
+    template<std::size_t S>
+    __attribute__((target("sse2")))
+    bool triple_sse2(const std::uint8_t* p, std::size_t nbytes, std::size_t& pos) noexcept {
+        std::size_t i = 0;
+        for (; i + 16 + 2 * S <= nbytes; i += 16) {
+            const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+            const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i + S));
+            const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i + 2 * S));
+            const auto m = symbol_mask<S>(static_cast<std::uint32_t>(_mm_movemask_epi8(
+                _mm_and_si128(_mm_cmpeq_epi8(a, b), _mm_cmpeq_epi8(b, c)))));
+            if (m) { pos = i + static_cast<std::size_t>(std::countr_zero(m)); return true; }
+        }
+        pos = i;
+        return false;
+    }
+#endif
+
+    template<typename D>
+    [[nodiscard]] inline bool same_bits(const D& a, const D& b) noexcept {
+        return std::memcmp(&a, &b, sizeof(D)) == 0;
+    }
+} // namespace detail
+
+// nombre de symboles identiques à p[0] en tête de p[0..n) (0 si n == 0)
+template<typename D>
+requires std::is_trivially_copyable_v<D>
+[[nodiscard]] std::size_t equal_run(const D* p, std::size_t n) noexcept {
+    if (n == 0) return 0;
+    constexpr std::size_t S = sizeof(D);
+    std::size_t i = 1;
+#ifdef ENCODING_X86_SIMD
+    if constexpr (S == 1 || S == 2 || S == 4 || S == 8) {
+        const auto* bytes = reinterpret_cast<const std::uint8_t*>(p);
+        std::size_t pos = 0;
+        const bool found = simd_support() == simd_level::avx2 ? detail::scan_avx2<S, false>(bytes, n * S, bytes, pos)
+                                                              : detail::scan_sse2<S, false>(bytes, n * S, bytes, pos);
+        if (found) return pos / S;
+        i = std::max<std::size_t>(pos / S, 1);
+    }
+#endif
+    while (i < n && detail::same_bits(p[i], p[0])) ++i;
+    return i;
+}
+
+// premier indice i tel que p[i] == v ; n s'il n'y en a pas
+template<typename D>
+requires std::is_trivially_copyable_v<D>
+[[nodiscard]] std::size_t find_equal(const D* p, std::size_t n, const D& v) noexcept {
+    constexpr std::size_t S = sizeof(D);
+    std::size_t i = 0;
+#ifdef ENCODING_X86_SIMD
+    if constexpr (S == 1 || S == 2 || S == 4 || S == 8) {
+        const auto* bytes = reinterpret_cast<const std::uint8_t*>(p);
+        const auto* sym = reinterpret_cast<const std::uint8_t*>(&v);
+        std::size_t pos = 0;
+        const bool found = simd_support() == simd_level::avx2 ? detail::scan_avx2<S, true>(bytes, n * S, sym, pos)
+                                                              : detail::scan_sse2<S, true>(bytes, n * S, sym, pos);
+        if (found) return pos / S;
+        i = pos / S;
+    }
+#endif
+    while (i < n && !detail::same_bits(p[i], v)) ++i;
+    return i;
+}
+
+// premier indice i tel que p[i] == p[i + 1] == p[i + 2] ; n s'il n'y en a pas
+template<typename D>
+requires std::is_trivially_copyable_v<D>
+[[nodiscard]] std::size_t find_triple(const D* p, std::size_t n) noexcept {
+    if (n < 3) return n;
+    constexpr std::size_t S = sizeof(D);
+    std::size_t i = 0;
+#ifdef ENCODING_X86_SIMD
+    if constexpr (S == 1 || S == 2 || S == 4 || S == 8) {
+        const auto* bytes = reinterpret_cast<const std::uint8_t*>(p);
+        std::size_t pos = 0;
+        const bool found = simd_support() == simd_level::avx2 ? detail::triple_avx2<S>(bytes, n * S, pos)
+                                                              : detail::triple_sse2<S>(bytes, n * S, pos);
+        if (found) return pos / S;
+        i = pos / S;
     }
-    return best_match;
+#endif
+    for (; i + 2 < n; ++i)
+        if (detail::same_bits(p[i], p[i + 1]) && detail::same_bits(p[i + 1], p[i + 2])) return i;
+    return n;
 }
 
 // vector_shift : fait glisser la fenêtre et ajoute les 'length' 1ers éléments de source